@@ -0,0 +1,24 @@
+#include "ArrivalQueue.h"
+
+ArrivalQueue::ArrivalQueue() : head(nullptr) {}
+
+void ArrivalQueue::push(Vehicle* v) {
+    Vehicle* old = head.load(memory_order_relaxed);
+    do {
+        v->arrivalLink = old;
+    } while (!head.compare_exchange_weak(old, v, memory_order_release, memory_order_relaxed));
+}
+
+Vehicle* ArrivalQueue::drain() {
+    Vehicle* v = head.exchange(nullptr, memory_order_acquire);
+
+    // The stack holds newest first; reverse it into arrival order.
+    Vehicle* ordered = nullptr;
+    while (v) {
+        Vehicle* next = v->arrivalLink;
+        v->arrivalLink = ordered;
+        ordered = v;
+        v = next;
+    }
+    return ordered;
+}
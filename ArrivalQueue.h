@@ -0,0 +1,37 @@
+#ifndef ARRIVAL_QUEUE_H
+#define ARRIVAL_QUEUE_H
+
+#include <atomic>
+#include "Vehicle.h"
+
+using namespace std;
+
+// Lock-free multi-producer/single-consumer queue of arriving vehicles.
+// Producers push with one CAS; the consumer takes everything at once with
+// a single exchange and gets the batch back in arrival order. Links are
+// stored in the vehicles themselves, so pushing never allocates.
+//
+// A vehicle may be in at most one ArrivalQueue at a time.
+class ArrivalQueue {
+    atomic<Vehicle*> head; // most recent arrival first
+
+public:
+    ArrivalQueue();
+
+    ArrivalQueue(const ArrivalQueue&) = delete;
+    ArrivalQueue& operator=(const ArrivalQueue&) = delete;
+
+    // Safe from any number of threads concurrently.
+    void push(Vehicle* v);
+
+    // Take all queued vehicles, oldest first, as a list linked through
+    // next(). Only one thread may drain at a time.
+    Vehicle* drain();
+
+    // Successor of v in a drained list.
+    static Vehicle* next(const Vehicle* v) { return v->arrivalLink; }
+
+    bool empty() const { return head.load(memory_order_acquire) == nullptr; }
+};
+
+#endif
@@ -0,0 +1,392 @@
+#include "Columns.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "Intersection.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+atomic<bool> ColumnWriter::on(false);
+
+namespace {
+
+const size_t FLUSH_ROWS = 64 * 1024;
+
+// Every column of every table, in file order. Shared by writer and reader.
+enum ColumnIndex {
+    A_VEHICLE, A_TIME, A_SITE, A_LANE, A_TYPE,
+    C_VEHICLE, C_TIME, C_SITE, C_LANE, C_WAIT, C_TYPE,
+    P_VEHICLE, P_TIME, P_SITE, P_EVENT, P_PARKED,
+    COLUMN_COUNT
+};
+
+struct ColumnSpec {
+    const char* file;
+    size_t width;
+};
+
+const ColumnSpec COLUMNS[COLUMN_COUNT] = {
+    {"arrivals.vehicle", 4}, {"arrivals.time_ms", 8}, {"arrivals.site", 2},
+    {"arrivals.lane", 1}, {"arrivals.type", 1},
+    {"crossings.vehicle", 4}, {"crossings.time_ms", 8}, {"crossings.site", 2},
+    {"crossings.lane", 1}, {"crossings.wait_ms", 4}, {"crossings.type", 1},
+    {"parking.vehicle", 4}, {"parking.time_ms", 8}, {"parking.site", 2},
+    {"parking.event", 1}, {"parking.parked", 2},
+};
+
+// First and one-past-last column of each table.
+struct TableSpec {
+    int first;
+    int end;
+};
+
+const TableSpec ARRIVALS = {A_VEHICLE, C_VEHICLE};
+const TableSpec CROSSINGS = {C_VEHICLE, P_VEHICLE};
+const TableSpec PARKING = {P_VEHICLE, COLUMN_COUNT};
+
+string pathOf(const string &dir, const char* file) {
+    return dir + "/" + file;
+}
+
+uint64_t monotonicMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000ull + ts.tv_nsec / 1000000;
+}
+
+thread_local long threadTime = -1;
+
+// Writer state, all under writerMtx.
+mutex writerMtx;
+string directory;
+int fds[COLUMN_COUNT];
+vector<char> buffers[COLUMN_COUNT];
+size_t pendingRows[3];
+uint64_t startMs;
+vector<int> siteOfName;        // NameTable id -> site index, or -1
+vector<ColumnSite> siteList;
+unsigned long rowCount = 0;
+bool writing = false;
+
+template <typename T>
+void put(int column, T value) {
+    const char* p = reinterpret_cast<const char*>(&value);
+    buffers[column].insert(buffers[column].end(), p, p + sizeof(T));
+}
+
+void closeFiles() {
+    for (int &fd : fds) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    writing = false;
+}
+
+void writeColumn(int column) {
+    const char* p = buffers[column].data();
+    size_t left = buffers[column].size();
+    while (left > 0 && writing) {
+        ssize_t n = write(fds[column], p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            cout << "[Columns] Write to " << pathOf(directory, COLUMNS[column].file) << " failed: "
+                 << strerror(errno) << "; column output stopped" << endl;
+            closeFiles(); // every row function checks `writing` under the lock
+            break;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    buffers[column].clear();
+}
+
+void writeSites() {
+    ofstream out(pathOf(directory, "sites"), ios::trunc);
+    for (size_t i = 0; i < siteList.size(); ++i) {
+        out << i << " " << siteList[i].name << " " << siteList[i].capacity << "\n";
+    }
+}
+
+void writeTable(const TableSpec &t, size_t &rows) {
+    for (int c = t.first; c < t.end; ++c) {
+        writeColumn(c);
+    }
+    rows = 0;
+}
+
+// Count a row of `t`, writing the table out every FLUSH_ROWS rows.
+void endRow(const TableSpec &t, size_t &rows) {
+    ++rowCount;
+    if (++rows >= FLUSH_ROWS) {
+        writeTable(t, rows);
+        writeSites(); // so a run cut short still names its sites
+    }
+}
+
+uint16_t siteIndex(uint32_t nameId, int capacity) {
+    if (nameId >= siteOfName.size()) {
+        siteOfName.resize(nameId + 1, -1);
+    }
+    int &index = siteOfName[nameId];
+    if (index < 0) {
+        index = static_cast<int>(siteList.size());
+        siteList.push_back(ColumnSite{NameTable::name(nameId), 0});
+    }
+    if (capacity > 0) {
+        siteList[index].capacity = capacity;
+    }
+    return static_cast<uint16_t>(index);
+}
+
+int64_t rowTime() {
+    return threadTime >= 0 ? threadTime : static_cast<int64_t>(monotonicMs() - startMs);
+}
+
+bool parkingEventOf(LogEvent e, ParkingColumnEvent &out) {
+    switch (e) {
+    case LogEvent::WAITING_RESERVED: out = ParkingColumnEvent::RESERVED;    return true;
+    case LogEvent::WAITING_FULL:     out = ParkingColumnEvent::TURNED_AWAY; return true;
+    case LogEvent::SPOT_ACQUIRED:    out = ParkingColumnEvent::PARKED;      return true;
+    case LogEvent::SPOT_UNAVAILABLE: out = ParkingColumnEvent::NO_SPOT;     return true;
+    case LogEvent::WAITING_RELEASED: out = ParkingColumnEvent::GAVE_UP;     return true;
+    case LogEvent::PARKING_LEFT:     out = ParkingColumnEvent::LEFT;        return true;
+    default:                         return false;
+    }
+}
+
+} // namespace
+
+bool ColumnWriter::start(const string &dir) {
+    if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+        cout << "[Columns] Cannot create " << dir << ": " << strerror(errno) << endl;
+        return false;
+    }
+    int opened[COLUMN_COUNT];
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        string path = pathOf(dir, COLUMNS[c].file);
+        opened[c] = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (opened[c] < 0) {
+            cout << "[Columns] Cannot open " << path << ": " << strerror(errno) << endl;
+            for (int i = 0; i < c; ++i) {
+                ::close(opened[i]);
+            }
+            return false;
+        }
+    }
+    stop();
+
+    lock_guard<mutex> lock(writerMtx);
+    directory = dir;
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        fds[c] = opened[c];
+        buffers[c].clear();
+        buffers[c].reserve(FLUSH_ROWS * COLUMNS[c].width);
+    }
+    pendingRows[0] = pendingRows[1] = pendingRows[2] = 0;
+    startMs = monotonicMs();
+    siteOfName.clear();
+    siteList.clear();
+    rowCount = 0;
+    writing = true;
+    on.store(true);
+    return true;
+}
+
+void ColumnWriter::stop() {
+    on.store(false);
+    lock_guard<mutex> lock(writerMtx);
+    if (!writing) {
+        return;
+    }
+    writeTable(ARRIVALS, pendingRows[0]);
+    writeTable(CROSSINGS, pendingRows[1]);
+    writeTable(PARKING, pendingRows[2]);
+    writeSites();
+    closeFiles();
+}
+
+void ColumnWriter::setTime(long ms) {
+    threadTime = ms;
+}
+
+void ColumnWriter::arrival(const Vehicle* v, Direction lane) {
+    lock_guard<mutex> lock(writerMtx);
+    if (!writing) {
+        return;
+    }
+    put<int32_t>(A_VEHICLE, v->getId());
+    put<int64_t>(A_TIME, rowTime());
+    put<uint16_t>(A_SITE, siteIndex(v->getOriginId(), 0));
+    put<uint8_t>(A_LANE, static_cast<uint8_t>(directionIndex(lane)));
+    put<uint8_t>(A_TYPE, static_cast<uint8_t>(v->getVehicleType()));
+    endRow(ARRIVALS, pendingRows[0]);
+}
+
+void ColumnWriter::crossing(const Vehicle* v, Direction lane, long waitMs) {
+    lock_guard<mutex> lock(writerMtx);
+    if (!writing) {
+        return;
+    }
+    put<int32_t>(C_VEHICLE, v->getId());
+    put<int64_t>(C_TIME, rowTime());
+    put<uint16_t>(C_SITE, siteIndex(v->getOriginId(), 0));
+    put<uint8_t>(C_LANE, static_cast<uint8_t>(directionIndex(lane)));
+    put<int32_t>(C_WAIT, static_cast<int32_t>(waitMs));
+    put<uint8_t>(C_TYPE, static_cast<uint8_t>(v->getVehicleType()));
+    endRow(CROSSINGS, pendingRows[1]);
+}
+
+void ColumnWriter::parking(LogEvent e, const string &lot, int capacity, int parked, const Vehicle* v) {
+    ParkingColumnEvent event;
+    if (!parkingEventOf(e, event)) {
+        return;
+    }
+    uint32_t lotName = NameTable::intern(lot);
+    lock_guard<mutex> lock(writerMtx);
+    if (!writing) {
+        return;
+    }
+    put<int32_t>(P_VEHICLE, v ? v->getId() : -1);
+    put<int64_t>(P_TIME, rowTime());
+    put<uint16_t>(P_SITE, siteIndex(lotName, capacity));
+    put<uint8_t>(P_EVENT, static_cast<uint8_t>(event));
+    put<uint16_t>(P_PARKED, static_cast<uint16_t>(parked));
+    endRow(PARKING, pendingRows[2]);
+}
+
+unsigned long ColumnWriter::rows() {
+    lock_guard<mutex> lock(writerMtx);
+    return rowCount;
+}
+
+ColumnSet::ColumnSet()
+    : totalBytes(0), uneven(false), arrivals(), crossings(), parking() {}
+
+ColumnSet::~ColumnSet() {
+    close();
+}
+
+const void* ColumnSet::map(const string &dir, const char* file, size_t width, size_t &rows) {
+    string path = pathOf(dir, file);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        cout << "[Columns] Cannot open " << path << ": " << strerror(errno) << endl;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        cout << "[Columns] Cannot stat " << path << ": " << strerror(errno) << endl;
+        ::close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    rows = size / width;
+    uneven = uneven || size % width != 0;
+    if (size == 0) {
+        ::close(fd);
+        static const uint64_t none = 0;
+        return &none; // valid for zero rows
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        cout << "[Columns] Cannot map " << path << ": " << strerror(errno) << endl;
+        return nullptr;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    mappings.push_back(Mapping{data, size});
+    totalBytes += size;
+    return data;
+}
+
+bool ColumnSet::open(const string &dir) {
+    close();
+
+    const void* data[COLUMN_COUNT];
+    size_t rows[COLUMN_COUNT];
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        data[c] = map(dir, COLUMNS[c].file, COLUMNS[c].width, rows[c]);
+        if (!data[c]) {
+            close();
+            return false;
+        }
+    }
+
+    ifstream in(pathOf(dir, "sites"));
+    if (!in) {
+        cout << "[Columns] Cannot open " << pathOf(dir, "sites") << endl;
+        close();
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        size_t index;
+        ColumnSite site;
+        if (fields >> index >> site.name >> site.capacity && index < 65536) {
+            if (index >= siteList.size()) {
+                siteList.resize(index + 1);
+            }
+            siteList[index] = site;
+        }
+    }
+
+    // A table has as many rows as its shortest column.
+    const TableSpec tables[3] = {ARRIVALS, CROSSINGS, PARKING};
+    size_t tableRows[3];
+    for (int t = 0; t < 3; ++t) {
+        tableRows[t] = rows[tables[t].first];
+        for (int c = tables[t].first; c < tables[t].end; ++c) {
+            uneven = uneven || rows[c] != tableRows[t];
+            tableRows[t] = min(tableRows[t], rows[c]);
+        }
+    }
+
+    arrivals.rows = tableRows[0];
+    arrivals.vehicle = static_cast<const int32_t*>(data[A_VEHICLE]);
+    arrivals.timeMs = static_cast<const int64_t*>(data[A_TIME]);
+    arrivals.site = static_cast<const uint16_t*>(data[A_SITE]);
+    arrivals.lane = static_cast<const uint8_t*>(data[A_LANE]);
+    arrivals.type = static_cast<const uint8_t*>(data[A_TYPE]);
+
+    crossings.rows = tableRows[1];
+    crossings.vehicle = static_cast<const int32_t*>(data[C_VEHICLE]);
+    crossings.timeMs = static_cast<const int64_t*>(data[C_TIME]);
+    crossings.site = static_cast<const uint16_t*>(data[C_SITE]);
+    crossings.lane = static_cast<const uint8_t*>(data[C_LANE]);
+    crossings.waitMs = static_cast<const int32_t*>(data[C_WAIT]);
+    crossings.type = static_cast<const uint8_t*>(data[C_TYPE]);
+
+    parking.rows = tableRows[2];
+    parking.vehicle = static_cast<const int32_t*>(data[P_VEHICLE]);
+    parking.timeMs = static_cast<const int64_t*>(data[P_TIME]);
+    parking.site = static_cast<const uint16_t*>(data[P_SITE]);
+    parking.event = static_cast<const uint8_t*>(data[P_EVENT]);
+    parking.parked = static_cast<const uint16_t*>(data[P_PARKED]);
+    return true;
+}
+
+void ColumnSet::close() {
+    for (const Mapping &m : mappings) {
+        munmap(m.data, m.size);
+    }
+    mappings.clear();
+    siteList.clear();
+    totalBytes = 0;
+    uneven = false;
+    arrivals = ArrivalColumns();
+    crossings = CrossingColumns();
+    parking = ParkingColumns();
+}
@@ -0,0 +1,148 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "Log.h"
+
+using namespace std;
+
+class Vehicle;
+enum class Direction : uint8_t;
+
+// What a parking row records. The values are part of the file format: add
+// new events at the end.
+enum class ParkingColumnEvent : uint8_t {
+    RESERVED,     // took a waiting slot
+    TURNED_AWAY,  // waiting area full
+    PARKED,       // took a spot
+    NO_SPOT,      // every spot taken, still waiting
+    GAVE_UP,      // gave back the waiting slot without parking
+    LEFT          // left its spot
+};
+
+// Process-wide writer of simulation events as columns: one file per field
+// of each event table, each a plain array of little-endian fixed-width
+// values, so a reader can map a column and scan it without decoding.
+//
+//   arrivals.{vehicle,time_ms,site,lane,type}         a vehicle queued at its approach
+//   crossings.{vehicle,time_ms,site,lane,wait_ms,type} a vehicle released by the controller
+//   parking.{vehicle,time_ms,site,event,parked}       a parking lot event, `parked` after it
+//
+// vehicle and wait_ms are int32, time_ms int64, site and parked uint16,
+// lane (Direction index), type (VehicleType) and event (ParkingColumnEvent)
+// uint8. `sites` lists one intersection or lot per line as "index name
+// capacity" (capacity 0 for an intersection without parking rows).
+//
+// Rows are stamped with the time set by setTime on the writing thread
+// (virtual time in discrete-event runs) or else wall-clock ms since
+// start(). Writers serialize on one mutex and each table is written every
+// 64K rows; like Recorder, a fork()ed process must start its own writer.
+class ColumnWriter {
+public:
+    // Create `dir` if needed, truncate its column files and start writing.
+    // Returns false (and prints why) if a file cannot be opened. Replaces a
+    // running writer.
+    static bool start(const string &dir);
+
+    // Write out what is buffered, the site list, and close the files.
+    static void stop();
+
+    // Off (and one load per call site) until started.
+    static bool enabled() { return on.load(memory_order_relaxed); }
+
+    // Stamp this thread's rows with `ms` from now on.
+    static void setTime(long ms);
+
+    // Use these behind `if (ColumnWriter::enabled())`.
+    static void arrival(const Vehicle* v, Direction lane);
+    static void crossing(const Vehicle* v, Direction lane, long waitMs);
+    static void parking(LogEvent e, const string &lot, int capacity, int parked, const Vehicle* v);
+
+    // Rows written by the current or last writer.
+    static unsigned long rows();
+
+private:
+    static atomic<bool> on;
+};
+
+// The columns of one table as mapped by ColumnSet. Every pointer covers
+// `rows` values.
+struct ArrivalColumns {
+    size_t rows;
+    const int32_t* vehicle;
+    const int64_t* timeMs;
+    const uint16_t* site;
+    const uint8_t* lane;
+    const uint8_t* type;
+};
+
+struct CrossingColumns {
+    size_t rows;
+    const int32_t* vehicle;
+    const int64_t* timeMs;
+    const uint16_t* site;
+    const uint8_t* lane;
+    const int32_t* waitMs;
+    const uint8_t* type;
+};
+
+struct ParkingColumns {
+    size_t rows;
+    const int32_t* vehicle;
+    const int64_t* timeMs;
+    const uint16_t* site;
+    const uint8_t* event;
+    const uint16_t* parked;
+};
+
+struct ColumnSite {
+    string name;
+    int capacity;
+};
+
+// Read-only mappings of the column files ColumnWriter wrote to one
+// directory. A table whose columns differ in length (a run cut short) is
+// read up to the shortest one.
+class ColumnSet {
+    struct Mapping {
+        void* data;
+        size_t size;
+    };
+    vector<Mapping> mappings;
+    vector<ColumnSite> siteList;
+    size_t totalBytes;
+    bool uneven;
+
+    const void* map(const string &dir, const char* file, size_t width, size_t &rows);
+
+public:
+    ArrivalColumns arrivals;
+    CrossingColumns crossings;
+    ParkingColumns parking;
+
+    ColumnSet();
+    ~ColumnSet();
+
+    ColumnSet(const ColumnSet&) = delete;
+    ColumnSet& operator=(const ColumnSet&) = delete;
+
+    // Map every column in `dir`. Returns false (and prints why) if a column
+    // or the site list is missing.
+    bool open(const string &dir);
+    void close();
+
+    // By site index. A run cut short may have rows for sites past the end.
+    const vector<ColumnSite>& sites() const { return siteList; }
+
+    // True if some table's columns had different lengths.
+    bool unevenTail() const { return uneven; }
+    size_t bytes() const { return totalBytes; }
+};
+
+#endif
@@ -0,0 +1,222 @@
+#include "ControllerChannel.h"
+#include "Metrics.h"
+#include "Recording.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+static void setNonBlocking(int fd) {
+    if (fd < 0) {
+        return;
+    }
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags != -1) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+static uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+ControllerChannel::ControllerChannel(int rfd, int wfd)
+    : readFd(rfd),
+      writeFd(wfd),
+      txFailed(false),
+      sentMessages(0),
+      sentFrames(0),
+      rxClosed(rfd < 0) {
+    setNonBlocking(readFd);
+    setNonBlocking(writeFd);
+    txQueue.reserve(MAX_BATCH);
+}
+
+bool ControllerChannel::send(const ControllerMessage &msg) {
+    lock_guard<mutex> lock(txMtx);
+    if (txFailed || writeFd < 0) {
+        return false;
+    }
+    txQueue.push_back(msg);
+    txQueue.back().sentAtNs = monotonicNs();
+    Metrics::count(MetricCounter::MESSAGES_SENT);
+    if (Recorder::enabled()) {
+        Recorder::message(RecordKind::MESSAGE_SENT, msg);
+    }
+    if (txQueue.size() < MAX_BATCH) {
+        return true;
+    }
+    return flushLocked();
+}
+
+bool ControllerChannel::flush() {
+    lock_guard<mutex> lock(txMtx);
+    return flushLocked();
+}
+
+bool ControllerChannel::flushLocked() {
+    if (txFailed) {
+        return false;
+    }
+    if (txQueue.empty()) {
+        return true;
+    }
+
+    uint32_t count = static_cast<uint32_t>(txQueue.size());
+    bool ok = writeAll(reinterpret_cast<const uint8_t*>(&count), sizeof(count),
+                       reinterpret_cast<const uint8_t*>(txQueue.data()),
+                       txQueue.size() * sizeof(ControllerMessage));
+    sentMessages += count;
+    ++sentFrames;
+    txQueue.clear();
+    txFailed = !ok;
+    return ok;
+}
+
+void ControllerChannel::closeSend() {
+    lock_guard<mutex> lock(txMtx);
+    if (writeFd < 0) {
+        return;
+    }
+    flushLocked();
+    close(writeFd);
+    writeFd = -1;
+    txFailed = true;
+}
+
+size_t ControllerChannel::pending() const {
+    lock_guard<mutex> lock(txMtx);
+    return txQueue.size();
+}
+
+bool ControllerChannel::writeAll(const uint8_t* header, size_t headerLen,
+                                 const uint8_t* body, size_t bodyLen) {
+    // Caller holds txMtx, so frames from different threads never interleave.
+    iovec iov[2];
+    iov[0].iov_base = const_cast<uint8_t*>(header);
+    iov[0].iov_len = headerLen;
+    iov[1].iov_base = const_cast<uint8_t*>(body);
+    iov[1].iov_len = bodyLen;
+    iovec* cur = iov;
+    int left = 2;
+
+    while (left > 0) {
+        ssize_t n = writev(writeFd, cur, left);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Pipe is full: wait for the reader to catch up. The peer
+                // may be stuck writing to us just the same, so keep taking
+                // in its frames meanwhile; receive() parses them later.
+                lock_guard<mutex> rxLock(rxMtx);
+                pollfd pfds[2] = {{writeFd, POLLOUT, 0}, {rxClosed ? -1 : readFd, POLLIN, 0}};
+                poll(pfds, 2, -1);
+                if (pfds[1].revents != 0) {
+                    readAvailable();
+                }
+                continue;
+            }
+            return false;
+        }
+
+        // Skip fully written buffers and trim a partially written one.
+        size_t done = static_cast<size_t>(n);
+        while (left > 0 && done >= cur->iov_len) {
+            done -= cur->iov_len;
+            ++cur;
+            --left;
+        }
+        if (left > 0) {
+            cur->iov_base = static_cast<uint8_t*>(cur->iov_base) + done;
+            cur->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+void ControllerChannel::parseFrames(vector<ControllerMessage> &out, int &count) {
+    size_t pos = 0;
+    while (rxBuffer.size() - pos >= sizeof(uint32_t)) {
+        uint32_t frameCount;
+        memcpy(&frameCount, rxBuffer.data() + pos, sizeof(frameCount));
+        size_t frameLen = sizeof(uint32_t) + frameCount * sizeof(ControllerMessage);
+        if (rxBuffer.size() - pos < frameLen) {
+            break; // rest of the frame has not arrived yet
+        }
+
+        const uint8_t* body = rxBuffer.data() + pos + sizeof(uint32_t);
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            ControllerMessage msg;
+            memcpy(&msg, body + i * sizeof(ControllerMessage), sizeof(msg));
+            out.push_back(msg);
+            ++count;
+            if (Metrics::enabled()) {
+                Metrics::count(MetricCounter::MESSAGES_RECEIVED);
+                Metrics::record(MetricHistogram::IPC_LATENCY, (monotonicNs() - msg.sentAtNs) / 1000);
+            }
+            if (Recorder::enabled()) {
+                Recorder::message(RecordKind::MESSAGE_RECEIVED, msg);
+            }
+        }
+        pos += frameLen;
+    }
+    rxBuffer.erase(rxBuffer.begin(), rxBuffer.begin() + pos);
+}
+
+void ControllerChannel::readAvailable() {
+    uint8_t chunk[16384];
+    while (true) {
+        ssize_t n = read(readFd, chunk, sizeof(chunk));
+        if (n > 0) {
+            rxBuffer.insert(rxBuffer.end(), chunk, chunk + n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0) {
+            rxClosed = true; // peer closed its write end
+        }
+        break; // EAGAIN: drained for now
+    }
+}
+
+int ControllerChannel::receive(vector<ControllerMessage> &out, int timeoutMs) {
+    int count = 0;
+    {
+        // Frames a blocked writer took in while we were away.
+        lock_guard<mutex> lock(rxMtx);
+        parseFrames(out, count);
+        if (count > 0) {
+            return count;
+        }
+        if (rxClosed) {
+            return -1;
+        }
+    }
+
+    pollfd pfd{readFd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    if (ready == 0) {
+        return 0;
+    }
+
+    lock_guard<mutex> lock(rxMtx);
+    readAvailable();
+    parseFrames(out, count);
+    if (count == 0 && rxClosed) {
+        return -1;
+    }
+    return count;
+}
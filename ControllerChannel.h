@@ -0,0 +1,82 @@
+#ifndef CONTROLLER_CHANNEL_H
+#define CONTROLLER_CHANNEL_H
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "TrafficController.h"
+#include "MessageTransport.h"
+
+using namespace std;
+
+// Batched, framed, non-blocking transport for ControllerMessage over a pair
+// of pipe ends.
+//
+// send() only queues; messages go out in frames of
+//     uint32_t count | count * ControllerMessage
+// written with one writev per frame when the batch fills up or flush() is
+// called. Partial reads and writes are resumed, and receive() waits with
+// poll() so a listener can time out and check for shutdown. While a write
+// waits for pipe space, incoming frames are still read and kept for
+// receive(), so two channels flushing at each other cannot deadlock.
+class ControllerChannel : public MessageTransport {
+public:
+    // Messages per frame; send() flushes when this many are queued.
+    static const size_t MAX_BATCH = 64;
+
+    // Either fd may be -1 for a one-way channel. Both are switched to
+    // non-blocking mode. The channel only closes writeFd, in closeSend().
+    ControllerChannel(int readFd, int writeFd);
+
+    ControllerChannel(const ControllerChannel&) = delete;
+    ControllerChannel& operator=(const ControllerChannel&) = delete;
+
+    // Queue a message, stamping sentAtNs. Thread-safe. Returns false once
+    // the write side has failed.
+    bool send(const ControllerMessage &msg) override;
+
+    // Write every queued message. Thread-safe. Returns false on error
+    // (for example the peer closed its read end).
+    bool flush() override;
+
+    // Number of messages queued and not yet written.
+    size_t pending() const;
+
+    // Wait up to timeoutMs (-1 = forever) for incoming messages and append
+    // every complete one to out. Returns the number appended, 0 on timeout,
+    // or -1 once the peer has closed and nothing is left. Single reader only.
+    int receive(vector<ControllerMessage> &out, int timeoutMs) override;
+
+    // Flush and close the write end, so the peer sees EOF.
+    void closeSend() override;
+
+    // Totals, for reporting.
+    unsigned long messagesSent() const { return sentMessages; }
+    unsigned long framesSent() const { return sentFrames; }
+
+private:
+    bool flushLocked(); // caller holds txMtx
+    bool writeAll(const uint8_t* header, size_t headerLen,
+                  const uint8_t* body, size_t bodyLen);
+    void readAvailable(); // caller holds rxMtx
+    void parseFrames(vector<ControllerMessage> &out, int &count); // caller holds rxMtx
+
+    int readFd;
+    int writeFd;
+
+    mutable mutex txMtx;
+    vector<ControllerMessage> txQueue;
+    bool txFailed;
+    unsigned long sentMessages;
+    unsigned long sentFrames;
+
+    // A writer waiting on a full pipe also reads, so the peer can never
+    // block both ways at once.
+    mutex rxMtx;
+    vector<uint8_t> rxBuffer; // bytes received but not yet parsed
+    bool rxClosed;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "EventSimulator.h"
+#include "Vehicle.h"
+#include "ParkingLot.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "Columns.h"
+
+EventSimulator::EventSimulator(Intersection &inter, TrafficController &ctrl, ParkingLot* parkingLot)
+    : intersection(inter),
+      controller(ctrl),
+      lot(parkingLot),
+      source(nullptr),
+      started(false),
+      liveStep(0),
+      nextStepTime(0),
+      clock(0),
+      nextSeq(0),
+      processed(0),
+      pendingVehicleEvents(0) {}
+
+void EventSimulator::schedule(long time, SimEventType type, Vehicle* v) {
+    if (type == SimEventType::CONTROLLER_STEP) {
+        liveStep = nextSeq;
+        nextStepTime = time;
+    } else {
+        ++pendingVehicleEvents;
+    }
+    events.push(SimEvent{time, type, nextSeq++, v});
+}
+
+void EventSimulator::addVehicle(Vehicle* v) {
+    schedule(v->getArrivalTime(), SimEventType::VEHICLE_ARRIVAL, v);
+}
+
+void EventSimulator::addTransfer(Vehicle* v, long time) {
+    schedule(time, SimEventType::VEHICLE_TRANSFER, v);
+}
+
+void EventSimulator::setSource(VehicleSource* src) {
+    source = src;
+}
+
+void EventSimulator::pullArrivals() {
+    // Schedule every sourced arrival up to the next queued event, so the
+    // queue never holds more than one batch of the trace.
+    if (!source) {
+        return;
+    }
+    long arrival;
+    while ((arrival = source->nextArrival()) >= 0 &&
+           (events.empty() || arrival <= events.top().time)) {
+        addVehicle(source->takeNext());
+    }
+}
+
+void EventSimulator::preemptFor(const Vehicle* v) {
+    if (v->isEmergency() && started && nextStepTime > clock) {
+        // Preempt: the pending step goes stale and the controller decides now.
+        schedule(clock, SimEventType::CONTROLLER_STEP, nullptr);
+    }
+}
+
+void EventSimulator::handle(const SimEvent &e) {
+    switch (e.type) {
+    case SimEventType::VEHICLE_ARRIVAL: {
+        Vehicle* v = e.vehicle;
+        v->arriveAt(lot);
+
+        // The reservation may be at another lot if the origin's was full.
+        ParkingLot* reserved = v->getReservedLot();
+        if (reserved && v->beginParking(*reserved)) {
+            schedule(clock + Vehicle::PARKING_DURATION, SimEventType::PARKING_DEPARTURE, v);
+        }
+        preemptFor(v);
+        if (!v->hasParkingReservation()) {
+            v->finishArrival();
+        }
+        break;
+    }
+
+    case SimEventType::VEHICLE_TRANSFER:
+        intersection.addVehicle(e.vehicle->getApproach(), e.vehicle);
+        preemptFor(e.vehicle);
+        break;
+
+    case SimEventType::PARKING_DEPARTURE: {
+        e.vehicle->endParking(*e.vehicle->getReservedLot());
+        e.vehicle->finishArrival();
+        break;
+    }
+
+    case SimEventType::CONTROLLER_STEP:
+        if (e.seq == liveStep) {
+            controller.setNowMs(clock * 1000);
+            schedule(clock + controller.step(), SimEventType::CONTROLLER_STEP, nullptr);
+        }
+        break;
+    }
+}
+
+void EventSimulator::startController() {
+    // The controller starts with the simulation, before any vehicle arrives.
+    if (!started) {
+        started = true;
+        schedule(clock, SimEventType::CONTROLLER_STEP, nullptr);
+    }
+}
+
+void EventSimulator::processNext() {
+    // Freeing finished vehicles is cheap but needn't happen every event.
+    if (source && (processed & (COLLECT_INTERVAL - 1)) == 0) {
+        source->collect();
+    }
+
+    SimEvent e = events.top();
+    events.pop();
+    if (e.type != SimEventType::CONTROLLER_STEP) {
+        --pendingVehicleEvents;
+    }
+    clock = e.time;
+    if (ColumnWriter::enabled()) {
+        ColumnWriter::setTime(clock * 1000);
+    }
+    handle(e);
+    ++processed;
+}
+
+bool EventSimulator::idle() const {
+    return pendingVehicleEvents == 0 && intersection.empty() &&
+           (!source || source->nextArrival() < 0);
+}
+
+long EventSimulator::run(long endTime) {
+    startController();
+
+    pullArrivals();
+    while (!events.empty()) {
+        const SimEvent &e = events.top();
+
+        if (e.type == SimEventType::CONTROLLER_STEP && idle()) {
+            break; // nothing left to serve
+        }
+        if (endTime >= 0 && e.time > endTime) {
+            break;
+        }
+        processNext();
+        pullArrivals();
+    }
+    return clock;
+}
+
+void EventSimulator::runUntil(long until) {
+    startController();
+
+    pullArrivals();
+    while (!events.empty() && events.top().time < until) {
+        processNext();
+        pullArrivals();
+    }
+    if (clock < until) {
+        clock = until;
+    }
+}
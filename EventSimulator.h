@@ -0,0 +1,125 @@
+#ifndef EVENT_SIMULATOR_H
+#define EVENT_SIMULATOR_H
+
+#include <iostream>
+#include <vector>
+#include <queue>
+
+using namespace std;
+
+class Vehicle;
+class ParkingLot;
+class Intersection;
+class TrafficController;
+
+// Kinds of scheduled events. The enum order is also the tie-break order for
+// events at the same simulated second: vehicles that arrive at second t are
+// queued before the controller decides at t, matching the real-time mode
+// where a phase change and an arrival in the same second race.
+enum class SimEventType {
+    PARKING_DEPARTURE,
+    VEHICLE_ARRIVAL,
+    VEHICLE_TRANSFER,
+    CONTROLLER_STEP
+};
+
+// Supplies vehicles in arrival order, creating each one on demand so a long
+// trace never has to be in memory at once (see ScenarioFeed).
+class VehicleSource {
+public:
+    virtual ~VehicleSource() {}
+
+    // Arrival time of the next vehicle, or -1 when there are no more.
+    virtual long nextArrival() = 0;
+
+    // Create the next vehicle. The source keeps ownership.
+    virtual Vehicle* takeNext() = 0;
+
+    // Called now and then so the source can free finished vehicles.
+    virtual void collect() {}
+};
+
+struct SimEvent {
+    long time;            // simulated seconds since start
+    SimEventType type;
+    unsigned long seq;    // schedule order, last tie-break
+    Vehicle* vehicle;     // nullptr for CONTROLLER_STEP
+};
+
+// Discrete-event driver for one intersection. Runs in virtual time on the
+// calling thread: arrivals, controller decisions and parking departures are
+// events on a priority queue and the clock jumps from one to the next, so
+// nothing sleeps. Crossings happen in the same order as in the real-time
+// mode because both drive TrafficController::step(). As in real time, an
+// emergency arrival brings the next controller step forward to now.
+class EventSimulator {
+public:
+    // lot is the intersection's parking lot, or nullptr if it has none.
+    EventSimulator(Intersection &inter, TrafficController &ctrl, ParkingLot* lot);
+
+    // Schedule a vehicle's arrival at v->getArrivalTime(), which must not
+    // be earlier than now().
+    void addVehicle(Vehicle* v);
+
+    // Schedule a vehicle that reaches this intersection over a road at
+    // `time`: it joins its approach lane without stopping at the lot.
+    void addTransfer(Vehicle* v, long time);
+
+    // Pull arrivals from `source` as the clock reaches them, in addition to
+    // any added with addVehicle(). Pass nullptr to detach.
+    void setSource(VehicleSource* source);
+
+    // Process events until every vehicle has arrived and left parking and
+    // the intersection has drained, or until the clock passes endTime
+    // (negative means no limit). Returns the final simulated time.
+    long run(long endTime = -1);
+
+    // Process every event strictly before `until` and stop there, whether or
+    // not the intersection has drained. For lockstep runs of several
+    // simulators (NetworkSimulation).
+    void runUntil(long until);
+
+    // True when only controller steps are queued, no vehicle is waiting and
+    // the source (if any) is exhausted.
+    bool idle() const;
+
+    // Current simulated time in seconds.
+    long now() const { return clock; }
+
+    unsigned long processedEvents() const { return processed; }
+
+private:
+    struct Later {
+        bool operator()(const SimEvent &a, const SimEvent &b) const {
+            if (a.time != b.time) return a.time > b.time;
+            if (a.type != b.type) return a.type > b.type;
+            return a.seq > b.seq;
+        }
+    };
+
+    // Events between VehicleSource::collect() calls; a power of two.
+    static const unsigned long COLLECT_INTERVAL = 1024;
+
+    void schedule(long time, SimEventType type, Vehicle* v);
+    void handle(const SimEvent &e);
+    void preemptFor(const Vehicle* v);
+    void startController();
+    void processNext();
+    void pullArrivals();
+
+    Intersection &intersection;
+    TrafficController &controller;
+    ParkingLot* lot;
+    VehicleSource* source;
+    bool started;
+    unsigned long liveStep; // seq of the controller step that counts; others were preempted
+    long nextStepTime;
+
+    priority_queue<SimEvent, vector<SimEvent>, Later> events;
+    long clock;
+    unsigned long nextSeq;
+    unsigned long processed;
+    size_t pendingVehicleEvents; // arrivals, transfers and departures still queued
+};
+
+#endif
@@ -1,86 +1,247 @@
-#include "Intersection.h"
-
-const string Direction::NORTH = "NORTH";
-const string Direction::SOUTH = "SOUTH";
-const string Direction::EAST  = "EAST";
-const string Direction::WEST  = "WEST";
-
-Intersection::Intersection(ParkingLot* lot)
-    : parkingLot(lot) {}
-
-void Intersection::addVehicle(const string &direction, Vehicle* v) {
-    lock_guard<mutex> lock(mtx);
-
-    if (direction == Direction::NORTH) {
-        northLane.push(v);
-    } else if (direction == Direction::SOUTH) {
-        southLane.push(v);
-    } else if (direction == Direction::EAST) {
-        eastLane.push(v);
-    } else if (direction == Direction::WEST) {
-        westLane.push(v);
-    } else {
-        cout << "Invalid direction: " << direction << endl;
-    }
-}
-
-Vehicle* Intersection::getNextVehicle(const string &direction) const {
-    lock_guard<mutex> lock(mtx);
-
-    if (direction == Direction::NORTH) {
-        return northLane.front();
-    } else if (direction == Direction::SOUTH) {
-        return southLane.front();
-    } else if (direction == Direction::EAST) {
-        return eastLane.front();
-    } else if (direction == Direction::WEST) {
-        return westLane.front();
-    } else {
-        cout << "Invalid direction: " << direction << endl;
-        return nullptr;
-    }
-}
-
-void Intersection::removeVehicle(const string &direction) {
-    lock_guard<mutex> lock(mtx);
-
-    if (direction == Direction::NORTH) {
-        northLane.pop();
-    } else if (direction == Direction::SOUTH) {
-        southLane.pop();
-    } else if (direction == Direction::EAST) {
-        eastLane.pop();
-    } else if (direction == Direction::WEST) {
-        westLane.pop();
-    } else {
-        cout << "Invalid direction: " << direction << endl;
-    }
-}
-
-bool Intersection::hasVehicle(const string &direction) const {
-    lock_guard<mutex> lock(mtx);
-
-    if (direction == Direction::NORTH) {
-        return !northLane.empty();
-    } else if (direction == Direction::SOUTH) {
-        return !southLane.empty();
-    } else if (direction == Direction::EAST) {
-        return !eastLane.empty();
-    } else if (direction == Direction::WEST) {
-        return !westLane.empty();
-    } else {
-        cout << "Invalid direction: " << direction << endl;
-        return false;
-    }
-}
-
-void Intersection::printStatus() const {
-    lock_guard<mutex> lock(mtx);
-
-    cout << "Intersection Status:" << endl;
-    cout << "North Lane: "; northLane.print();
-    cout << "South Lane: "; southLane.print();
-    cout << "East Lane: ";  eastLane.print();
-    cout << "West Lane: ";  westLane.print();
-    cout << "-----------------------------" << endl;
-}
+#include "Intersection.h"
+#include "Metrics.h"
+#include "Recording.h"
+#include "Columns.h"
+
+static const string DIRECTION_NAMES[DIRECTION_COUNT] = {"NORTH", "SOUTH", "EAST", "WEST"};
+static const char* DIRECTION_SHORT_NAMES[DIRECTION_COUNT] = {"N", "S", "E", "W"};
+
+const string& directionName(Direction d) {
+    return DIRECTION_NAMES[directionIndex(d)];
+}
+
+const char* directionShortName(Direction d) {
+    return DIRECTION_SHORT_NAMES[directionIndex(d)];
+}
+
+bool parseDirection(const string &name, Direction &out) {
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        if (name == DIRECTION_NAMES[i] || name == DIRECTION_SHORT_NAMES[i]) {
+            out = directionAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static const string MOVEMENT_NAMES[MOVEMENT_COUNT] = {"STRAIGHT", "LEFT", "RIGHT"};
+
+const string& movementName(Movement m) {
+    return MOVEMENT_NAMES[movementIndex(m)];
+}
+
+bool parseMovement(const string &name, Movement &out) {
+    for (int i = 0; i < MOVEMENT_COUNT; ++i) {
+        if (name == MOVEMENT_NAMES[i]) {
+            out = movementAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+Intersection::Intersection(ParkingLot* lot)
+    : parkingLot(lot),
+      emergencyCounts{0, 0, 0, 0},
+      emergencyTotal(0),
+      earliestEmergency(nullptr),
+      earliestEmergencyLane(Direction::NORTH),
+      laned(0),
+      emergencyArrivals(0),
+      interrupts(0) {}
+
+void Intersection::drainLocked() const {
+    bool emergencies = false;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        // Only ever drained under mtx, so there is a single consumer.
+        ArrivalQueue &queue = arrivals[i];
+        if (queue.empty()) {
+            continue;
+        }
+        for (Vehicle* v = queue.drain(); v; ) {
+            Vehicle* next = ArrivalQueue::next(v);
+            lanes[i].push(v);
+            ++laned;
+            if (Recorder::enabled()) {
+                Recorder::arrival(v); // in lane order, which is what a replay needs
+            }
+            if (v->isEmergency()) {
+                ++emergencyCounts[i];
+                ++emergencyTotal;
+                emergencies = true;
+            }
+            v = next;
+        }
+    }
+    if (emergencies) {
+        refreshEmergencyLocked();
+    }
+}
+
+void Intersection::refreshEmergencyLocked() const {
+    earliestEmergency = nullptr;
+    if (emergencyTotal == 0) {
+        return;
+    }
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        if (emergencyCounts[i] == 0) {
+            continue;
+        }
+        Vehicle* v = lanes[i].front();
+        if (!earliestEmergency || v->getArrivalTime() < earliestEmergency->getArrivalTime()) {
+            earliestEmergency = v;
+            earliestEmergencyLane = directionAt(i);
+        }
+    }
+}
+
+void Intersection::drainArrivals() {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+}
+
+LaneTicket Intersection::addVehicle(Direction direction, Vehicle* v) {
+    if (!v) {
+        return LaneTicket::of(nullptr, direction);
+    }
+    if (ColumnWriter::enabled()) {
+        ColumnWriter::arrival(v, direction); // before the controller can release it
+    }
+    arrivals[directionIndex(direction)].push(v);
+    Metrics::count(MetricCounter::VEHICLES_ARRIVED);
+
+    if (v->isEmergency()) {
+        // Taking waitMtx orders the count against a controller that has
+        // just checked it and is about to sleep.
+        {
+            lock_guard<mutex> lock(waitMtx);
+            emergencyArrivals.fetch_add(1);
+        }
+        waitCv.notify_all();
+    }
+    return LaneTicket::of(v, direction);
+}
+
+LaneTicket Intersection::addVehicle(const string &direction, Vehicle* v) {
+    Direction d;
+    if (!parseDirection(direction, d)) {
+        cout << "Invalid direction: " << direction << endl;
+        return LaneTicket::of(nullptr, Direction::NORTH);
+    }
+    return addVehicle(d, v);
+}
+
+Vehicle* Intersection::getNextVehicle(Direction direction) const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    return lanes[directionIndex(direction)].front();
+}
+
+Vehicle* Intersection::popVehicle(Direction direction) {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    int i = directionIndex(direction);
+    Vehicle* v = lanes[i].front();
+    lanes[i].pop();
+    if (v && v->isEmergency()) {
+        --emergencyCounts[i];
+        --emergencyTotal;
+        refreshEmergencyLocked();
+    }
+    return v;
+}
+
+void Intersection::removeVehicle(Direction direction) {
+    popVehicle(direction);
+}
+
+bool Intersection::removeVehicle(const LaneTicket &ticket) {
+    Vehicle* v = ticket.get();
+    if (!v) {
+        return false;
+    }
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    int i = directionIndex(ticket.lane);
+    if (!lanes[i].erase(v)) {
+        return false;
+    }
+    if (v->isEmergency()) {
+        --emergencyCounts[i];
+        --emergencyTotal;
+        refreshEmergencyLocked();
+    }
+    return true;
+}
+
+bool Intersection::hasVehicle(Direction direction) const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    return !lanes[directionIndex(direction)].empty();
+}
+
+LaneSnapshot Intersection::snapshot() const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+
+    LaneSnapshot snap;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        snap.heads[i] = lanes[i].front();
+        snap.sizes[i] = lanes[i].size();
+    }
+    snap.emergency = earliestEmergency;
+    snap.emergencyLane = earliestEmergencyLane;
+    snap.arrivals = laned;
+    return snap;
+}
+
+bool Intersection::empty() const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    for (const VehicleLane &lane : lanes) {
+        if (!lane.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Vehicle* Intersection::nextEmergency() const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    return earliestEmergency;
+}
+
+int Intersection::emergencyCount() const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+    return emergencyTotal;
+}
+
+bool Intersection::waitForEmergency(unsigned long seen, chrono::steady_clock::time_point deadline) {
+    unique_lock<mutex> lock(waitMtx);
+    unsigned long interrupted = interrupts;
+    return waitCv.wait_until(lock, deadline, [&] {
+        return emergencyArrivals.load() != seen || interrupts != interrupted;
+    });
+}
+
+void Intersection::interruptWait() {
+    {
+        lock_guard<mutex> lock(waitMtx);
+        ++interrupts;
+    }
+    waitCv.notify_all();
+}
+
+void Intersection::printStatus() const {
+    lock_guard<mutex> lock(mtx);
+    drainLocked();
+
+    cout << "Intersection Status:" << endl;
+    cout << "North Lane: "; lanes[directionIndex(Direction::NORTH)].print();
+    cout << "South Lane: "; lanes[directionIndex(Direction::SOUTH)].print();
+    cout << "East Lane: ";  lanes[directionIndex(Direction::EAST)].print();
+    cout << "West Lane: ";  lanes[directionIndex(Direction::WEST)].print();
+    cout << "-----------------------------" << endl;
+}
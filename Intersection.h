@@ -4,45 +4,180 @@
 #include <iostream>
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include "VehileLane.h"
+#include "ArrivalQueue.h"
 #include "ParkingLot.h"
 #include "Vehicle.h"
+#include "VehicleStore.h"
 
 using namespace std;
 
-// Canonical textual directions used at the intersection.
-struct Direction {
-    static const string NORTH;
-    static const string SOUTH;
-    static const string EAST;
-    static const string WEST;
+// Approaches to an intersection. The values index Intersection's lanes.
+enum class Direction : uint8_t {
+    NORTH,
+    SOUTH,
+    EAST,
+    WEST
+};
+
+const int DIRECTION_COUNT = 4;
+
+inline int directionIndex(Direction d) { return static_cast<int>(d); }
+inline Direction directionAt(int index) { return static_cast<Direction>(index); }
+
+// Canonical names ("NORTH", ...) used in logs and scenario definitions.
+const string& directionName(Direction d);
+
+// One-letter form ("N", ...) used in ControllerMessage::approach.
+const char* directionShortName(Direction d);
+
+// Parse a canonical or one-letter name. Returns false if the name is not a
+// direction.
+bool parseDirection(const string &name, Direction &out);
+
+// What a vehicle does at the intersection, seen from its approach.
+enum class Movement : uint8_t {
+    STRAIGHT,
+    LEFT,
+    RIGHT
+};
+
+const int MOVEMENT_COUNT = 3;
+
+inline int movementIndex(Movement m) { return static_cast<int>(m); }
+inline Movement movementAt(int index) { return static_cast<Movement>(index); }
+
+// "STRAIGHT", "LEFT", "RIGHT", as in ControllerMessage::movement.
+const string& movementName(Movement m);
+
+// Parse a movement name. Returns false if the name is not a movement.
+bool parseMovement(const string &name, Movement &out);
+
+// Handle for a queued vehicle: the vehicle and the lane it was queued in.
+// The vehicle is held by generation-checked handle, so a ticket kept past
+// the vehicle's destruction resolves to nullptr rather than to a new
+// vehicle that reuses its slot.
+struct LaneTicket {
+    VehicleHandle vehicle; // null if it was never queued
+    Direction lane;
+
+    static LaneTicket of(Vehicle* v, Direction d) {
+        return LaneTicket{v ? VehicleStore::handle(v) : VehicleHandle::null(), d};
+    }
+    // The ticket's vehicle, or nullptr if it is gone (or never was).
+    Vehicle* get() const { return VehicleStore::get(vehicle); }
+};
+
+// Heads and queue lengths of all four lanes, taken under a single lock.
+struct LaneSnapshot {
+    Vehicle* heads[DIRECTION_COUNT];
+    int sizes[DIRECTION_COUNT];
+    Vehicle* emergency;      // earliest-arriving queued emergency vehicle, or nullptr
+    Direction emergencyLane; // its lane
+    uint64_t arrivals;       // vehicles moved into the lanes so far
+
+    Vehicle* head(Direction d) const { return heads[directionIndex(d)]; }
+    int size(Direction d) const { return sizes[directionIndex(d)]; }
+    LaneTicket ticket(Direction d) const { return LaneTicket::of(head(d), d); }
 };
 
 // Thread-safe wrapper around four directional lanes and an optional
 // attached parking lot.
+//
+// Arriving vehicles go into a lock-free ArrivalQueue per approach, so
+// vehicle threads never wait on the controller. Readers move pending
+// arrivals into the priority lanes under mtx before looking at them, so
+// every read sees every completed addVehicle.
+//
+// Queued emergency vehicles are indexed as they enter and leave the lanes,
+// and an emergency arrival wakes a controller blocked in waitForEmergency.
 class Intersection {
-    VehicleLane northLane;
-    VehicleLane southLane;
-    VehicleLane eastLane;
-    VehicleLane westLane;
+    // Both are drained/filled lazily by readers, hence mutable.
+    mutable ArrivalQueue arrivals[DIRECTION_COUNT];
+    mutable VehicleLane lanes[DIRECTION_COUNT];
 
     ParkingLot* parkingLot; // may be nullptr if no parking lot attached
     mutable mutex mtx;      // protects lane access and status prints
 
+    // Emergency index, under mtx. Lanes order emergencies first, so each
+    // lane's queued emergencies are at its front.
+    mutable int emergencyCounts[DIRECTION_COUNT];
+    mutable int emergencyTotal;
+    mutable Vehicle* earliestEmergency;
+    mutable Direction earliestEmergencyLane;
+    mutable uint64_t laned; // vehicles moved from arrivals into lanes, under mtx
+
+    // Emergency arrivals so far, and what the controller sleeps on.
+    atomic<unsigned long> emergencyArrivals;
+    mutex waitMtx;
+    condition_variable waitCv;
+    unsigned long interrupts; // under waitMtx
+
+    // Move pending arrivals into their lanes. Caller holds mtx.
+    void drainLocked() const;
+
+    // Recompute earliestEmergency from the lane fronts. Caller holds mtx.
+    void refreshEmergencyLocked() const;
+
 public:
     explicit Intersection(ParkingLot* lot = nullptr);
 
-    // Add a vehicle to a directional lane based on its approach.
-    void addVehicle(const string &direction, Vehicle* v);
+    // Add a vehicle to a directional lane based on its approach and return
+    // the ticket that removes it again. Lock-free; safe to call from any
+    // number of threads.
+    LaneTicket addVehicle(Direction direction, Vehicle* v);
+
+    // String form for scenario edges; logs and ignores unknown names
+    // (the ticket then has no vehicle).
+    LaneTicket addVehicle(const string &direction, Vehicle* v);
 
     // Peek at the next vehicle from a direction without removing it.
-    Vehicle* getNextVehicle(const string &direction) const;
+    Vehicle* getNextVehicle(Direction direction) const;
+
+    // Remove and return the front vehicle of a lane, or nullptr if empty.
+    Vehicle* popVehicle(Direction direction);
 
     // Remove the front vehicle from a given direction.
-    void removeVehicle(const string &direction);
+    void removeVehicle(Direction direction);
+
+    // Remove exactly the ticket's vehicle from its lane in one locked
+    // operation, O(log n) when it is at the front. Returns false if it is
+    // not queued there, e.g. because it already crossed, or if the ticket's
+    // vehicle has been destroyed.
+    bool removeVehicle(const LaneTicket &ticket);
 
     // Check if there is at least one vehicle on a given approach.
-    bool hasVehicle(const string &direction) const;
+    bool hasVehicle(Direction direction) const;
+
+    // Consistent view of every lane head, for one controller decision.
+    LaneSnapshot snapshot() const;
+
+    // Move pending arrivals into the priority lanes now. Readers do this
+    // on their own; the controller calls it at the start of a decision.
+    void drainArrivals();
+
+    // True if no approach has a queued vehicle.
+    bool empty() const;
+
+    // Earliest-arriving queued emergency vehicle, or nullptr.
+    Vehicle* nextEmergency() const;
+
+    // Emergency vehicles queued on all approaches.
+    int emergencyCount() const;
+
+    // Emergency vehicles ever passed to addVehicle. Lock-free.
+    unsigned long emergencyArrivalCount() const { return emergencyArrivals.load(); }
+
+    // Block until `deadline`, until emergencyArrivalCount() moves past
+    // `seen`, or until interruptWait(). Returns true if woken early.
+    bool waitForEmergency(unsigned long seen, chrono::steady_clock::time_point deadline);
+
+    // Wake every waitForEmergency caller now, e.g. to stop a controller.
+    void interruptWait();
 
     // Debug helper to dump the current queues.
     void printStatus() const;
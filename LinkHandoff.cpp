@@ -0,0 +1,220 @@
+#include "LinkHandoff.h"
+#include "Intersection.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// How long drain() waits, beyond a link's travel time, with nothing moving.
+const double DRAIN_STALL_S = 60.0;
+
+struct LaterDue {
+    template <class T>
+    bool operator()(const T &a, const T &b) const { return a.dueNs > b.dueNs; }
+};
+
+} // namespace
+
+LinkHandoff::LinkHandoff(const string &selfName, const string &peerName, const RoadLink &out, const RoadLink &in,
+                         MessageTransport &ch, Intersection &inter, double start)
+    : self(selfName),
+      peer(peerName),
+      peerId(NameTable::intern(peerName)),
+      outbound(out),
+      inbound(in),
+      channel(ch),
+      intersection(inter),
+      startSeconds(start),
+      outboundCount(0),
+      peerDone(false),
+      peerGone(false),
+      expected(0),
+      sent(0),
+      received(0),
+      moves(0) {}
+
+LinkHandoff::~LinkHandoff() {
+    for (const OnRoad &r : road) {
+        VehicleStore::destroy(r.vehicle);
+    }
+    for (Vehicle* v : queued) {
+        VehicleStore::destroy(v);
+    }
+    for (Vehicle* v : finished) {
+        VehicleStore::destroy(v);
+    }
+}
+
+void LinkHandoff::expect(const Vehicle* v) {
+    if (v->getDestinationId() == peerId) {
+        ++expected;
+    }
+}
+
+bool LinkHandoff::mayDepart(const Vehicle* v) const {
+    return v->getDestinationId() != peerId || peerGone.load() ||
+           outboundCount.load() < outbound.capacity;
+}
+
+void LinkHandoff::crossed(Vehicle* v) {
+    ControllerMessage msg{};
+    msg.vehicleId   = v->getId();
+    msg.priority    = v->getPriority();
+    msg.isEmergency = v->isEmergency();
+    strncpy(msg.type, v->getType().c_str(), sizeof(msg.type) - 1);
+    strncpy(msg.origin, self.c_str(), sizeof(msg.origin) - 1);
+    strncpy(msg.destination, peer.c_str(), sizeof(msg.destination) - 1);
+
+    bool arrived;
+    {
+        lock_guard<mutex> lock(mtx);
+        arrived = queued.erase(v) > 0;
+        if (arrived) {
+            finished.push_back(v);
+        }
+    }
+    if (arrived) {
+        // Came over the inbound road and has reached its destination.
+        msg.kind = MessageKind::LINK_EXIT;
+        channel.send(msg);
+        ++moves;
+        return;
+    }
+    if (v->getDestinationId() != peerId || peerGone.load()) {
+        return;
+    }
+
+    msg.kind = MessageKind::HANDOFF;
+    msg.hops = 1;
+    strncpy(msg.approach, directionShortName(outbound.approach), sizeof(msg.approach) - 1);
+    strncpy(msg.movement, movementName(v->getMovement()).c_str(), sizeof(msg.movement) - 1);
+    int onRoad = ++outboundCount;
+    channel.send(msg);
+    ++sent;
+    ++moves;
+    LOG_EVENT(INFO, LogEvent::VEHICLE_HANDOFF, v, self, peer, onRoad);
+}
+
+bool LinkHandoff::receive(const ControllerMessage &msg) {
+    switch (msg.kind) {
+    case MessageKind::HANDOFF: {
+        uint64_t due = msg.sentAtNs + static_cast<uint64_t>(inbound.travelTime) * 1000000000ull;
+        int arrival = max(0, static_cast<int>(due / 1e9 - startSeconds));
+        Vehicle* v = VehicleStore::create(msg.vehicleId, string(msg.type, strnlen(msg.type, sizeof(msg.type))),
+                                          self, self, arrival);
+        v->setApproach(inbound.approach);
+        Movement m;
+        if (parseMovement(string(msg.movement, strnlen(msg.movement, sizeof(msg.movement))), m)) {
+            v->setMovement(m);
+        }
+        lock_guard<mutex> lock(mtx);
+        road.push_back(OnRoad{due, v});
+        push_heap(road.begin(), road.end(), LaterDue());
+        ++received;
+        ++moves;
+        return true;
+    }
+    case MessageKind::LINK_EXIT:
+        --outboundCount;
+        ++moves;
+        return true;
+    case MessageKind::DONE:
+        peerDone = true;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void LinkHandoff::poll() {
+    uint64_t now = monotonicNs();
+    vector<Vehicle*> due, done;
+    {
+        lock_guard<mutex> lock(mtx);
+        done.swap(finished);
+        while (!road.empty() && road.front().dueNs <= now) {
+            pop_heap(road.begin(), road.end(), LaterDue());
+            due.push_back(road.back().vehicle);
+            queued.insert(road.back().vehicle); // before the controller can see it
+            road.pop_back();
+        }
+    }
+    // crossed() runs before the controller marks the vehicle crossed, and
+    // the controller writes it until then; free it only after that.
+    vector<Vehicle*> crossing;
+    for (Vehicle* v : done) {
+        if (v->hasCrossed()) {
+            VehicleStore::destroy(v);
+        } else {
+            crossing.push_back(v);
+        }
+    }
+    if (!crossing.empty()) {
+        lock_guard<mutex> lock(mtx);
+        finished.insert(finished.end(), crossing.begin(), crossing.end());
+    }
+    for (Vehicle* v : due) {
+        LOG_EVENT(INFO, LogEvent::VEHICLE_TRANSFERRED, v, self, directionName(v->getApproach()));
+        intersection.addVehicle(v->getApproach(), v);
+    }
+}
+
+void LinkHandoff::peerClosed() {
+    peerGone = true;
+}
+
+void LinkHandoff::finishSending() {
+    ControllerMessage msg{};
+    msg.vehicleId = -1;
+    msg.kind = MessageKind::DONE;
+    strncpy(msg.origin, self.c_str(), sizeof(msg.origin) - 1);
+    strncpy(msg.destination, peer.c_str(), sizeof(msg.destination) - 1);
+    channel.send(msg);
+}
+
+bool LinkHandoff::outboundClear() const {
+    return peerGone.load() || (sent.load() == expected.load() && outboundCount.load() == 0);
+}
+
+bool LinkHandoff::inboundDone() const {
+    if (peerGone.load()) {
+        return true;
+    }
+    lock_guard<mutex> lock(mtx);
+    return peerDone.load() && road.empty() && queued.empty();
+}
+
+bool LinkHandoff::drain(int pollMs) {
+    double stallLimit = max(outbound.travelTime, inbound.travelTime) + DRAIN_STALL_S;
+    auto waitFor = [&](bool (LinkHandoff::*ready)() const) {
+        unsigned long seen = moves.load();
+        double lastMove = monotonicNs() / 1e9;
+        while (!(this->*ready)()) {
+            usleep(pollMs * 1000);
+            double now = monotonicNs() / 1e9;
+            if (moves.load() != seen) {
+                seen = moves.load();
+                lastMove = now;
+            } else if (now - lastMove > stallLimit) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool clear = waitFor(&LinkHandoff::outboundClear);
+    finishSending();
+    bool done = waitFor(&LinkHandoff::inboundDone);
+    return clear && done;
+}
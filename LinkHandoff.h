@@ -0,0 +1,108 @@
+#ifndef LINK_HANDOFF_H
+#define LINK_HANDOFF_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_set>
+#include <cstdint>
+
+#include "RoadNetwork.h"
+#include "MessageTransport.h"
+
+using namespace std;
+
+class Intersection;
+class Vehicle;
+
+// The roads between two real-time controller processes. A vehicle that
+// crosses this intersection bound for the peer is sent to it as a HANDOFF
+// message (id, type, priority, movement) and counts against the outbound
+// link until the peer answers LINK_EXIT when it has crossed there. While
+// the link holds `capacity` vehicles, the next one bound for the peer waits
+// at its stop line. A vehicle the peer hands over waits out the inbound
+// link's travel time, counted from the message's send stamp (CLOCK_MONOTONIC
+// is the same clock in both processes), then joins its approach lane here.
+//
+// mayDepart and crossed run on the controller thread; receive, poll and
+// peerClosed on the listener thread.
+class LinkHandoff {
+public:
+    // `outbound` is the road from `self` to `peer`, `inbound` the road back.
+    // `startSeconds` is the CLOCK_MONOTONIC time the controller started,
+    // against which arrival times are given.
+    LinkHandoff(const string &self, const string &peer, const RoadLink &outbound, const RoadLink &inbound,
+                MessageTransport &channel, Intersection &intersection, double startSeconds);
+
+    // Destroys vehicles still on the inbound road or queued here.
+    ~LinkHandoff();
+
+    LinkHandoff(const LinkHandoff&) = delete;
+    LinkHandoff& operator=(const LinkHandoff&) = delete;
+
+    // A vehicle of this intersection has asked to cross; if it is bound
+    // for the peer, outboundClear() waits for it.
+    void expect(const Vehicle* v);
+
+    // TrafficController departure check and crossing callback. crossed()
+    // takes inbound vehicles off `queued`; poll() frees them once the
+    // controller has marked them crossed.
+    bool mayDepart(const Vehicle* v) const;
+    void crossed(Vehicle* v);
+
+    // Take a HANDOFF, LINK_EXIT or DONE message from the peer. Returns
+    // false for anything else (a plain notification).
+    bool receive(const ControllerMessage &msg);
+
+    // Queue every inbound vehicle whose travel time is up.
+    void poll();
+
+    // The peer closed its end; nothing more will come from it.
+    void peerClosed();
+
+    // Called once no more local vehicles will arrive. Neither side may stop
+    // while a vehicle is on the road between them: waits for ours to cross
+    // the peer, tells it so, then keeps serving its vehicles until it has
+    // said the same. Returns false if the roads locked up (nothing moved over
+    // them for a travel time plus a minute) and it gave up waiting.
+    bool drain(int pollMs);
+
+    unsigned long handedOff() const { return sent.load(); }
+    unsigned long taken() const { return received.load(); }
+
+private:
+    void finishSending();
+    bool outboundClear() const;   // every expected vehicle crossed the peer, or the peer is gone
+    bool inboundDone() const;     // the peer is done and its vehicles crossed here, or it is gone
+
+    struct OnRoad {
+        uint64_t dueNs;
+        Vehicle* vehicle;
+    };
+
+    string self;
+    string peer;
+    uint32_t peerId;       // NameTable id of peer
+    RoadLink outbound;
+    RoadLink inbound;
+    MessageTransport &channel;
+    Intersection &intersection;
+    double startSeconds;
+
+    atomic<int> outboundCount;  // sent and not yet crossed at the peer
+    atomic<bool> peerDone;
+    atomic<bool> peerGone;
+    atomic<unsigned long> expected;
+    atomic<unsigned long> sent;
+    atomic<unsigned long> received;
+    atomic<unsigned long> moves;  // hand-offs and link exits either way, for drain()
+
+    mutable mutex mtx;
+    vector<OnRoad> road;              // min-heap on dueNs, inbound vehicles not yet here
+    unordered_set<Vehicle*> queued;   // inbound vehicles in this intersection's lanes
+    vector<Vehicle*> finished;        // crossed here; freed by poll() once marked crossed
+};
+
+#endif
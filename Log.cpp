@@ -0,0 +1,402 @@
+#include "Log.h"
+#include "Vehicle.h"
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+atomic<int> Log::currentMode(static_cast<int>(LogMode::SYNC));
+
+namespace {
+
+const size_t RING_SIZE = 4096;    // records per thread, a power of two
+const int WRITER_PERIOD_MS = 2;   // longest a record waits in ASYNC mode
+
+// Single-producer/single-consumer ring: the owning thread advances head,
+// the writer thread advances tail.
+struct LogRing {
+    LogRecord records[RING_SIZE];
+    atomic<size_t> head{0};
+    atomic<size_t> tail{0};
+    atomic<bool> retired{false}; // owner has exited; free once drained
+};
+
+mutex registryMtx; // guards everything below up to the counters
+vector<LogRing*> rings;
+condition_variable writerCv;
+condition_variable flushedCv;
+pthread_t writerThread;
+bool writerRunning = false;
+bool writerStop = false;
+unsigned long flushRequested = 0;
+unsigned long flushDone = 0;
+
+atomic<unsigned long> writtenCount(0);
+atomic<unsigned long> stallCount(0);
+atomic<uint32_t> nextThread(0);
+atomic<int> currentFormat(static_cast<int>(LogFormat::TEXT));
+mutex syncMtx;
+
+const char* const EVENT_NAMES[] = {
+    "LOT_INIT", "PARKING_EMERGENCY", "PARKING_REFUSED", "WAITING_FULL",
+    "WAITING_RESERVED", "SPOT_UNAVAILABLE", "SPOT_ACQUIRED", "WAITING_RELEASED",
+    "PARKING_LEFT", "VEHICLE_ARRIVED", "VEHICLE_PARKED", "VEHICLE_CROSSED",
+    "ACCESS_REQUEST", "EMERGENCY_NOTIFY", "CROSSING", "CROSSING_NOT_FOUND",
+    "EMERGENCY_PHASE", "CYCLE_START", "CYCLE_END", "PHASE_GREEN", "PHASE_RED",
+    "VEHICLE_HANDOFF", "VEHICLE_TRANSFERRED", "PREEMPT_GREEN"
+};
+
+const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN"};
+
+struct ThreadState {
+    uint32_t thread;
+    LogRing* ring;
+
+    ThreadState() : thread(nextThread++), ring(nullptr) {}
+
+    ~ThreadState() {
+        if (!ring) {
+            return;
+        }
+        lock_guard<mutex> lock(registryMtx);
+        if (writerRunning) {
+            ring->retired = true; // the writer frees it after draining
+        } else {
+            rings.erase(remove(rings.begin(), rings.end(), ring), rings.end());
+            delete ring;
+        }
+    }
+};
+
+thread_local ThreadState self;
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void copyField(char* dst, size_t size, const string &src) {
+    size_t n = min(src.size(), size - 1);
+    memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+void formatText(const LogRecord &r, string &out) {
+    char buf[320];
+    int id = r.vehicleId;
+    const char* t = r.type;
+    int n = 0;
+
+    switch (r.event) {
+    case LogEvent::LOT_INIT:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s initialized with:\n  Parking spots: %d\n  Waiting spots: %d",
+                     r.site, r.value, r.value2);
+        break;
+    case LogEvent::PARKING_EMERGENCY:
+        n = snprintf(buf, sizeof(buf), "Emergency vehicles cannot request parking.");
+        break;
+    case LogEvent::PARKING_REFUSED:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s -> Vehicle %d (%s) cannot park here.", r.site, id, t);
+        break;
+    case LogEvent::WAITING_FULL:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s waiting queue full. Vehicle %d (%s) cannot enter waiting queue.",
+                     r.site, id, t);
+        break;
+    case LogEvent::WAITING_RESERVED:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s -> Vehicle %d (%s) obtained a waiting spot in waiting queue.",
+                     r.site, id, t);
+        break;
+    case LogEvent::SPOT_UNAVAILABLE:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s -> Vehicle %d (%s) could not obtain parking spot.", r.site, id, t);
+        break;
+    case LogEvent::SPOT_ACQUIRED:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s -> Vehicle %d (%s) obtained a parking spot.", r.site, id, t);
+        break;
+    case LogEvent::WAITING_RELEASED:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s -> Vehicle %d (%s) released a waiting spot.", r.site, id, t);
+        break;
+    case LogEvent::PARKING_LEFT:
+        n = snprintf(buf, sizeof(buf), "[ParkingLot] %s -> Vehicle %d (%s) has left the parking lot.", r.site, id, t);
+        break;
+    case LogEvent::VEHICLE_ARRIVED:
+        n = snprintf(buf, sizeof(buf), "[Vehicle] %s -> Vehicle %d (%s) has arrived at its intersection.", r.site, id, t);
+        break;
+    case LogEvent::VEHICLE_PARKED:
+        n = snprintf(buf, sizeof(buf), "[Vehicle] %s -> Vehicle %d (%s) has parked at parking lot %s",
+                     r.site, id, t, r.peer);
+        break;
+    case LogEvent::VEHICLE_CROSSED:
+        n = snprintf(buf, sizeof(buf), "[Vehicle] %s -> Vehicle %d (%s) is crossing intersection %s.\n"
+                     "[Vehicle] Vehicle %d (%s) has crossed intersection %s.", r.site, id, t, r.peer, id, t, r.peer);
+        break;
+    case LogEvent::ACCESS_REQUEST:
+        n = snprintf(buf, sizeof(buf), "[%s] Vehicle %d (%s) requesting intersection access via lane %s.",
+                     r.site, id, t, r.peer);
+        break;
+    case LogEvent::EMERGENCY_NOTIFY:
+        n = snprintf(buf, sizeof(buf), "[%s] Notifying peer controller about emergency vehicle %d from %s to %s.",
+                     r.site, id, r.site, r.peer);
+        break;
+    case LogEvent::CROSSING:
+        n = snprintf(buf, sizeof(buf), "[TrafficController] Vehicle %d (%s) is crossing from %s to %s",
+                     id, t, r.site, r.peer);
+        break;
+    case LogEvent::CROSSING_NOT_FOUND:
+        n = snprintf(buf, sizeof(buf), "[TrafficController] Warning: vehicle %d is not queued in its lane; "
+                     "skipping removal.", id);
+        break;
+    case LogEvent::EMERGENCY_PHASE:
+        n = snprintf(buf, sizeof(buf), "\n[TrafficController] EMERGENCY phase: giving priority to vehicle %d (%s)", id, t);
+        break;
+    case LogEvent::CYCLE_START:
+        n = snprintf(buf, sizeof(buf), "\n[TrafficController] === Traffic light cycle %d ===", r.value);
+        break;
+    case LogEvent::CYCLE_END:
+        n = snprintf(buf, sizeof(buf), "[TrafficController] === End of cycle %d ===", r.value);
+        break;
+    case LogEvent::PHASE_GREEN:
+        n = snprintf(buf, sizeof(buf), "%s[TrafficController] Phase: %s lane GREEN", r.value ? "\n" : "", r.site);
+        break;
+    case LogEvent::PHASE_RED:
+        n = snprintf(buf, sizeof(buf), "[TrafficController] Phase: %s lane RED", r.site);
+        break;
+    case LogEvent::VEHICLE_HANDOFF:
+        n = snprintf(buf, sizeof(buf), "[%s] Vehicle %d (%s) handed off to %s (%d on the road).",
+                     r.site, id, t, r.peer, r.value);
+        break;
+    case LogEvent::VEHICLE_TRANSFERRED:
+        n = snprintf(buf, sizeof(buf), "[%s] Vehicle %d (%s) arrived over the road, queued on lane %s.",
+                     r.site, id, t, r.peer);
+        break;
+    case LogEvent::PREEMPT_GREEN:
+        n = snprintf(buf, sizeof(buf), "\n[TrafficController] Clearing lane %s for an emergency due in %d s",
+                     r.peer, r.value);
+        break;
+    }
+
+    out.append(buf, min(static_cast<size_t>(max(n, 0)), sizeof(buf) - 1));
+    out += '\n';
+}
+
+void formatFields(const LogRecord &r, string &out) {
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf),
+                     "ts_ns=%llu thread=%u level=%s event=%s vehicle=%d type=%s site=%s peer=%s value=%d value2=%d\n",
+                     static_cast<unsigned long long>(r.timeNs), r.thread,
+                     LEVEL_NAMES[static_cast<int>(r.level)], EVENT_NAMES[static_cast<int>(r.event)],
+                     r.vehicleId, r.type[0] ? r.type : "-", r.site[0] ? r.site : "-",
+                     r.peer[0] ? r.peer : "-", r.value, r.value2);
+    out.append(buf, min(static_cast<size_t>(max(n, 0)), sizeof(buf) - 1));
+}
+
+void format(const LogRecord &r, string &out) {
+    if (currentFormat.load(memory_order_relaxed) == static_cast<int>(LogFormat::FIELDS)) {
+        formatFields(r, out);
+    } else {
+        formatText(r, out);
+    }
+}
+
+// One writer pass: take whatever each ring holds, merge by timestamp (each
+// ring is already in order) and write it with a single flush.
+void drain(const vector<LogRing*> &snapshot, vector<LogRecord> &batch, string &text) {
+    batch.clear();
+    for (LogRing* ring : snapshot) {
+        size_t tail = ring->tail.load(memory_order_relaxed);
+        size_t head = ring->head.load(memory_order_acquire);
+        for (size_t i = tail; i != head; ++i) {
+            batch.push_back(ring->records[i & (RING_SIZE - 1)]);
+        }
+        ring->tail.store(head, memory_order_release);
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    stable_sort(batch.begin(), batch.end(),
+                [](const LogRecord &a, const LogRecord &b) { return a.timeNs < b.timeNs; });
+
+    text.clear();
+    for (const LogRecord &r : batch) {
+        format(r, text);
+    }
+    cout.write(text.data(), text.size());
+    cout.flush();
+    writtenCount += batch.size();
+}
+
+void* writerMain(void*) {
+    vector<LogRecord> batch;
+    string text;
+
+    unique_lock<mutex> lock(registryMtx);
+    while (true) {
+        writerCv.wait_for(lock, chrono::milliseconds(WRITER_PERIOD_MS),
+                          [] { return writerStop || flushRequested != flushDone; });
+        bool stopping = writerStop;
+        unsigned long generation = flushRequested;
+        vector<LogRing*> snapshot = rings;
+        lock.unlock();
+
+        drain(snapshot, batch, text);
+
+        lock.lock();
+        // Rings of exited threads go once they are empty. Only this thread
+        // frees rings while it runs, so the snapshot above stayed valid.
+        for (auto it = rings.begin(); it != rings.end();) {
+            LogRing* ring = *it;
+            if (ring->retired && ring->tail.load() == ring->head.load()) {
+                delete ring;
+                it = rings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        flushDone = generation;
+        flushedCv.notify_all();
+        if (stopping) {
+            return nullptr;
+        }
+    }
+}
+
+void writeSync(const LogRecord &r) {
+    thread_local string text;
+    text.clear();
+    format(r, text);
+
+    lock_guard<mutex> lock(syncMtx);
+    cout.write(text.data(), text.size());
+    cout.flush();
+    ++writtenCount;
+}
+
+void pushAsync(const LogRecord &r) {
+    LogRing* ring = self.ring;
+    if (!ring) {
+        ring = new LogRing;
+        lock_guard<mutex> lock(registryMtx);
+        rings.push_back(ring);
+        self.ring = ring;
+    }
+
+    size_t head = ring->head.load(memory_order_relaxed);
+    if (head - ring->tail.load(memory_order_acquire) >= RING_SIZE) {
+        ++stallCount;
+        do {
+            if (!Log::enabled() || Log::mode() != LogMode::ASYNC) {
+                writeSync(r); // the writer is being stopped
+                return;
+            }
+            writerCv.notify_one();
+            sched_yield();
+        } while (head - ring->tail.load(memory_order_acquire) >= RING_SIZE);
+    }
+
+    ring->records[head & (RING_SIZE - 1)] = r;
+    ring->head.store(head + 1, memory_order_release);
+
+    // Wake the writer early rather than let a busy thread fill its ring.
+    if (head + 1 - ring->tail.load(memory_order_relaxed) == RING_SIZE / 2) {
+        writerCv.notify_one();
+    }
+}
+
+} // namespace
+
+void Log::setMode(LogMode m) {
+    if (m == LogMode::ASYNC) {
+        lock_guard<mutex> lock(registryMtx);
+        if (!writerRunning) {
+            writerStop = false;
+            if (pthread_create(&writerThread, nullptr, writerMain, nullptr) != 0) {
+                cout << "[Log] pthread_create failed for writer; logging synchronously" << endl;
+                currentMode = static_cast<int>(LogMode::SYNC);
+                return;
+            }
+            writerRunning = true;
+        }
+        currentMode = static_cast<int>(m);
+        return;
+    }
+
+    currentMode = static_cast<int>(m);
+    {
+        unique_lock<mutex> lock(registryMtx);
+        if (!writerRunning) {
+            return;
+        }
+        writerStop = true;
+    }
+    writerCv.notify_all();
+    pthread_join(writerThread, nullptr); // its last pass drains every ring
+
+    lock_guard<mutex> lock(registryMtx);
+    writerRunning = false;
+    for (auto it = rings.begin(); it != rings.end();) {
+        if ((*it)->retired) {
+            delete *it;
+            it = rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+LogMode Log::mode() {
+    return static_cast<LogMode>(currentMode.load(memory_order_relaxed));
+}
+
+void Log::setFormat(LogFormat f) {
+    currentFormat = static_cast<int>(f);
+}
+
+void Log::event(LogLevel level, LogEvent e, const Vehicle* v,
+                const string &site, const string &peer, int value, int value2) {
+    LogRecord r{};
+    r.timeNs = nowNs();
+    r.thread = self.thread;
+    r.vehicleId = v ? v->getId() : -1;
+    r.value = value;
+    r.value2 = value2;
+    r.level = level;
+    r.event = e;
+    if (v) {
+        copyField(r.type, sizeof(r.type), v->getType());
+    }
+    copyField(r.site, sizeof(r.site), site);
+    copyField(r.peer, sizeof(r.peer), peer);
+
+    if (mode() == LogMode::ASYNC) {
+        pushAsync(r);
+    } else {
+        writeSync(r);
+    }
+}
+
+void Log::flush() {
+    unique_lock<mutex> lock(registryMtx);
+    if (!writerRunning) {
+        return;
+    }
+    unsigned long generation = ++flushRequested;
+    writerCv.notify_one();
+    flushedCv.wait(lock, [generation] { return flushDone >= generation || !writerRunning; });
+}
+
+unsigned long Log::written() {
+    return writtenCount.load();
+}
+
+unsigned long Log::stalls() {
+    return stallCount.load();
+}
@@ -0,0 +1,131 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+class Vehicle;
+
+// Levels below LOG_MIN_LEVEL compile out of LOG_EVENT. Release builds
+// (NDEBUG) drop the per-vehicle DEBUG events.
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// LOG_EVENT(INFO, LogEvent::CROSSING, v, origin, destination[, value]).
+// Arguments are not evaluated when the level is compiled out or logging
+// is off.
+#define LOG_EVENT(level, ...)                                              \
+    do {                                                                   \
+        if (LOG_LEVEL_##level >= LOG_MIN_LEVEL && Log::enabled()) {        \
+            Log::event(static_cast<LogLevel>(LOG_LEVEL_##level), __VA_ARGS__); \
+        }                                                                  \
+    } while (0)
+
+enum class LogLevel : uint8_t {
+    DEBUG = LOG_LEVEL_DEBUG,
+    INFO = LOG_LEVEL_INFO,
+    WARN = LOG_LEVEL_WARN
+};
+
+enum class LogMode {
+    OFF,   // records are discarded
+    ASYNC, // per-thread buffers, written by a background thread
+    SYNC   // formatted and flushed by the logging thread, one at a time
+};
+
+enum class LogFormat {
+    TEXT,  // the simulator's human-readable messages
+    FIELDS // key=value records: ts_ns, thread, level, event, vehicle, ...
+};
+
+// What happened. Each event renders to one message; `site` and `peer` are
+// the lot, intersection or lane names the message mentions.
+enum class LogEvent : uint8_t {
+    LOT_INIT,           // site=lot, value=spots, value2=waiting spots
+    PARKING_EMERGENCY,  // emergency vehicle asked to park
+    PARKING_REFUSED,    // site=lot
+    WAITING_FULL,       // site=lot
+    WAITING_RESERVED,   // site=lot
+    SPOT_UNAVAILABLE,   // site=lot
+    SPOT_ACQUIRED,      // site=lot
+    WAITING_RELEASED,   // site=lot
+    PARKING_LEFT,       // site=lot
+    VEHICLE_ARRIVED,    // site=origin
+    VEHICLE_PARKED,     // site=origin, peer=lot
+    VEHICLE_CROSSED,    // site=origin, peer=destination (no controller)
+    ACCESS_REQUEST,     // site=intersection, peer=lane
+    EMERGENCY_NOTIFY,   // site=origin, peer=destination
+    CROSSING,           // site=origin, peer=destination
+    CROSSING_NOT_FOUND,
+    EMERGENCY_PHASE,
+    CYCLE_START,        // value=cycle
+    CYCLE_END,          // value=cycle
+    PHASE_GREEN,        // site=phase name, value=1 for a blank line before it
+    PHASE_RED,          // site=phase name
+    VEHICLE_HANDOFF,    // site=from, peer=to, value=vehicles on the road
+    VEHICLE_TRANSFERRED,// site=intersection, peer=lane
+    PREEMPT_GREEN       // site=phase name, peer=lane, value=seconds until the emergency is due
+};
+
+// One log entry, a cache line. Strings are copied (and truncated) so the
+// writer never touches objects that may be gone by the time it runs.
+struct LogRecord {
+    uint64_t timeNs;   // CLOCK_MONOTONIC
+    uint32_t thread;   // small per-process thread number
+    int32_t vehicleId; // -1 if none
+    int32_t value;
+    int32_t value2;
+    LogLevel level;
+    LogEvent event;
+    char type[12];
+    char site[12];
+    char peer[12];
+};
+
+// Process-wide event log. In ASYNC mode each thread appends to its own
+// lock-free ring and a background thread merges the rings by timestamp and
+// writes them to cout in batches. Threads created by fork() must call
+// setMode() again; the writer thread does not survive the fork.
+class Log {
+public:
+    // Starts or stops the writer thread as needed. The default is SYNC.
+    static void setMode(LogMode mode);
+    static LogMode mode();
+
+    static void setFormat(LogFormat format);
+
+    static bool enabled() {
+        return currentMode.load(memory_order_relaxed) != static_cast<int>(LogMode::OFF);
+    }
+
+    // Use LOG_EVENT rather than calling these directly.
+    static void event(LogLevel level, LogEvent e, const Vehicle* v,
+                      const string &site = string(), const string &peer = string(),
+                      int value = 0, int value2 = 0);
+
+    // Block until everything logged before the call has been written.
+    static void flush();
+
+    // Records written so far, and how often a thread found its ring full
+    // and had to wait for the writer.
+    static unsigned long written();
+    static unsigned long stalls();
+
+private:
+    static atomic<int> currentMode;
+};
+
+#endif
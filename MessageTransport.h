@@ -0,0 +1,31 @@
+#ifndef MESSAGE_TRANSPORT_H
+#define MESSAGE_TRANSPORT_H
+
+#include <vector>
+#include "TrafficController.h"
+
+using namespace std;
+
+// How two controller processes exchange ControllerMessages. Implemented by
+// ControllerChannel (pipes) and ShmTransport (shared-memory rings); the
+// controller process picks one at startup.
+class MessageTransport {
+public:
+    virtual ~MessageTransport() {}
+
+    // Send one message. Thread-safe. May only queue it until flush().
+    virtual bool send(const ControllerMessage &msg) = 0;
+
+    // Make every message sent so far visible to the peer.
+    virtual bool flush() = 0;
+
+    // Wait up to timeoutMs (-1 = forever) and append every available
+    // message to out. Returns the number appended, 0 on timeout, or -1 once
+    // the peer has closed and nothing is left. Single reader only.
+    virtual int receive(vector<ControllerMessage> &out, int timeoutMs) = 0;
+
+    // Flush, then tell the peer no more messages will come.
+    virtual void closeSend() = 0;
+};
+
+#endif
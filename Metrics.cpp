@@ -0,0 +1,479 @@
+#include "Metrics.h"
+#include "Vehicle.h"
+#include "Intersection.h"
+
+#include <vector>
+#include <mutex>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cerrno>
+
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+atomic<bool> Metrics::on(false);
+
+namespace {
+
+const int COUNTERS = static_cast<int>(MetricCounter::COUNT);
+const int HISTOGRAMS = static_cast<int>(MetricHistogram::COUNT);
+
+// Written only by the owning thread, read by snapshot().
+struct Shard {
+    atomic<uint64_t> counters[COUNTERS];
+    atomic<uint64_t> counts[HISTOGRAMS];
+    atomic<uint64_t> sums[HISTOGRAMS];
+    atomic<atomic<uint64_t>*> buckets[HISTOGRAMS]; // nullptr until first record
+    Shard* nextFree;
+
+    Shard() : nextFree(nullptr) {
+        for (auto &c : counters) c.store(0, memory_order_relaxed);
+        for (auto &c : counts) c.store(0, memory_order_relaxed);
+        for (auto &s : sums) s.store(0, memory_order_relaxed);
+        for (auto &b : buckets) b.store(nullptr, memory_order_relaxed);
+    }
+};
+
+mutex registryMtx; // guards shards, freeShards and instanceName
+vector<Shard*> shards;
+Shard* freeShards = nullptr;
+string instanceName;
+
+struct ThreadState {
+    Shard* shard = nullptr;
+
+    ~ThreadState() {
+        if (!shard) {
+            return;
+        }
+        // Keep the totals; the next new thread records on top of them.
+        lock_guard<mutex> lock(registryMtx);
+        shard->nextFree = freeShards;
+        freeShards = shard;
+    }
+};
+
+thread_local ThreadState self;
+
+Shard* threadShard() {
+    if (!self.shard) {
+        lock_guard<mutex> lock(registryMtx);
+        if (freeShards) {
+            self.shard = freeShards;
+            freeShards = freeShards->nextFree;
+        } else {
+            self.shard = new Shard();
+            shards.push_back(self.shard);
+        }
+    }
+    return self.shard;
+}
+
+// The owner is the only writer, so no read-modify-write is needed.
+inline void bump(atomic<uint64_t> &a, uint64_t n) {
+    a.store(a.load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+const char* const COUNTER_NAMES[] = {
+    "vehicles_arrived", "vehicles_crossed", "emergency_preemptions", "green_phases",
+    "vehicles_parked", "parking_left", "parking_turned_away",
+    "messages_sent", "messages_received"
+};
+
+// Histograms are exported as families with at most one label.
+struct HistogramName {
+    const char* family;
+    const char* label; // nullptr if none
+    const char* value;
+};
+
+const HistogramName HISTOGRAM_NAMES[] = {
+    {"queue_length", "lane", "north"},
+    {"queue_length", "lane", "south"},
+    {"queue_length", "lane", "east"},
+    {"queue_length", "lane", "west"},
+    {"wait_ms", "type", "car"},
+    {"wait_ms", "type", "bike"},
+    {"wait_ms", "type", "bus"},
+    {"wait_ms", "type", "tractor"},
+    {"wait_ms", "type", "ambulance"},
+    {"wait_ms", "type", "firetruck"},
+    {"wait_ms", "type", "other"},
+    {"parking_occupancy", nullptr, nullptr},
+    {"preemption_latency_ms", nullptr, nullptr},
+    {"ipc_latency_us", nullptr, nullptr}
+};
+
+const double QUANTILES[] = {0.5, 0.9, 0.99};
+const char* const QUANTILE_KEYS[] = {"p50", "p90", "p99"};
+
+void appendf(string &out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void appendf(string &out, const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out.append(buf, min(static_cast<size_t>(n), sizeof(buf) - 1));
+    }
+}
+
+void renderJson(const MetricsSnapshot &s, const string &instance, string &out) {
+    appendf(out, "{\"instance\":\"%s\",\"time_ns\":%llu,\"counters\":{", instance.c_str(),
+            static_cast<unsigned long long>(s.timeNs));
+    for (int i = 0; i < COUNTERS; ++i) {
+        appendf(out, "%s\"%s\":%llu", i ? "," : "", COUNTER_NAMES[i],
+                static_cast<unsigned long long>(s.counters[i]));
+    }
+    appendf(out, "},\"gauges\":{\"queued\":%lld,\"parked\":%lld},\"histograms\":{",
+            static_cast<long long>(s.counter(MetricCounter::VEHICLES_ARRIVED) - s.counter(MetricCounter::VEHICLES_CROSSED)),
+            static_cast<long long>(s.counter(MetricCounter::VEHICLES_PARKED) - s.counter(MetricCounter::PARKING_LEFT)));
+    for (int i = 0; i < HISTOGRAMS; ++i) {
+        const HistogramName &n = HISTOGRAM_NAMES[i];
+        const HistogramSnapshot &h = s.histograms[i];
+        appendf(out, "%s\"%s%s%s\":{\"count\":%llu,\"sum\":%llu,\"mean\":%.3f", i ? "," : "",
+                n.family, n.value ? "_" : "", n.value ? n.value : "",
+                static_cast<unsigned long long>(h.count), static_cast<unsigned long long>(h.sum), h.mean());
+        for (int q = 0; q < 3; ++q) {
+            appendf(out, ",\"%s\":%llu", QUANTILE_KEYS[q],
+                    static_cast<unsigned long long>(h.quantile(QUANTILES[q])));
+        }
+        appendf(out, ",\"max\":%llu}", static_cast<unsigned long long>(h.max()));
+    }
+    out += "}}\n";
+}
+
+void renderPrometheus(const MetricsSnapshot &s, const string &instance, string &out) {
+    const char* inst = instance.c_str();
+    for (int i = 0; i < COUNTERS; ++i) {
+        appendf(out, "# TYPE tms_%s_total counter\ntms_%s_total{instance=\"%s\"} %llu\n",
+                COUNTER_NAMES[i], COUNTER_NAMES[i], inst, static_cast<unsigned long long>(s.counters[i]));
+    }
+    appendf(out, "# TYPE tms_queued gauge\ntms_queued{instance=\"%s\"} %lld\n", inst,
+            static_cast<long long>(s.counter(MetricCounter::VEHICLES_ARRIVED) - s.counter(MetricCounter::VEHICLES_CROSSED)));
+    appendf(out, "# TYPE tms_parked gauge\ntms_parked{instance=\"%s\"} %lld\n", inst,
+            static_cast<long long>(s.counter(MetricCounter::VEHICLES_PARKED) - s.counter(MetricCounter::PARKING_LEFT)));
+
+    const char* lastFamily = "";
+    for (int i = 0; i < HISTOGRAMS; ++i) {
+        const HistogramName &n = HISTOGRAM_NAMES[i];
+        const HistogramSnapshot &h = s.histograms[i];
+        if (strcmp(n.family, lastFamily) != 0) {
+            appendf(out, "# TYPE tms_%s summary\n", n.family);
+            lastFamily = n.family;
+        }
+        char labels[96];
+        if (n.label) {
+            snprintf(labels, sizeof(labels), "instance=\"%s\",%s=\"%s\"", inst, n.label, n.value);
+        } else {
+            snprintf(labels, sizeof(labels), "instance=\"%s\"", inst);
+        }
+        for (double q : QUANTILES) {
+            appendf(out, "tms_%s{%s,quantile=\"%g\"} %llu\n", n.family, labels, q,
+                    static_cast<unsigned long long>(h.quantile(q)));
+        }
+        appendf(out, "tms_%s_sum{%s} %llu\ntms_%s_count{%s} %llu\n",
+                n.family, labels, static_cast<unsigned long long>(h.sum),
+                n.family, labels, static_cast<unsigned long long>(h.count));
+    }
+}
+
+// Exporter thread state; guarded by exporterMtx.
+mutex exporterMtx;
+MetricsExport exportConfig;
+pthread_t exporterThread;
+bool exporterRunning = false;
+int stopPipe[2] = {-1, -1};
+int listenFd = -1;
+
+void publish(const MetricsExport &e, int clientFd) {
+    MetricsSnapshot* s = new MetricsSnapshot;
+    Metrics::snapshot(*s);
+    string text;
+    Metrics::render(*s, e.format, text);
+    delete s;
+
+    if (clientFd >= 0) {
+        size_t done = 0;
+        while (done < text.size()) {
+            ssize_t n = send(clientFd, text.data() + done, text.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        return;
+    }
+
+    // Write beside the target and rename, so readers never see half a file.
+    string tmp = e.path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        return;
+    }
+    fwrite(text.data(), 1, text.size(), f);
+    fclose(f);
+    rename(tmp.c_str(), e.path.c_str());
+}
+
+void* runExporter(void*) {
+    MetricsExport e;
+    int wakeFd, sockFd;
+    {
+        lock_guard<mutex> lock(exporterMtx);
+        e = exportConfig;
+        wakeFd = stopPipe[0];
+        sockFd = listenFd;
+    }
+
+    uint64_t next = nowNs() + e.intervalMs * 1000000ull;
+    while (true) {
+        uint64_t now = nowNs();
+        int timeoutMs = next > now ? static_cast<int>((next - now + 999999) / 1000000) : 0;
+        pollfd fds[2] = {{wakeFd, POLLIN, 0}, {sockFd, POLLIN, 0}};
+        int ready = poll(fds, sockFd >= 0 ? 2 : 1, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready > 0 && fds[0].revents) {
+            break; // stopExporter
+        }
+        if (ready > 0 && sockFd >= 0 && (fds[1].revents & POLLIN)) {
+            int client = accept(sockFd, nullptr, nullptr);
+            if (client >= 0) {
+                publish(e, client);
+                close(client);
+            }
+        }
+        if (nowNs() >= next) {
+            if (sockFd < 0) {
+                publish(e, -1);
+            }
+            next += e.intervalMs * 1000000ull;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int MetricBuckets::indexOf(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_COUNT)) {
+        return static_cast<int>(value);
+    }
+    int e = 63 - __builtin_clzll(value);
+    if (e >= MAX_BITS) {
+        return COUNT - 1;
+    }
+    return (e - SUB_BITS + 1) * SUB_COUNT + static_cast<int>((value >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+}
+
+uint64_t MetricBuckets::lowerBound(int index) {
+    if (index < SUB_COUNT) {
+        return index;
+    }
+    int e = index / SUB_COUNT + SUB_BITS - 1;
+    return static_cast<uint64_t>(SUB_COUNT + index % SUB_COUNT) << (e - SUB_BITS);
+}
+
+uint64_t MetricBuckets::upperBound(int index) {
+    if (index < SUB_COUNT) {
+        return index;
+    }
+    int e = index / SUB_COUNT + SUB_BITS - 1;
+    return lowerBound(index) + (1ull << (e - SUB_BITS)) - 1;
+}
+
+uint64_t HistogramSnapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * count + 0.999999);
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+    uint64_t seen = 0;
+    for (int i = 0; i < MetricBuckets::COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return MetricBuckets::upperBound(i);
+        }
+    }
+    return MetricBuckets::upperBound(MetricBuckets::COUNT - 1);
+}
+
+void Metrics::setEnabled(bool enable) {
+    on.store(enable, memory_order_relaxed);
+}
+
+void Metrics::setInstance(const string &name) {
+    lock_guard<mutex> lock(registryMtx);
+    instanceName = name;
+}
+
+string Metrics::instance() {
+    lock_guard<mutex> lock(registryMtx);
+    return instanceName;
+}
+
+void Metrics::add(MetricCounter c, uint64_t n) {
+    bump(threadShard()->counters[static_cast<int>(c)], n);
+}
+
+void Metrics::observe(MetricHistogram h, uint64_t value) {
+    Shard* s = threadShard();
+    int i = static_cast<int>(h);
+    atomic<uint64_t>* b = s->buckets[i].load(memory_order_relaxed);
+    if (!b) {
+        b = new atomic<uint64_t>[MetricBuckets::COUNT]();
+        s->buckets[i].store(b, memory_order_release);
+    }
+    bump(b[MetricBuckets::indexOf(value)], 1);
+    bump(s->sums[i], value);
+    bump(s->counts[i], 1);
+}
+
+void Metrics::recordQueueLength(Direction lane, int length) {
+    if (enabled()) {
+        observe(static_cast<MetricHistogram>(static_cast<int>(MetricHistogram::QUEUE_LENGTH_NORTH) + directionIndex(lane)),
+                length > 0 ? length : 0);
+    }
+}
+
+void Metrics::recordWait(VehicleType type, uint64_t ms) {
+    if (enabled()) {
+        observe(static_cast<MetricHistogram>(static_cast<int>(MetricHistogram::WAIT_CAR) + static_cast<int>(type)), ms);
+    }
+}
+
+void Metrics::snapshot(MetricsSnapshot &out) {
+    memset(&out, 0, sizeof(out));
+    lock_guard<mutex> lock(registryMtx);
+    out.timeNs = nowNs();
+    for (Shard* s : shards) {
+        for (int i = 0; i < COUNTERS; ++i) {
+            out.counters[i] += s->counters[i].load(memory_order_relaxed);
+        }
+        for (int i = 0; i < HISTOGRAMS; ++i) {
+            atomic<uint64_t>* b = s->buckets[i].load(memory_order_acquire);
+            if (!b) {
+                continue;
+            }
+            HistogramSnapshot &h = out.histograms[i];
+            h.count += s->counts[i].load(memory_order_relaxed);
+            h.sum += s->sums[i].load(memory_order_relaxed);
+            for (int j = 0; j < MetricBuckets::COUNT; ++j) {
+                h.buckets[j] += b[j].load(memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void Metrics::render(const MetricsSnapshot &s, MetricsFormat format, string &out) {
+    string name = instance();
+    if (format == MetricsFormat::PROMETHEUS) {
+        renderPrometheus(s, name, out);
+    } else {
+        renderJson(s, name, out);
+    }
+}
+
+bool Metrics::startExporter(const MetricsExport &e) {
+    stopExporter();
+
+    int sockFd = -1;
+    if (e.unixSocket) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (e.path.size() >= sizeof(addr.sun_path)) {
+            cout << "[Metrics] Socket path too long: " << e.path << endl;
+            return false;
+        }
+        strncpy(addr.sun_path, e.path.c_str(), sizeof(addr.sun_path) - 1);
+        sockFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(e.path.c_str());
+        if (sockFd < 0 || bind(sockFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(sockFd, 8) < 0) {
+            cout << "[Metrics] Cannot listen on " << e.path << ": " << strerror(errno) << endl;
+            if (sockFd >= 0) close(sockFd);
+            return false;
+        }
+    }
+
+    lock_guard<mutex> lock(exporterMtx);
+    if (pipe(stopPipe) < 0) {
+        cout << "[Metrics] pipe failed: " << strerror(errno) << endl;
+        if (sockFd >= 0) close(sockFd);
+        return false;
+    }
+    exportConfig = e;
+    if (exportConfig.intervalMs <= 0) {
+        exportConfig.intervalMs = 1000;
+    }
+    listenFd = sockFd;
+    setEnabled(true);
+    if (pthread_create(&exporterThread, nullptr, runExporter, nullptr) != 0) {
+        cout << "[Metrics] pthread_create failed for the exporter" << endl;
+        close(stopPipe[0]);
+        close(stopPipe[1]);
+        stopPipe[0] = stopPipe[1] = -1;
+        if (sockFd >= 0) close(sockFd);
+        listenFd = -1;
+        return false;
+    }
+    exporterRunning = true;
+    return true;
+}
+
+void Metrics::stopExporter() {
+    MetricsExport e;
+    {
+        lock_guard<mutex> lock(exporterMtx);
+        if (!exporterRunning) {
+            return;
+        }
+        exporterRunning = false;
+        e = exportConfig;
+        ssize_t n = write(stopPipe[1], "x", 1);
+        (void)n;
+    }
+    pthread_join(exporterThread, nullptr);
+
+    lock_guard<mutex> lock(exporterMtx);
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    stopPipe[0] = stopPipe[1] = -1;
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(e.path.c_str());
+        listenFd = -1;
+    } else {
+        publish(e, -1); // the final totals
+    }
+}
+
+void Metrics::reset() {
+    lock_guard<mutex> lock(registryMtx);
+    for (Shard* s : shards) {
+        for (auto &c : s->counters) c.store(0, memory_order_relaxed);
+        for (int i = 0; i < HISTOGRAMS; ++i) {
+            s->counts[i].store(0, memory_order_relaxed);
+            s->sums[i].store(0, memory_order_relaxed);
+            if (atomic<uint64_t>* b = s->buckets[i].load(memory_order_relaxed)) {
+                for (int j = 0; j < MetricBuckets::COUNT; ++j) {
+                    b[j].store(0, memory_order_relaxed);
+                }
+            }
+        }
+    }
+}
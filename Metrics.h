@@ -0,0 +1,148 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+enum class VehicleType : uint8_t;
+enum class Direction : uint8_t;
+
+// Running totals.
+enum class MetricCounter : uint8_t {
+    VEHICLES_ARRIVED,      // queued at an intersection
+    VEHICLES_CROSSED,      // released by a controller
+    EMERGENCY_PREEMPTIONS, // steps that gave the intersection to an emergency
+    GREEN_PHASES,          // phases turned green
+    VEHICLES_PARKED,       // parking spots taken
+    PARKING_LEFT,          // parking spots given back
+    PARKING_TURNED_AWAY,   // waiting area full
+    MESSAGES_SENT,         // controller messages handed to a transport
+    MESSAGES_RECEIVED,     // controller messages taken from a transport
+    COUNT
+};
+
+// Distributions. One wait histogram per VehicleType and one queue length
+// histogram per approach, in enum order.
+enum class MetricHistogram : uint8_t {
+    QUEUE_LENGTH_NORTH,  // vehicles queued, sampled at each controller step
+    QUEUE_LENGTH_SOUTH,
+    QUEUE_LENGTH_EAST,
+    QUEUE_LENGTH_WEST,
+    WAIT_CAR,            // arrival to crossing, controller milliseconds
+    WAIT_BIKE,
+    WAIT_BUS,
+    WAIT_TRACTOR,
+    WAIT_AMBULANCE,
+    WAIT_FIRETRUCK,
+    WAIT_OTHER,
+    PARKING_OCCUPANCY,   // spots taken, sampled at each park and leave
+    PREEMPTION_LATENCY,  // emergency arrival to its release, controller milliseconds
+    IPC_LATENCY,         // message send to receive, microseconds
+    COUNT
+};
+
+enum class MetricsFormat {
+    JSON,
+    PROMETHEUS // text exposition format, histograms as summaries
+};
+
+// Log-linear buckets in the style of HdrHistogram: exact below 32, then 32
+// buckets per power of two (about 3% relative error) up to 2^36.
+struct MetricBuckets {
+    static const int SUB_BITS = 5;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int MAX_BITS = 36;
+    static const int COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    static int indexOf(uint64_t value);
+    static uint64_t lowerBound(int index);
+    static uint64_t upperBound(int index); // last value in the bucket
+};
+
+// Merged state of one histogram.
+struct HistogramSnapshot {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t buckets[MetricBuckets::COUNT];
+
+    // Value at quantile q in [0, 1]: the upper end of the bucket holding
+    // it, so never an underestimate. 0 when empty.
+    uint64_t quantile(double q) const;
+    uint64_t max() const { return quantile(1.0); }
+    double mean() const { return count ? static_cast<double>(sum) / count : 0; }
+};
+
+// Everything recorded in this process so far, summed over threads.
+struct MetricsSnapshot {
+    uint64_t timeNs; // CLOCK_MONOTONIC when taken
+    uint64_t counters[static_cast<int>(MetricCounter::COUNT)];
+    HistogramSnapshot histograms[static_cast<int>(MetricHistogram::COUNT)];
+
+    uint64_t counter(MetricCounter c) const { return counters[static_cast<int>(c)]; }
+    const HistogramSnapshot& histogram(MetricHistogram h) const {
+        return histograms[static_cast<int>(h)];
+    }
+};
+
+// Where and how often the exporter publishes snapshots.
+struct MetricsExport {
+    string path;           // file, or Unix socket path if unixSocket
+    bool unixSocket = false;
+    MetricsFormat format = MetricsFormat::JSON;
+    int intervalMs = 1000;
+};
+
+// Process-wide metrics. Each thread records into its own shard with plain
+// relaxed stores, so recording never contends; snapshot() sums the shards.
+// A shard outlives its thread and is handed to the next new thread, so
+// totals survive thread exits. Histogram buckets are allocated on a
+// thread's first record into that histogram.
+//
+// The exporter thread takes a snapshot every intervalMs and writes it to a
+// file (replaced atomically) or serves it on a Unix socket, one snapshot
+// per connection. As with Log, a fork()ed process must start its own.
+class Metrics {
+public:
+    // Recording is off (and costs one load) until enabled.
+    static void setEnabled(bool on);
+    static bool enabled() { return on.load(memory_order_relaxed); }
+
+    // Name reported with every snapshot, e.g. the controller's intersection.
+    static void setInstance(const string &name);
+    static string instance();
+
+    static void count(MetricCounter c, uint64_t n = 1) {
+        if (enabled()) add(c, n);
+    }
+    static void record(MetricHistogram h, uint64_t value) {
+        if (enabled()) observe(h, value);
+    }
+
+    static void recordQueueLength(Direction lane, int length);
+    static void recordWait(VehicleType type, uint64_t ms);
+
+    static void snapshot(MetricsSnapshot &out);
+    static void render(const MetricsSnapshot &s, MetricsFormat format, string &out);
+
+    // Start publishing snapshots. Returns false (and prints why) if the
+    // socket cannot be bound. Replaces a running exporter.
+    static bool startExporter(const MetricsExport &e);
+
+    // Publish a final snapshot and stop the exporter thread.
+    static void stopExporter();
+
+    // Zero every shard. Only for benchmarks between runs.
+    static void reset();
+
+private:
+    static void add(MetricCounter c, uint64_t n);
+    static void observe(MetricHistogram h, uint64_t value);
+
+    static atomic<bool> on;
+};
+
+#endif
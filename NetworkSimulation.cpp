@@ -0,0 +1,437 @@
+#include "NetworkSimulation.h"
+#include "PhasePolicy.h"
+#include "PhasePlan.h"
+#include "VehicleStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+
+NetworkSimulation::Node::Node(const string &name, int greenDuration)
+    : lot(name, 10, 15),
+      intersection(&lot),
+      controller(&intersection, greenDuration),
+      sim(intersection, controller, &lot),
+      parity(0) {}
+
+NetworkSimulation::NetworkSimulation(const RoadNetwork &net, int greenDuration)
+    : network(net), linkStates(new LinkState[net.linkCount()]), guide(RoadNetwork::BLOCK_METRES), preemption(true),
+      forwarded(0), delivered(0), redirects(0), handedOff(0), tripsDone(0), tripSeconds(0), tripHops(0),
+      emergencyTrips(0), emergencyTripSeconds(0) {
+    for (int i = 0; i < network.nodeCount(); ++i) {
+        nodes.emplace_back(new Node(network.nodeName(i), greenDuration));
+        guide.addLot(&nodes[i]->lot, network.nodeX(i), network.nodeY(i));
+
+        uint32_t id = NameTable::intern(network.nodeName(i));
+        if (id >= nodeByName.size()) {
+            nodeByName.resize(id + 1, -1);
+        }
+        nodeByName[id] = i;
+    }
+    for (int i = 0; i < network.linkCount(); ++i) {
+        linkStates[i].occupancy = 0;
+        linkStates[i].freed[0] = 0;
+        linkStates[i].freed[1] = 0;
+    }
+    for (int i = 0; i < network.nodeCount(); ++i) {
+        installHooks(i);
+    }
+}
+
+NetworkSimulation::~NetworkSimulation() {
+    for (unique_ptr<Node> &node : nodes) {
+        for (Vehicle* v : node->vehicles) {
+            VehicleStore::destroy(v);
+        }
+        for (auto &t : node->trips) {
+            VehicleStore::destroy(t.first);
+        }
+        for (Vehicle* v : node->done) {
+            VehicleStore::destroy(v);
+        }
+    }
+}
+
+void NetworkSimulation::installHooks(int node) {
+    Node* n = nodes[node].get();
+    n->hooks.requestIntersectionAccess = [this, n, node](Vehicle* veh) {
+        Direction approach = veh->getApproach();
+        n->intersection.addVehicle(approach, veh);
+
+        // Tell the destination controller an emergency vehicle is coming.
+        int dest = veh->isEmergency() ? network.findNode(veh->getDestination()) : -1;
+        if (dest >= 0 && dest != node) {
+            ControllerMessage msg{};
+            msg.vehicleId       = veh->getId();
+            msg.priority        = veh->getPriority();
+            msg.isEmergency     = true;
+            msg.originNode      = node;
+            msg.destinationNode = dest;
+            strncpy(msg.type, veh->getType().c_str(), sizeof(msg.type) - 1);
+            strncpy(msg.origin, veh->getOrigin().c_str(), sizeof(msg.origin) - 1);
+            strncpy(msg.destination, veh->getDestination().c_str(), sizeof(msg.destination) - 1);
+            strncpy(msg.approach, directionShortName(approach), sizeof(msg.approach) - 1);
+            strncpy(msg.movement, movementName(veh->getMovement()).c_str(), sizeof(msg.movement) - 1);
+            routeMessage(node, msg, n->sim.now());
+        }
+        if (veh->isEmergency()) {
+            announceEmergency(node, veh, n->sim.now());
+        }
+    };
+    n->hooks.parkingFallback = [this, node](Vehicle* veh) {
+        ParkingLot* lot = guide.reserve(veh, network.nodeX(node), network.nodeY(node));
+        if (lot) {
+            redirects.fetch_add(1, memory_order_relaxed);
+        }
+        return lot;
+    };
+    n->controller.setDepartureCheck([this, node](const Vehicle* veh) { return mayDepart(node, veh); });
+    n->controller.setCrossingCallback([this, node](Vehicle* veh) { vehicleCrossed(node, veh); });
+}
+
+int NetworkSimulation::nodeOf(uint32_t nameId) const {
+    return nameId < nodeByName.size() ? nodeByName[nameId] : -1;
+}
+
+int NetworkSimulation::onwardLink(int node, const Vehicle* v) const {
+    int dest = nodeOf(v->getDestinationId());
+    return dest < 0 ? -1 : network.nextHop(node, dest);
+}
+
+void NetworkSimulation::setMovement(int node, Vehicle* v) const {
+    // A link entering its far node from the west leaves this one eastward.
+    int li = onwardLink(node, v);
+    v->setMovement(li < 0 ? Movement::STRAIGHT
+                          : movementTo(v->getApproach(), opposite(network.link(li).approach)));
+}
+
+bool NetworkSimulation::mayDepart(int node, const Vehicle* v) const {
+    int li = onwardLink(node, v);
+    return li < 0 || linkStates[li].occupancy < network.link(li).capacity;
+}
+
+void NetworkSimulation::vehicleCrossed(int node, Vehicle* v) {
+    Node* n = nodes[node].get();
+    Trip trip{-1, v->getArrivalTime(), 0};
+    auto it = n->trips.find(v);
+    if (it != n->trips.end()) {
+        trip = it->second;
+        n->trips.erase(it);
+        n->done.push_back(v); // freed by this worker after the release returns
+        linkStates[trip.link].freed[n->parity].fetch_add(1, memory_order_relaxed);
+    }
+
+    int li = onwardLink(node, v);
+    if (li < 0) {
+        if (nodeOf(v->getDestinationId()) == node) {
+            tripsDone.fetch_add(1, memory_order_relaxed);
+            tripSeconds.fetch_add(n->sim.now() - trip.start, memory_order_relaxed);
+            tripHops.fetch_add(trip.hops, memory_order_relaxed);
+            if (v->isEmergency()) {
+                emergencyTrips.fetch_add(1, memory_order_relaxed);
+                emergencyTripSeconds.fetch_add(n->sim.now() - trip.start, memory_order_relaxed);
+            }
+        }
+        return;
+    }
+    const RoadLink &l = network.link(li);
+    ++linkStates[li].occupancy;
+    n->outbox.push_back(Transfer{n->sim.now() + l.travelTime, li, v->getId(), v->getTypeId(),
+                                 v->getDestinationId(), trip.start, trip.hops + 1});
+    handedOff.fetch_add(1, memory_order_relaxed);
+    if (v->isEmergency()) {
+        announceEmergency(node, v, n->sim.now());
+    }
+}
+
+void NetworkSimulation::sendTransfers(int node) {
+    Node* n = nodes[node].get();
+    for (Vehicle* v : n->done) {
+        VehicleStore::destroy(v);
+    }
+    n->done.clear();
+    if (n->outbox.empty()) {
+        return;
+    }
+
+    // One lock per target node.
+    stable_sort(n->outbox.begin(), n->outbox.end(),
+                [this](const Transfer &a, const Transfer &b) { return network.link(a.link).to < network.link(b.link).to; });
+    size_t first = 0;
+    while (first < n->outbox.size()) {
+        Node* target = nodes[network.link(n->outbox[first].link).to].get();
+        size_t last = first + 1;
+        while (last < n->outbox.size() && nodes[network.link(n->outbox[last].link).to].get() == target) {
+            ++last;
+        }
+        lock_guard<mutex> lock(target->inboxMtx);
+        vector<Transfer> &into = target->arriving[n->parity];
+        into.insert(into.end(), n->outbox.begin() + first, n->outbox.begin() + last);
+        first = last;
+    }
+    n->outbox.clear();
+}
+
+void NetworkSimulation::receiveTransfers(int node) {
+    Node* n = nodes[node].get();
+
+    // Vehicles that left this node's links in the last window make room.
+    for (int li : network.outgoing(node)) {
+        linkStates[li].occupancy -= linkStates[li].freed[n->parity ^ 1].exchange(0, memory_order_relaxed);
+    }
+
+    // Hand-offs from the last window, in an order that doesn't depend on
+    // which sender got the lock first.
+    vector<Transfer> batch;
+    {
+        lock_guard<mutex> lock(n->inboxMtx);
+        batch.swap(n->arriving[n->parity ^ 1]);
+    }
+    sort(batch.begin(), batch.end(), [](const Transfer &a, const Transfer &b) {
+        if (a.arriveAt != b.arriveAt) return a.arriveAt < b.arriveAt;
+        if (a.vehicleId != b.vehicleId) return a.vehicleId < b.vehicleId;
+        return a.link < b.link;
+    });
+    for (const Transfer &t : batch) {
+        Vehicle* v = VehicleStore::create(t.vehicleId, NameTable::name(t.type), network.nodeName(node),
+                                          NameTable::name(t.destination),
+                                          static_cast<int>(t.arriveAt));
+        v->setApproach(network.link(t.link).approach);
+        setMovement(node, v);
+        n->trips[v] = Trip{t.link, t.tripStart, t.hops};
+        n->sim.addTransfer(v, t.arriveAt);
+    }
+}
+
+void NetworkSimulation::addVehicle(int node, Vehicle* v, Direction approach) {
+    Node* n = nodes[node].get();
+    n->vehicles.push_back(v);
+    v->setApproach(approach);
+    setMovement(node, v);
+    v->setHooks(&n->hooks);
+    n->sim.addVehicle(v);
+}
+
+bool NetworkSimulation::setPhasePolicy(const string &name) {
+    if (!makePhasePolicy(name)) {
+        return false;
+    }
+    for (auto &n : nodes) {
+        n->controller.setPolicy(makePhasePolicy(name));
+    }
+    return true;
+}
+
+bool NetworkSimulation::setPhasePlan(const string &name) {
+    PhasePlan plan;
+    if (!PhasePlan::byName(name, plan)) {
+        return false;
+    }
+    for (auto &n : nodes) {
+        n->controller.setPhasePlan(plan);
+    }
+    return true;
+}
+
+void NetworkSimulation::generateTraffic(long duration, double meanGapSeconds, unsigned seed) {
+    static const char* types[] = {"car", "car", "car", "bike", "bus", "tractor", "ambulance", "firetruck"};
+
+    mt19937 rng(seed);
+    exponential_distribution<double> gap(1.0 / meanGapSeconds);
+    uniform_int_distribution<int> typeDist(0, 7);
+    uniform_int_distribution<int> destDist(0, max(0, network.nodeCount() - 1));
+
+    int nextId = 1;
+    for (int node = 0; node < network.nodeCount(); ++node) {
+        for (int lane = 0; lane < DIRECTION_COUNT; ++lane) {
+            double t = 0;
+            while ((t += gap(rng)) < duration) {
+                const string &dest = network.nodeName(destDist(rng));
+                Vehicle* v = VehicleStore::create(nextId++, types[typeDist(rng)], network.nodeName(node),
+                                         dest, static_cast<int>(t));
+                addVehicle(node, v, directionAt(lane));
+            }
+        }
+    }
+}
+
+void NetworkSimulation::routeMessage(int from, const ControllerMessage &msg, long now) {
+    int li = network.nextHop(from, msg.destinationNode);
+    if (li < 0) {
+        return; // unreachable
+    }
+    const RoadLink &l = network.link(li);
+
+    InFlight f{now + l.travelTime, now, msg};
+    ++f.msg.hops;
+
+    Node* target = nodes[l.to].get();
+    lock_guard<mutex> lock(target->inboxMtx);
+    target->inbox.push_back(f);
+    ++forwarded;
+}
+
+void NetworkSimulation::announceEmergency(int node, const Vehicle* v, long now) {
+    int dest = nodeOf(v->getDestinationId());
+    if (!preemption || dest < 0) {
+        return;
+    }
+
+    ControllerMessage msg{};
+    msg.vehicleId   = v->getId();
+    msg.priority    = v->getPriority();
+    msg.isEmergency = true;
+    msg.kind        = MessageKind::PREEMPT;
+    msg.originNode  = node;
+    strncpy(msg.type, v->getType().c_str(), sizeof(msg.type) - 1);
+    strncpy(msg.origin, network.nodeName(node).c_str(), sizeof(msg.origin) - 1);
+    strncpy(msg.movement, movementName(v->getMovement()).c_str(), sizeof(msg.movement) - 1);
+
+    // Each node on the route learns which approach to clear and when, at
+    // free-flow speed. Radio is faster than the road, but a message only
+    // takes effect in the next window, like anything else sent in this one.
+    for (int at = node; at != dest;) {
+        int li = network.nextHop(at, dest);
+        if (li < 0) {
+            return;
+        }
+        const RoadLink &l = network.link(li);
+        msg.eta += l.travelTime;
+        ++msg.hops;
+        msg.destinationNode = l.to;
+        strncpy(msg.destination, network.nodeName(l.to).c_str(), sizeof(msg.destination) - 1);
+        strncpy(msg.approach, directionShortName(l.approach), sizeof(msg.approach) - 1);
+
+        Node* target = nodes[l.to].get();
+        lock_guard<mutex> lock(target->inboxMtx);
+        target->inbox.push_back(InFlight{now + network.minTravelTime(), now, msg});
+        at = l.to;
+    }
+}
+
+void NetworkSimulation::deliverMessages(int node, long windowEnd) {
+    Node* n = nodes[node].get();
+    {
+        lock_guard<mutex> lock(n->inboxMtx);
+        n->pending.insert(n->pending.end(), n->inbox.begin(), n->inbox.end());
+        n->inbox.clear();
+    }
+    if (n->pending.empty()) {
+        return;
+    }
+
+    // Messages due in this window take effect now; later ones wait. Ties
+    // go in an order that doesn't depend on which sender got the lock first.
+    sort(n->pending.begin(), n->pending.end(), [](const InFlight &a, const InFlight &b) {
+        if (a.deliverAt != b.deliverAt) return a.deliverAt < b.deliverAt;
+        if (a.msg.vehicleId != b.msg.vehicleId) return a.msg.vehicleId < b.msg.vehicleId;
+        return a.sentAt < b.sentAt;
+    });
+    size_t due = 0;
+    Direction approach;
+    while (due < n->pending.size() && n->pending[due].deliverAt < windowEnd) {
+        const InFlight &f = n->pending[due];
+        if (f.msg.destinationNode == node) {
+            ++delivered;
+            if (f.msg.kind == MessageKind::PREEMPT && parseDirection(f.msg.approach, approach)) {
+                n->controller.requestPreemption(f.msg.vehicleId, approach, (f.sentAt + f.msg.eta) * 1000L);
+            }
+        } else {
+            routeMessage(node, f.msg, f.deliverAt);
+        }
+        ++due;
+    }
+    n->pending.erase(n->pending.begin(), n->pending.begin() + due);
+}
+
+void NetworkSimulation::workerLoop(int index, int workers, long duration) {
+    long window = network.minTravelTime();
+    int parity = 0;
+    for (long t = 0; t < duration; t += window, parity ^= 1) {
+        long end = min(t + window, duration);
+        for (int node = index; node < static_cast<int>(nodes.size()); node += workers) {
+            nodes[node]->parity = parity;
+            receiveTransfers(node);
+            deliverMessages(node, end);
+            nodes[node]->sim.runUntil(end);
+            sendTransfers(node);
+        }
+        // Everything sent in this window is in an inbox before anyone
+        // starts the next one.
+        pthread_barrier_wait(&barrier);
+    }
+}
+
+void* NetworkSimulation::workerThreadStart(void* arg) {
+    WorkerArg* wa = static_cast<WorkerArg*>(arg);
+    wa->self->workerLoop(wa->index, wa->workers, wa->duration);
+    return nullptr;
+}
+
+void NetworkSimulation::run(long duration, int workers) {
+    if (workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? static_cast<int>(cpus) : 1;
+    }
+    workers = max(1, min(workers, static_cast<int>(nodes.size())));
+
+    pthread_barrier_init(&barrier, nullptr, workers);
+    vector<WorkerArg> args(workers);
+    vector<pthread_t> tids(workers);
+    for (int i = 0; i < workers; ++i) {
+        args[i] = WorkerArg{this, i, workers, duration};
+        pthread_create(&tids[i], nullptr, workerThreadStart, &args[i]);
+    }
+    for (pthread_t tid : tids) {
+        pthread_join(tid, nullptr);
+    }
+    pthread_barrier_destroy(&barrier);
+}
+
+long NetworkSimulation::vehicleCount() const {
+    long total = 0;
+    for (const unique_ptr<Node> &node : nodes) {
+        total += static_cast<long>(node->vehicles.size());
+    }
+    return total;
+}
+
+long NetworkSimulation::crossings() const {
+    long total = 0;
+    for (const unique_ptr<Node> &node : nodes) {
+        total += node->controller.getCrossedCount();
+    }
+    return total;
+}
+
+double NetworkSimulation::meanTripSeconds() const {
+    long trips = tripsDone.load();
+    return trips > 0 ? static_cast<double>(tripSeconds.load()) / trips : 0;
+}
+
+long NetworkSimulation::spillbackHolds() const {
+    long total = 0;
+    for (const unique_ptr<Node> &node : nodes) {
+        total += node->controller.getHeldCount();
+    }
+    return total;
+}
+
+double NetworkSimulation::meanEmergencyTripSeconds() const {
+    long trips = emergencyTrips.load();
+    return trips > 0 ? static_cast<double>(emergencyTripSeconds.load()) / trips : 0;
+}
+
+long NetworkSimulation::preemptions() const {
+    long total = 0;
+    for (const unique_ptr<Node> &node : nodes) {
+        total += node->controller.getPreemptionCount();
+    }
+    return total;
+}
+
+double NetworkSimulation::meanTripHops() const {
+    long trips = tripsDone.load();
+    return trips > 0 ? static_cast<double>(tripHops.load()) / trips : 0;
+}
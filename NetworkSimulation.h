@@ -0,0 +1,190 @@
+#ifndef NETWORK_SIMULATION_H
+#define NETWORK_SIMULATION_H
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <pthread.h>
+
+#include "RoadNetwork.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "ParkingLot.h"
+#include "ParkingGuide.h"
+#include "Vehicle.h"
+
+using namespace std;
+
+// Runs one controller per RoadNetwork node in virtual time. Nodes are
+// packed onto a fixed set of worker threads and advance in lockstep windows
+// as long as the shortest link, so a message sent in one window can only
+// take effect in a later one and workers only meet at a barrier between
+// windows. ControllerMessages are forwarded hop by hop along the routing
+// table, each hop taking the link's travel time.
+//
+// Vehicles travel the same way: one that crosses an intersection short of
+// its destination is handed to the next node on its route by id and a few
+// fields, and joins that node's approach lane after the link's travel time.
+// A link holds at most `capacity` vehicles; a vehicle whose next link is
+// full waits at its stop line and blocks its lane (spillback). A node's
+// hand-offs go out in one batch per target at the end of each window.
+//
+// An emergency vehicle is announced to every node on its route ahead of it
+// with a PREEMPT message (by radio, not over the road: it takes effect in
+// the next window), which clears its approach there before it arrives; the
+// announcement is renewed each time it crosses a node (a green wave).
+class NetworkSimulation {
+public:
+    NetworkSimulation(const RoadNetwork &network, int greenDuration = 5);
+    ~NetworkSimulation();
+
+    NetworkSimulation(const NetworkSimulation&) = delete;
+    NetworkSimulation& operator=(const NetworkSimulation&) = delete;
+
+    // Queue a vehicle at `node`, entering on `approach`. Takes ownership.
+    // Its destination must be a node name. Call before run().
+    void addVehicle(int node, Vehicle* v, Direction approach);
+
+    // Poisson arrivals on every approach of every node until `duration`,
+    // with random destinations. Deterministic for a given seed.
+    void generateTraffic(long duration, double meanGapSeconds, unsigned seed);
+
+    // Give every controller a new phase policy by name (see
+    // makePhasePolicy). Returns false for an unknown name.
+    bool setPhasePolicy(const string &name);
+
+    // Give every controller a phase set by name (see PhasePlan::byName).
+    // Returns false for an unknown name.
+    bool setPhasePlan(const string &name);
+
+    // Announce emergencies along their routes (the default). Call before run().
+    void setPreemption(bool on) { preemption = on; }
+
+    // Simulate until `duration` seconds on `workers` threads (<= 0 means
+    // one per online CPU).
+    void run(long duration, int workers = 0);
+
+    long vehicleCount() const;
+    long crossings() const;
+    long messagesForwarded() const { return forwarded.load(); }
+    long messagesDelivered() const { return delivered.load(); }
+    long parkingRedirects() const { return redirects.load(); }
+
+    // Vehicles handed from one intersection to the next, trips that reached
+    // their destination intersection, and their mean duration from the
+    // first arrival to crossing the destination, and links travelled.
+    long handoffs() const { return handedOff.load(); }
+    long tripsCompleted() const { return tripsDone.load(); }
+    double meanTripSeconds() const;
+    double meanTripHops() const;
+
+    // The same for emergency vehicles only, and greens opened for them
+    // ahead of their arrival.
+    long emergencyTripsCompleted() const { return emergencyTrips.load(); }
+    double meanEmergencyTripSeconds() const;
+    long preemptions() const;
+
+    // Releases held back because the vehicle's next link was full.
+    long spillbackHolds() const;
+
+private:
+    struct InFlight {
+        long deliverAt;
+        long sentAt;
+        ControllerMessage msg;
+    };
+
+    // A vehicle on a link: what the next node needs to recreate it.
+    struct Transfer {
+        long arriveAt;
+        int link;
+        int vehicleId;
+        uint32_t type;        // NameTable ids
+        uint32_t destination;
+        int tripStart;        // when it arrived at its first intersection
+        int hops;
+    };
+
+    // Where a vehicle that came over a link started its trip.
+    struct Trip {
+        int link;
+        int start;
+        int hops;
+    };
+
+    // Only the worker running `from` changes occupancy. The worker running
+    // `to` counts vehicles leaving the link in freed[window & 1] and the
+    // sender folds that in when the next window starts, so occupancy
+    // follows the windows and not thread timing.
+    struct LinkState {
+        int occupancy;
+        atomic<int> freed[2];
+    };
+
+    struct Node {
+        Node(const string &name, int greenDuration);
+
+        ParkingLot lot;
+        Intersection intersection;
+        TrafficController controller;
+        EventSimulator sim;
+        VehicleHooks hooks;       // shared by the node's vehicles
+        vector<Vehicle*> vehicles;
+
+        mutex inboxMtx;
+        vector<InFlight> inbox;   // filled by other nodes during a window
+        vector<InFlight> pending; // owned by this node's worker
+
+        int parity;                   // window number & 1
+        vector<Transfer> arriving[2]; // by the sender's window parity, under inboxMtx
+        vector<Transfer> outbox;      // handed off during this window
+        unordered_map<Vehicle*, Trip> trips; // vehicles that came over a link
+        vector<Vehicle*> done;        // arrived over a link and crossed, freed at window end
+    };
+
+    struct WorkerArg {
+        NetworkSimulation* self;
+        int index;
+        int workers;
+        long duration;
+    };
+
+    void installHooks(int node);
+    void routeMessage(int from, const ControllerMessage &msg, long now);
+    void announceEmergency(int node, const Vehicle* v, long now);
+    void deliverMessages(int node, long windowEnd);
+    int nodeOf(uint32_t nameId) const;
+    int onwardLink(int node, const Vehicle* v) const;
+    // Turn at `node` from the vehicle's approach onto its onward link;
+    // STRAIGHT where its trip ends.
+    void setMovement(int node, Vehicle* v) const;
+    bool mayDepart(int node, const Vehicle* v) const;
+    void vehicleCrossed(int node, Vehicle* v);
+    void receiveTransfers(int node);
+    void sendTransfers(int node);
+    void workerLoop(int index, int workers, long duration);
+    static void* workerThreadStart(void* arg);
+
+    const RoadNetwork &network;
+    vector<unique_ptr<Node>> nodes;
+    unique_ptr<LinkState[]> linkStates;
+    vector<int> nodeByName;  // by NameTable id, -1 for other names
+    ParkingGuide guide;
+    bool preemption;
+    pthread_barrier_t barrier;
+    atomic<long> forwarded;
+    atomic<long> delivered;
+    atomic<long> redirects;
+    atomic<long> handedOff;
+    atomic<long> tripsDone;
+    atomic<long> tripSeconds;
+    atomic<long> tripHops;
+    atomic<long> emergencyTrips;
+    atomic<long> emergencyTripSeconds;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "ParkingGuide.h"
+#include "ParkingLot.h"
+#include "Vehicle.h"
+
+#include <cmath>
+#include <algorithm>
+
+unsigned ParkingGuide::typeBit(VehicleType type) {
+    switch (type) {
+    case VehicleType::CAR: return CAR;
+    case VehicleType::BIKE: return BIKE;
+    case VehicleType::BUS: return BUS;
+    case VehicleType::TRACTOR: return TRACTOR;
+    default: return 0;
+    }
+}
+
+ParkingGuide::ParkingGuide(double size)
+    : cellSize(size > 0 ? size : 1.0),
+      originX(0), originY(0), width(0), height(0),
+      minCellX(0), maxCellX(-1), minCellY(0), maxCellY(-1) {}
+
+int64_t ParkingGuide::cellOf(double v) const {
+    return static_cast<int64_t>(floor(v / cellSize));
+}
+
+void ParkingGuide::cover(int64_t cx, int64_t cy) {
+    if (width > 0 && cx >= originX && cx < originX + width &&
+        cy >= originY && cy < originY + height) {
+        return;
+    }
+
+    int64_t x0 = originX, y0 = originY, w = width, h = height;
+    if (w == 0) {
+        x0 = cx;
+        y0 = cy;
+        w = h = 1;
+    }
+    while (cx < x0) { x0 -= w; w *= 2; }
+    while (cx >= x0 + w) { w *= 2; }
+    while (cy < y0) { y0 -= h; h *= 2; }
+    while (cy >= y0 + h) { h *= 2; }
+
+    vector<vector<LotEntry>> grown(static_cast<size_t>(w * h));
+    for (int64_t gy = 0; gy < height; ++gy) {
+        for (int64_t gx = 0; gx < width; ++gx) {
+            int64_t nx = originX + gx - x0, ny = originY + gy - y0;
+            grown[ny * w + nx] = move(cells[gy * width + gx]);
+        }
+    }
+    cells.swap(grown);
+    originX = x0;
+    originY = y0;
+    width = w;
+    height = h;
+}
+
+int ParkingGuide::addLot(ParkingLot* lot, double x, double y, unsigned types) {
+    int index = static_cast<int>(lots.size());
+    lots.push_back(lot);
+
+    int64_t cx = cellOf(x), cy = cellOf(y);
+    cover(cx, cy);
+    cells[(cy - originY) * width + (cx - originX)].push_back(LotEntry{lot, x, y, types, index});
+    if (index == 0) {
+        minCellX = maxCellX = cx;
+        minCellY = maxCellY = cy;
+    } else {
+        minCellX = min(minCellX, cx);
+        maxCellX = max(maxCellX, cx);
+        minCellY = min(minCellY, cy);
+        maxCellY = max(maxCellY, cy);
+    }
+    return index;
+}
+
+int ParkingGuide::nearest(double x, double y, unsigned typeMask) const {
+    if (lots.empty() || typeMask == 0) {
+        return -1;
+    }
+
+    int64_t cx = cellOf(x), cy = cellOf(y);
+    // Rings past this one cover no occupied cell.
+    int64_t lastRing = max(max(cx - minCellX, maxCellX - cx), max(cy - minCellY, maxCellY - cy));
+
+    int best = -1;
+    double bestD2 = 0;
+    auto scanRow = [&](int64_t gy, int64_t fromX, int64_t toX) {
+        if (gy < minCellY || gy > maxCellY) {
+            return;
+        }
+        fromX = max(fromX, minCellX);
+        toX = min(toX, maxCellX);
+        for (int64_t gx = fromX; gx <= toX; ++gx) {
+            for (const LotEntry &e : cells[(gy - originY) * width + (gx - originX)]) {
+                double dx = e.x - x, dy = e.y - y;
+                double d2 = dx * dx + dy * dy;
+                // Occupancy last: it is the one load that may miss cache.
+                if ((best < 0 || d2 < bestD2) && (e.types & typeMask) &&
+                    e.lot->hasRoom()) {
+                    best = e.index;
+                    bestD2 = d2;
+                }
+            }
+        }
+    };
+
+    for (int64_t r = 0; r <= lastRing; ++r) {
+        if (r == 0) {
+            scanRow(cy, cx, cx);
+        } else {
+            scanRow(cy - r, cx - r, cx + r);
+            scanRow(cy + r, cx - r, cx + r);
+            for (int64_t gy = cy - r + 1; gy <= cy + r - 1; ++gy) {
+                scanRow(gy, cx - r, cx - r);
+                scanRow(gy, cx + r, cx + r);
+            }
+        }
+        // Every cell of ring r + 1 is at least r cells away.
+        double reach = r * cellSize;
+        if (best >= 0 && bestD2 <= reach * reach) {
+            break;
+        }
+    }
+    return best;
+}
+
+ParkingLot* ParkingGuide::reserve(Vehicle* v, double x, double y, int maxTries) const {
+    unsigned mask = typeBit(v->getVehicleType());
+    if (!mask || v->isEmergency()) {
+        return nullptr;
+    }
+    for (int attempt = 0; attempt < maxTries; ++attempt) {
+        int i = nearest(x, y, mask);
+        if (i < 0) {
+            return nullptr; // every suitable lot is full
+        }
+        if (v->parkingVehicle(*lots[i])) {
+            return lots[i];
+        }
+        // Lost the last slot to another vehicle; the next query skips it.
+    }
+    return nullptr;
+}
@@ -0,0 +1,76 @@
+#ifndef PARKING_GUIDE_H
+#define PARKING_GUIDE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class ParkingLot;
+class Vehicle;
+enum class VehicleType : uint8_t;
+
+// Spatial index over many parking lots for "nearest lot that still has
+// room for this vehicle" (a free waiting slot and a free spot). Lots sit in
+// a uniform grid of square cells; a query walks rings of cells outward from
+// the vehicle and stops as soon as no unvisited cell can hold a closer lot.
+// Free capacity is read straight from each lot's atomic occupancy, so
+// queries need no lock and always see current occupancy while vehicles
+// park and leave on other threads.
+//
+// Register every lot before the first query; addLot is not safe against
+// concurrent queries.
+class ParkingGuide {
+public:
+    // Vehicle types a lot accepts, as a bit mask.
+    static const unsigned CAR = 1, BIKE = 2, BUS = 4, TRACTOR = 8;
+    static const unsigned ALL_TYPES = CAR | BIKE | BUS | TRACTOR;
+
+    // Bit for a vehicle type, or 0 for types that cannot park.
+    static unsigned typeBit(VehicleType type);
+
+    // cellSize is in the same unit as lot positions; about the typical
+    // distance between neighbouring lots works best.
+    explicit ParkingGuide(double cellSize = 1000.0);
+
+    // Register a lot (not owned) at (x, y). Returns its index.
+    int addLot(ParkingLot* lot, double x, double y, unsigned types = ALL_TYPES);
+
+    // Nearest lot accepting `typeMask` with room to park, or -1.
+    int nearest(double x, double y, unsigned typeMask) const;
+
+    // Reserve a waiting slot for `v` at the nearest lot with room. A lot
+    // that turns it away (it filled up since the query) is skipped and the
+    // next best one tried, up to maxTries lots. Returns the lot holding the
+    // reservation, or nullptr.
+    ParkingLot* reserve(Vehicle* v, double x, double y, int maxTries = 4) const;
+
+    int lotCount() const { return static_cast<int>(lots.size()); }
+    ParkingLot* lot(int index) const { return lots[index]; }
+
+private:
+    struct LotEntry {
+        ParkingLot* lot;
+        double x;
+        double y;
+        unsigned types;
+        int index;
+    };
+
+    int64_t cellOf(double v) const;
+    // Widen the grid to cover cell (cx, cy), doubling so re-layouts stay rare.
+    void cover(int64_t cx, int64_t cy);
+
+    double cellSize;
+    vector<ParkingLot*> lots;
+    // Dense grid of cells, row-major from (originX, originY); entries are
+    // stored inline so a query touches no other memory until it checks a
+    // lot's occupancy.
+    vector<vector<LotEntry>> cells;
+    int64_t originX, originY, width, height;
+    int64_t minCellX, maxCellX, minCellY, maxCellY; // cells holding lots
+};
+
+#endif
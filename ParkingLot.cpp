@@ -1,19 +1,29 @@
 #include "ParkingLot.h"
 #include "Vehicle.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Recording.h"
+#include "Columns.h"
 
 ParkingLot::ParkingLot(const string &lotID, int parking_cap, int waiting_cap)
-    : parking_capacity(parking_cap),
+    : occupancy(0),
+      parkingLotID(lotID),
+      parking_capacity(parking_cap),
       waiting_capacity(waiting_cap),
-      parkingLotID(lotID)
+      peakParked(0),
+      peakWaiting(0),
+      turnedAway(0),
+      refused(0),
+      spotsAcquired(0),
+      spotMisses(0)
 {
-    sem_init(&parking_spots, 0, parking_capacity);
-    sem_init(&waiting_spots, 0, waiting_capacity);
-
-    mtx.lock();
-    cout << "[ParkingLot] " << lotID << " initialized with:" << endl;
-    cout << "  Parking spots: " << parking_capacity << endl;
-    cout << "  Waiting spots: " << waiting_capacity << endl;
-    mtx.unlock();
+    LOG_EVENT(INFO, LogEvent::LOT_INIT, nullptr, lotID, string(), parking_capacity, waiting_capacity);
+}
+
+void ParkingLot::raisePeak(atomic<int> &peak, int value)
+{
+    int p = peak.load(memory_order_relaxed);
+    while(value > p && !peak.compare_exchange_weak(p, value, memory_order_relaxed)) {}
 }
 
 bool ParkingLot::tryReserveWaitingSlot(Vehicle* v)
@@ -22,33 +32,35 @@ bool ParkingLot::tryReserveWaitingSlot(Vehicle* v)
 
     if(v->isEmergency())
     {
-        lock_guard<mutex> lock(mtx);
-        cout << "Emergency vehicles cannot request parking." << endl;
+        refused.fetch_add(1, memory_order_relaxed);
+        LOG_EVENT(DEBUG, LogEvent::PARKING_EMERGENCY, v);
         return false;
     }
 
     if(!v->canPark())
     {
-        lock_guard<mutex> lock(mtx);
-        cout << "[ParkingLot] " << parkingLotID << " -> Vehicle "
-             << v->getId() << " (" << v->getType() << ") cannot park here." << endl;
-        return false;
-    }
-
-    if(sem_trywait(&waiting_spots) != 0)
-    {
-        lock_guard<mutex> lock(mtx);
-        cout << "[ParkingLot] " << parkingLotID
-             << " waiting queue full. Vehicle " << v->getId()
-             << " (" << v->getType() << ") cannot enter waiting queue." << endl;
+        refused.fetch_add(1, memory_order_relaxed);
+        LOG_EVENT(DEBUG, LogEvent::PARKING_REFUSED, v, parkingLotID);
         return false;
     }
 
-    lock_guard<mutex> lock(mtx);
-    cout << "[ParkingLot] " << parkingLotID << " -> Vehicle "
-         << v->getId() << " (" << v->getType()
-         << ") obtained a waiting spot in waiting queue." << endl;
-
+    uint64_t word = occupancy.load(memory_order_relaxed);
+    do {
+        if(waitingOf(word) >= waiting_capacity)
+        {
+            turnedAway.fetch_add(1, memory_order_relaxed);
+            Metrics::count(MetricCounter::PARKING_TURNED_AWAY);
+            LOG_EVENT(INFO, LogEvent::WAITING_FULL, v, parkingLotID);
+            if(Recorder::enabled()) Recorder::parking(LogEvent::WAITING_FULL, parkingLotID, v);
+            if(ColumnWriter::enabled()) ColumnWriter::parking(LogEvent::WAITING_FULL, parkingLotID, parking_capacity, parkedOf(word), v);
+            return false;
+        }
+    } while(!occupancy.compare_exchange_weak(word, word + 1, memory_order_acq_rel, memory_order_relaxed));
+    raisePeak(peakWaiting, waitingOf(word) + 1);
+
+    LOG_EVENT(DEBUG, LogEvent::WAITING_RESERVED, v, parkingLotID);
+    if(Recorder::enabled()) Recorder::parking(LogEvent::WAITING_RESERVED, parkingLotID, v);
+    if(ColumnWriter::enabled()) ColumnWriter::parking(LogEvent::WAITING_RESERVED, parkingLotID, parking_capacity, parkedOf(word), v);
     return true;
 }
 
@@ -56,49 +68,75 @@ bool ParkingLot::aquireParkingSpot(Vehicle* v)
 {
     if(!v) return false;
 
-    if(sem_trywait(&parking_spots) != 0)
+    // Take a spot and give back the waiting slot in one step.
+    uint64_t word = occupancy.load(memory_order_relaxed);
+    do {
+        if(parkedOf(word) >= parking_capacity)
+        {
+            LOG_EVENT(DEBUG, LogEvent::SPOT_UNAVAILABLE, v, parkingLotID);
+            if(Recorder::enabled()) Recorder::parking(LogEvent::SPOT_UNAVAILABLE, parkingLotID, v);
+            if(ColumnWriter::enabled()) ColumnWriter::parking(LogEvent::SPOT_UNAVAILABLE, parkingLotID, parking_capacity, parkedOf(word), v);
+            return false;
+        }
+    } while(!occupancy.compare_exchange_weak(word, word + ONE_PARKED - 1,
+                                              memory_order_acq_rel, memory_order_relaxed));
+    raisePeak(peakParked, parkedOf(word) + 1);
+    spotsAcquired.fetch_add(1, memory_order_relaxed);
+    if(Metrics::enabled())
     {
-        lock_guard<mutex> lock(mtx);
-        cout << "[ParkingLot] " << parkingLotID << " -> Vehicle "
-             << v->getId() << " (" << v->getType()
-             << ") could not obtain parking spot." << endl;
-        return false;
+        Metrics::count(MetricCounter::VEHICLES_PARKED);
+        Metrics::record(MetricHistogram::PARKING_OCCUPANCY, parkedOf(word) + 1);
     }
 
-    sem_post(&waiting_spots);
-
-    lock_guard<mutex> lock(mtx);
-    cout << "[ParkingLot] " << parkingLotID << " -> Vehicle "
-         << v->getId() << " (" << v->getType()
-         << ") obtained a parking spot." << endl;
-
+    LOG_EVENT(DEBUG, LogEvent::SPOT_ACQUIRED, v, parkingLotID);
+    if(Recorder::enabled()) Recorder::parking(LogEvent::SPOT_ACQUIRED, parkingLotID, v);
+    if(ColumnWriter::enabled()) ColumnWriter::parking(LogEvent::SPOT_ACQUIRED, parkingLotID, parking_capacity, parkedOf(word) + 1, v);
     return true;
 }
 
 void ParkingLot::releaseWaitingSlot(Vehicle* v)
 {
     if(!v) return;
-    sem_post(&waiting_spots);
+    uint64_t word = occupancy.fetch_sub(1, memory_order_acq_rel);
+    spotMisses.fetch_add(1, memory_order_relaxed);
 
-    lock_guard<mutex> lock(mtx);
-    cout << "[ParkingLot] " << parkingLotID << " -> Vehicle "
-         << v->getId() << " (" << v->getType()
-         << ") released a waiting spot." << endl;
+    LOG_EVENT(DEBUG, LogEvent::WAITING_RELEASED, v, parkingLotID);
+    if(Recorder::enabled()) Recorder::parking(LogEvent::WAITING_RELEASED, parkingLotID, v);
+    if(ColumnWriter::enabled()) ColumnWriter::parking(LogEvent::WAITING_RELEASED, parkingLotID, parking_capacity, parkedOf(word), v);
 }
 
 void ParkingLot::leaveParking(Vehicle* v)
 {
     if(!v) return;
-    sem_post(&parking_spots);
+    uint64_t word = occupancy.fetch_sub(ONE_PARKED, memory_order_acq_rel);
+    if(Metrics::enabled())
+    {
+        Metrics::count(MetricCounter::PARKING_LEFT);
+        Metrics::record(MetricHistogram::PARKING_OCCUPANCY, parkedOf(word) - 1);
+    }
+
+    LOG_EVENT(DEBUG, LogEvent::PARKING_LEFT, v, parkingLotID);
+    if(Recorder::enabled()) Recorder::parking(LogEvent::PARKING_LEFT, parkingLotID, v);
+    if(ColumnWriter::enabled()) ColumnWriter::parking(LogEvent::PARKING_LEFT, parkingLotID, parking_capacity, parkedOf(word) - 1, v);
+}
 
-    lock_guard<mutex> lock(mtx);
-    cout << "[ParkingLot] " << parkingLotID << " -> Vehicle "
-         << v->getId() << " (" << v->getType()
-         << ") has left the parking lot." << endl;
+ParkingStats ParkingLot::stats() const
+{
+    uint64_t word = occupancy.load(memory_order_acquire);
+    ParkingStats s;
+    s.parked = parkedOf(word);
+    s.waiting = waitingOf(word);
+    s.peakParked = peakParked.load(memory_order_relaxed);
+    s.peakWaiting = peakWaiting.load(memory_order_relaxed);
+    s.turnedAway = turnedAway.load(memory_order_relaxed);
+    s.refused = refused.load(memory_order_relaxed);
+    s.spotsAcquired = spotsAcquired.load(memory_order_relaxed);
+    s.spotMisses = spotMisses.load(memory_order_relaxed);
+    s.reservations = s.spotsAcquired + s.spotMisses + s.waiting;
+    s.departures = s.spotsAcquired - s.parked;
+    return s;
 }
 
 ParkingLot::~ParkingLot()
 {
-    sem_destroy(&parking_spots);
-    sem_destroy(&waiting_spots);
 }
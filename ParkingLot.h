@@ -3,24 +3,58 @@
 
 #include <iostream>
 #include <string>
+#include <atomic>
+#include <cstdint>
 #include <pthread.h>
-#include <semaphore.h>
-#include <mutex>
 #include <unistd.h>
 
 using namespace std;
 
 class Vehicle;
 
+// Occupancy and outcome counters of one lot, read without locking.
+struct ParkingStats {
+    int parked;                // spots in use now
+    int waiting;               // waiting slots in use now
+    int peakParked;
+    int peakWaiting;
+    unsigned long reservations;    // waiting slots granted
+    unsigned long turnedAway;      // waiting area full
+    unsigned long refused;         // emergency or vehicle type that cannot park
+    unsigned long spotsAcquired;
+    unsigned long spotMisses;      // waiting slot given back unparked (no spot, or cancelled)
+    unsigned long departures;
+};
+
+// Parking spots plus a waiting area in front of them. Every operation is
+// non-blocking: both occupancies live in one atomic word updated with
+// compare-and-swap, so moving from the waiting area to a spot is a single
+// step and vehicles on any number of threads never wait on each other. How
+// long a vehicle stays is up to the caller (a timer wheel or simulated
+// event).
 class ParkingLot
 {
-    sem_t parking_spots;
-    sem_t waiting_spots;
-    mutex mtx;
+    // Spots in use in the high half, waiting slots in use in the low half.
+    atomic<uint64_t> occupancy;
     string parkingLotID;
     int parking_capacity;
     int waiting_capacity;
 
+    // Statistics, relaxed. Reservations and departures are derived from
+    // these and the occupancy.
+    atomic<int> peakParked;
+    atomic<int> peakWaiting;
+    atomic<unsigned long> turnedAway;
+    atomic<unsigned long> refused;
+    atomic<unsigned long> spotsAcquired;
+    atomic<unsigned long> spotMisses;
+
+    static const uint64_t ONE_PARKED = 1ull << 32;
+    static int parkedOf(uint64_t word) { return static_cast<int>(word >> 32); }
+    static int waitingOf(uint64_t word) { return static_cast<int>(word & 0xffffffffu); }
+
+    static void raisePeak(atomic<int> &peak, int value);
+
 public:
 
     ParkingLot(const string &lotID, int parking_cap = 10, int waiting_cap = 15);
@@ -37,6 +71,24 @@ public:
     int getWaitingCapacity() const { return waiting_capacity; }
     string getParkingLotID() const { return parkingLotID; }
 
+    // Waiting slots free right now; one atomic load, for guidance queries.
+    int freeWaitingSlots() const
+    {
+        return waiting_capacity - waitingOf(occupancy.load(memory_order_relaxed));
+    }
+
+    // A waiting slot and a spot are both free, so a vehicle sent here now
+    // gets to park. One atomic load, for guidance queries.
+    bool hasRoom() const
+    {
+        uint64_t word = occupancy.load(memory_order_relaxed);
+        return waitingOf(word) < waiting_capacity && parkedOf(word) < parking_capacity;
+    }
+
+    // Snapshot of the counters. Each field is exact; taken together they
+    // may be a few operations apart under concurrent use.
+    ParkingStats stats() const;
+
     ~ParkingLot();
 };
 
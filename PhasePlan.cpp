@@ -0,0 +1,148 @@
+#include "PhasePlan.h"
+
+MovementSet approachMovements(Direction approach) {
+    return static_cast<MovementSet>(7u << (directionIndex(approach) * MOVEMENT_COUNT));
+}
+
+Direction opposite(Direction d) {
+    switch (d) {
+    case Direction::NORTH: return Direction::SOUTH;
+    case Direction::SOUTH: return Direction::NORTH;
+    case Direction::EAST:  return Direction::WEST;
+    case Direction::WEST:  return Direction::EAST;
+    }
+    return d;
+}
+
+Direction exitLeg(Direction approach, Movement m) {
+    // Legs to the right and left of a vehicle coming in from each approach.
+    static const Direction RIGHT_OF[DIRECTION_COUNT] = {
+        Direction::WEST, Direction::EAST, Direction::NORTH, Direction::SOUTH};
+    switch (m) {
+    case Movement::STRAIGHT: return opposite(approach);
+    case Movement::RIGHT:    return RIGHT_OF[directionIndex(approach)];
+    case Movement::LEFT:     return opposite(RIGHT_OF[directionIndex(approach)]);
+    }
+    return approach;
+}
+
+Movement movementTo(Direction approach, Direction exit) {
+    for (int i = 0; i < MOVEMENT_COUNT; ++i) {
+        if (exitLeg(approach, movementAt(i)) == exit) {
+            return movementAt(i);
+        }
+    }
+    return Movement::LEFT;
+}
+
+bool movementsConflict(Direction a1, Movement m1, Direction a2, Movement m2) {
+    if (a1 == a2) {
+        return false; // one lane, one vehicle at a time
+    }
+    if (exitLeg(a1, m1) == exitLeg(a2, m2)) {
+        return true; // merge
+    }
+    if (m1 == Movement::RIGHT || m2 == Movement::RIGHT) {
+        return false; // a right turn stays in its corner
+    }
+    if (a2 == opposite(a1)) {
+        return m1 != m2; // a left turn across oncoming straight traffic
+    }
+    return true; // perpendicular crossing paths
+}
+
+bool conflictFree(MovementSet set) {
+    for (int i = 0; i < MOVEMENT_PAIRS; ++i) {
+        if (!(set & (1u << i))) {
+            continue;
+        }
+        for (int j = i + 1; j < MOVEMENT_PAIRS; ++j) {
+            if ((set & (1u << j)) &&
+                movementsConflict(directionAt(i / MOVEMENT_COUNT), movementAt(i % MOVEMENT_COUNT),
+                                  directionAt(j / MOVEMENT_COUNT), movementAt(j % MOVEMENT_COUNT))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Phase::serves(Direction approach, const Vehicle* v) const {
+    return v && has(approach, v->getMovement());
+}
+
+PhasePlan PhasePlan::singleDirection() {
+    PhasePlan plan;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        plan.add(directionName(directionAt(i)), approachMovements(directionAt(i)));
+    }
+    return plan;
+}
+
+PhasePlan PhasePlan::compatibleMovements() {
+    PhasePlan plan;
+    plan.add("NS-STRAIGHT",
+             movementBit(Direction::NORTH, Movement::STRAIGHT) | movementBit(Direction::NORTH, Movement::RIGHT) |
+             movementBit(Direction::SOUTH, Movement::STRAIGHT) | movementBit(Direction::SOUTH, Movement::RIGHT));
+    plan.add("NS-LEFT",
+             movementBit(Direction::NORTH, Movement::LEFT) | movementBit(Direction::SOUTH, Movement::LEFT));
+    plan.add("EW-STRAIGHT",
+             movementBit(Direction::EAST, Movement::STRAIGHT) | movementBit(Direction::EAST, Movement::RIGHT) |
+             movementBit(Direction::WEST, Movement::STRAIGHT) | movementBit(Direction::WEST, Movement::RIGHT));
+    plan.add("EW-LEFT",
+             movementBit(Direction::EAST, Movement::LEFT) | movementBit(Direction::WEST, Movement::LEFT));
+    return plan;
+}
+
+bool PhasePlan::byName(const string &name, PhasePlan &out) {
+    if (name == "single") {
+        out = singleDirection();
+        return true;
+    }
+    if (name == "compatible") {
+        out = compatibleMovements();
+        return true;
+    }
+    return false;
+}
+
+bool PhasePlan::add(const string &name, MovementSet movements) {
+    if (movements == 0) {
+        cout << "[PhasePlan] Phase " << name << " has no movements" << endl;
+        return false;
+    }
+    if (!conflictFree(movements)) {
+        cout << "[PhasePlan] Phase " << name << " has conflicting movements" << endl;
+        return false;
+    }
+    phases.push_back(Phase{name, movements});
+    return true;
+}
+
+bool PhasePlan::complete() const {
+    MovementSet all = 0;
+    for (const Phase &p : phases) {
+        all |= p.movements;
+    }
+    return all == static_cast<MovementSet>((1u << MOVEMENT_PAIRS) - 1);
+}
+
+int servableHeads(const LaneSnapshot &snap, const Phase &phase) {
+    int n = 0;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        if (phase.serves(directionAt(i), snap.heads[i])) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+int servableQueue(const LaneSnapshot &snap, const Phase &phase) {
+    int n = 0;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        if (phase.serves(directionAt(i), snap.heads[i])) {
+            n += snap.sizes[i];
+        }
+    }
+    return n;
+}
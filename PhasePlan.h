@@ -0,0 +1,89 @@
+#ifndef PHASE_PLAN_H
+#define PHASE_PLAN_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Intersection.h"
+
+using namespace std;
+
+// Every (approach, movement) pair of a four-leg intersection.
+const int MOVEMENT_PAIRS = DIRECTION_COUNT * MOVEMENT_COUNT;
+
+// Set of (approach, movement) pairs, one bit each.
+typedef uint16_t MovementSet;
+
+inline MovementSet movementBit(Direction approach, Movement m) {
+    return static_cast<MovementSet>(1u << (directionIndex(approach) * MOVEMENT_COUNT + movementIndex(m)));
+}
+
+// Every movement from one approach.
+MovementSet approachMovements(Direction approach);
+
+// Leg across the intersection from `d`.
+Direction opposite(Direction d);
+
+// Leg a vehicle leaves by (right-hand traffic): from NORTH, STRAIGHT
+// leaves SOUTH, LEFT leaves EAST and RIGHT leaves WEST.
+Direction exitLeg(Direction approach, Movement m);
+
+// Movement from `approach` that leaves by `exit`. Leaving by the approach
+// itself is a U-turn, made from the left-turn position, so LEFT.
+Movement movementTo(Direction approach, Direction exit);
+
+// Conflict matrix. Two movements from different approaches conflict if
+// they leave by the same leg, or if neither turns right and they cross:
+// opposing straights and opposing lefts are the only non-right pairs that
+// don't. Movements from one approach never conflict with each other.
+bool movementsConflict(Direction a1, Movement m1, Direction a2, Movement m2);
+
+// True if no two movements in the set conflict.
+bool conflictFree(MovementSet set);
+
+// Movements that get green together.
+struct Phase {
+    string name;         // logged as the phase name
+    MovementSet movements;
+
+    bool has(Direction approach, Movement m) const { return (movements & movementBit(approach, m)) != 0; }
+
+    // True if the phase lets this lane head go.
+    bool serves(Direction approach, const Vehicle* v) const;
+
+    // True if the phase has any movement from the approach (its light is green).
+    bool greenOn(Direction approach) const { return (movements & approachMovements(approach)) != 0; }
+};
+
+// Ordered set of phases for one intersection.
+class PhasePlan {
+public:
+    // One phase per approach with all its movements: the original
+    // single-direction cycle N, S, E, W.
+    static PhasePlan singleDirection();
+
+    // North/south straight and right, north/south left, then the same for
+    // east/west: opposing approaches share a green.
+    static PhasePlan compatibleMovements();
+
+    // "single" or "compatible". Returns false for anything else.
+    static bool byName(const string &name, PhasePlan &out);
+
+    // Append a phase. Fails (and reports why) if the movements conflict.
+    bool add(const string &name, MovementSet movements);
+
+    int size() const { return static_cast<int>(phases.size()); }
+    const Phase& at(int i) const { return phases[i]; }
+
+    // True if every (approach, movement) pair is in some phase.
+    bool complete() const;
+
+private:
+    vector<Phase> phases;
+};
+
+// Lane heads the phase can release now, and the queues behind them.
+int servableHeads(const LaneSnapshot &snap, const Phase &phase);
+int servableQueue(const LaneSnapshot &snap, const Phase &phase);
+
+#endif
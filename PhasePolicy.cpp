@@ -0,0 +1,116 @@
+#include "PhasePolicy.h"
+#include "TrafficController.h"
+
+FixedTimePolicy::FixedTimePolicy(int greenSeconds)
+    : green(greenSeconds), next(0) {}
+
+bool FixedTimePolicy::choosePhase(const LaneSnapshot &, const PhasePlan &plan, PhaseChoice &choice) {
+    if (plan.size() == 0) {
+        return false;
+    }
+    next %= plan.size();
+    choice.phase = next;
+    choice.cycleStart = (next == 0);
+    next = (next + 1) % plan.size();
+    return true;
+}
+
+GreenStep FixedTimePolicy::greenStep(const LaneSnapshot &snap, const Phase &phase, int elapsed, int served) {
+    if (elapsed == 0 && servableHeads(snap, phase) > 0) {
+        return GreenStep::release();
+    }
+    // The crossing vehicle's time comes on top of the green.
+    int length = green + (served > 0 ? TrafficController::CROSSING_TIME : 0);
+    if (elapsed < length) {
+        return GreenStep::hold(length - elapsed);
+    }
+    return GreenStep::end();
+}
+
+ActuatedPolicy::ActuatedPolicy(int minGreenSeconds, int maxGreenSeconds, int gapSeconds)
+    : minGreen(minGreenSeconds),
+      maxGreen(maxGreenSeconds),
+      gap(gapSeconds),
+      next(0),
+      lastActivity(0) {}
+
+bool ActuatedPolicy::choosePhase(const LaneSnapshot &snap, const PhasePlan &plan, PhaseChoice &choice) {
+    for (int i = 0; i < plan.size(); ++i) {
+        int index = (next + i) % plan.size();
+        if (servableHeads(snap, plan.at(index)) > 0) {
+            choice.phase = index;
+            // Starting over from the first phase, or wrapping past the last, begins a new cycle.
+            choice.cycleStart = (next == 0 || index < next);
+            next = (index + 1) % plan.size();
+            lastActivity = 0;
+            return true;
+        }
+    }
+    return false; // no phase can release anyone
+}
+
+GreenStep ActuatedPolicy::greenStep(const LaneSnapshot &snap, const Phase &phase, int elapsed, int) {
+    if (elapsed >= maxGreen) {
+        return GreenStep::end(); // max-out
+    }
+    if (servableHeads(snap, phase) > 0 && elapsed + TrafficController::CROSSING_TIME <= maxGreen) {
+        lastActivity = elapsed + TrafficController::CROSSING_TIME;
+        return GreenStep::release();
+    }
+    if (elapsed < minGreen) {
+        return GreenStep::hold(minGreen - elapsed);
+    }
+    if (elapsed - lastActivity < gap) {
+        return GreenStep::hold(1); // extend while a follower may still arrive
+    }
+    return GreenStep::end(); // gap-out
+}
+
+MaxPressurePolicy::MaxPressurePolicy(int intervalSeconds)
+    : interval(intervalSeconds), decisions(0) {}
+
+bool MaxPressurePolicy::choosePhase(const LaneSnapshot &snap, const PhasePlan &plan, PhaseChoice &choice) {
+    if (lastServed.size() < static_cast<size_t>(plan.size())) {
+        lastServed.resize(plan.size(), 0);
+    }
+    int best = -1;
+    int bestPressure = 0;
+    for (int i = 0; i < plan.size(); ++i) {
+        int pressure = servableQueue(snap, plan.at(i));
+        if (pressure == 0) {
+            continue;
+        }
+        if (best < 0 || pressure > bestPressure ||
+            (pressure == bestPressure && lastServed[i] < lastServed[best])) {
+            best = i;
+            bestPressure = pressure;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    choice.phase = best;
+    choice.cycleStart = false;
+    lastServed[best] = ++decisions;
+    return true;
+}
+
+GreenStep MaxPressurePolicy::greenStep(const LaneSnapshot &snap, const Phase &phase, int elapsed, int) {
+    if (elapsed < interval && servableHeads(snap, phase) > 0) {
+        return GreenStep::release();
+    }
+    return GreenStep::end();
+}
+
+unique_ptr<PhasePolicy> makePhasePolicy(const string &name, int greenSeconds) {
+    if (name == "fixed") {
+        return unique_ptr<PhasePolicy>(new FixedTimePolicy(greenSeconds));
+    }
+    if (name == "actuated") {
+        return unique_ptr<PhasePolicy>(new ActuatedPolicy());
+    }
+    if (name == "max-pressure") {
+        return unique_ptr<PhasePolicy>(new MaxPressurePolicy());
+    }
+    return nullptr;
+}
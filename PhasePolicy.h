@@ -0,0 +1,116 @@
+#ifndef PHASE_POLICY_H
+#define PHASE_POLICY_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include "Intersection.h"
+#include "PhasePlan.h"
+
+using namespace std;
+
+// The phase a policy gives the next green to.
+struct PhaseChoice {
+    int phase;       // index into the controller's PhasePlan
+    bool cycleStart; // first phase of a new signal cycle (for logs)
+};
+
+// What to do next during a green phase.
+struct GreenStep {
+    enum Action {
+        RELEASE, // let every lane head the phase serves cross together
+                 // (TrafficController::CROSSING_TIME)
+        HOLD,    // keep the green with nobody crossing for `seconds`
+        END      // end the green
+    };
+    Action action;
+    int seconds;
+
+    static GreenStep release() { return GreenStep{RELEASE, 0}; }
+    static GreenStep hold(int s) { return GreenStep{HOLD, s}; }
+    static GreenStep end() { return GreenStep{END, 0}; }
+};
+
+// Signal timing plan for one TrafficController. The controller asks for a
+// phase of its PhasePlan, then asks what to do at every step of its green
+// until the policy ends it; emergencies are handled by the controller
+// before each phase. Policies see queue lengths only through LaneSnapshot
+// and never sleep.
+class PhasePolicy {
+public:
+    virtual ~PhasePolicy() {}
+
+    virtual const char* name() const = 0;
+
+    // Pick the next green. Returning false keeps every light red; the
+    // controller asks again after IDLE_SECONDS.
+    virtual bool choosePhase(const LaneSnapshot &snap, const PhasePlan &plan,
+                             PhaseChoice &choice) = 0;
+
+    // `elapsed` seconds into the green of `phase`, with `served` vehicles
+    // released so far. RELEASE is treated as HOLD of CROSSING_TIME when no
+    // lane head can go.
+    virtual GreenStep greenStep(const LaneSnapshot &snap, const Phase &phase,
+                                int elapsed, int served) = 0;
+
+    static const int IDLE_SECONDS = 1;
+};
+
+// Every phase in plan order with a fixed green, empty ones included, and
+// one release per green: with the single-direction plan, the original
+// N -> S -> E -> W signal plan.
+class FixedTimePolicy : public PhasePolicy {
+public:
+    explicit FixedTimePolicy(int greenSeconds = 5);
+
+    const char* name() const override { return "fixed"; }
+    bool choosePhase(const LaneSnapshot &snap, const PhasePlan &plan, PhaseChoice &choice) override;
+    GreenStep greenStep(const LaneSnapshot &snap, const Phase &phase, int elapsed, int served) override;
+
+private:
+    int green;
+    int next; // index of the next phase
+};
+
+// Same rotation, but phases with nobody to serve are skipped and a green
+// keeps discharging its queues until it gaps out (no vehicle for
+// gapSeconds) or reaches maxGreen.
+class ActuatedPolicy : public PhasePolicy {
+public:
+    ActuatedPolicy(int minGreen = 2, int maxGreen = 30, int gapSeconds = 3);
+
+    const char* name() const override { return "actuated"; }
+    bool choosePhase(const LaneSnapshot &snap, const PhasePlan &plan, PhaseChoice &choice) override;
+    GreenStep greenStep(const LaneSnapshot &snap, const Phase &phase, int elapsed, int served) override;
+
+private:
+    int minGreen;
+    int maxGreen;
+    int gap;
+    int next;
+    int lastActivity; // seconds into the green of the last release
+};
+
+// Every control interval, serve the phase with the most queued vehicles
+// behind lane heads it can release. An isolated intersection has no
+// downstream queues to subtract, so that is the phase's pressure. Ties go
+// to the phase that has waited longest since its last green.
+class MaxPressurePolicy : public PhasePolicy {
+public:
+    explicit MaxPressurePolicy(int intervalSeconds = 10);
+
+    const char* name() const override { return "max-pressure"; }
+    bool choosePhase(const LaneSnapshot &snap, const PhasePlan &plan, PhaseChoice &choice) override;
+    GreenStep greenStep(const LaneSnapshot &snap, const Phase &phase, int elapsed, int served) override;
+
+private:
+    int interval;
+    unsigned long decisions;
+    vector<unsigned long> lastServed; // per phase, grown to the plan size
+};
+
+// "fixed", "actuated" or "max-pressure"; nullptr for anything else.
+// greenSeconds is the fixed-time green.
+unique_ptr<PhasePolicy> makePhasePolicy(const string &name, int greenSeconds = 5);
+
+#endif
@@ -0,0 +1,529 @@
+#include "Recording.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "Intersection.h"
+
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+atomic<bool> Recorder::on(false);
+
+namespace {
+
+const char MAGIC[8] = {'T', 'M', 'S', 'R', 'E', 'C', '0', '1'};
+const size_t BLOCK_BYTES = 64 * 1024;
+const uint32_t MAX_NAME_ID = 1u << 22; // NameTable's capacity
+
+uint64_t monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// Writer state, all under writerMtx.
+mutex writerMtx;
+int fd = -1;
+vector<uint8_t> buffer;
+uint64_t lastUs;
+long lastNowMs;
+uint64_t lastArrivals;
+vector<bool> namesWritten;
+unsigned long recordCount = 0;
+unsigned long byteCount = 0;
+
+void putByte(uint8_t b) {
+    buffer.push_back(b);
+}
+
+void putVarint(uint64_t v) {
+    while (v >= 0x80) {
+        buffer.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    buffer.push_back(static_cast<uint8_t>(v));
+}
+
+// Zigzag, so small negative values stay short.
+void putSigned(int64_t v) {
+    putVarint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+void writeBuffer() {
+    const uint8_t* p = buffer.data();
+    size_t left = buffer.size();
+    while (left > 0 && fd >= 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            cout << "[Recorder] Write failed: " << strerror(errno) << "; recording stopped" << endl;
+            ::close(fd);
+            fd = -1; // every record function checks this under the lock
+            break;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+        byteCount += static_cast<unsigned long>(n);
+    }
+    buffer.clear();
+}
+
+void begin(RecordKind kind) {
+    uint64_t now = monotonicUs();
+    putByte(static_cast<uint8_t>(kind));
+    putVarint(now - lastUs);
+    lastUs = now;
+    ++recordCount;
+}
+
+void end() {
+    if (buffer.size() >= BLOCK_BYTES) {
+        writeBuffer();
+    }
+}
+
+// Write a NAME record the first time an id is used. Call before begin().
+void defineName(uint32_t id) {
+    if (id < namesWritten.size() && namesWritten[id]) {
+        return;
+    }
+    if (id >= namesWritten.size()) {
+        namesWritten.resize(id + 1, false);
+    }
+    namesWritten[id] = true;
+    const string &s = NameTable::name(id);
+    begin(RecordKind::NAME);
+    putVarint(id);
+    putVarint(s.size());
+    buffer.insert(buffer.end(), s.begin(), s.end());
+}
+
+uint32_t nameOf(const char* field, size_t size) {
+    return NameTable::intern(string(field, strnlen(field, size)));
+}
+
+} // namespace
+
+bool Recorder::start(const string &path) {
+    int f = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (f < 0) {
+        cout << "[Recorder] Cannot open " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    stop();
+
+    lock_guard<mutex> lock(writerMtx);
+    fd = f;
+    buffer.clear();
+    buffer.reserve(BLOCK_BYTES + 256);
+    buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    lastUs = monotonicUs();
+    lastNowMs = 0;
+    lastArrivals = 0;
+    namesWritten.clear();
+    recordCount = 0;
+    byteCount = 0;
+    on.store(true);
+    return true;
+}
+
+void Recorder::stop() {
+    on.store(false);
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    writeBuffer();
+    ::close(fd);
+    fd = -1;
+}
+
+void Recorder::controller(const string &site, const string &policy, const string &plan, int greenSeconds) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    uint32_t ids[3] = {NameTable::intern(site), NameTable::intern(policy), NameTable::intern(plan)};
+    for (uint32_t id : ids) {
+        defineName(id);
+    }
+    begin(RecordKind::CONTROLLER);
+    for (uint32_t id : ids) {
+        putVarint(id);
+    }
+    putSigned(greenSeconds);
+    end();
+}
+
+void Recorder::arrival(const Vehicle* v) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    defineName(v->getTypeId());
+    defineName(v->getOriginId());
+    defineName(v->getDestinationId());
+    begin(RecordKind::ARRIVAL);
+    putSigned(v->getId());
+    putVarint(v->getTypeId());
+    putVarint(v->getOriginId());
+    putVarint(v->getDestinationId());
+    putSigned(v->getArrivalTime());
+    putByte(static_cast<uint8_t>(directionIndex(v->getApproach()) | (movementIndex(v->getMovement()) << 2)));
+    end();
+}
+
+void Recorder::step(long nowMs, uint64_t arrivals, int seconds, int phase) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    begin(RecordKind::STEP);
+    putSigned(nowMs - lastNowMs);
+    putVarint(arrivals - lastArrivals);
+    putSigned(seconds);
+    putSigned(phase);
+    lastNowMs = nowMs;
+    lastArrivals = arrivals;
+    end();
+}
+
+void Recorder::crossing(const Vehicle* v, Direction lane) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    begin(RecordKind::CROSSING);
+    putSigned(v->getId());
+    putByte(static_cast<uint8_t>(directionIndex(lane)));
+    end();
+}
+
+void Recorder::hold(const Vehicle* v, Direction lane) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    begin(RecordKind::HOLD);
+    putSigned(v->getId());
+    putByte(static_cast<uint8_t>(directionIndex(lane)));
+    end();
+}
+
+void Recorder::preempt(int vehicleId, Direction lane, long dueMs) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    begin(RecordKind::PREEMPT);
+    putSigned(vehicleId);
+    putByte(static_cast<uint8_t>(directionIndex(lane)));
+    putSigned(dueMs);
+    end();
+}
+
+void Recorder::phase(int phase) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    begin(RecordKind::PHASE);
+    putSigned(phase);
+    end();
+}
+
+void Recorder::parking(LogEvent e, const string &lot, const Vehicle* v) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    uint32_t id = NameTable::intern(lot);
+    defineName(id);
+    begin(RecordKind::PARKING);
+    putByte(static_cast<uint8_t>(e));
+    putVarint(id);
+    putSigned(v ? v->getId() : -1);
+    end();
+}
+
+void Recorder::message(RecordKind kind, const ControllerMessage &msg) {
+    lock_guard<mutex> lock(writerMtx);
+    if (fd < 0) {
+        return;
+    }
+    uint32_t ids[5] = {
+        nameOf(msg.type, sizeof(msg.type)),
+        nameOf(msg.origin, sizeof(msg.origin)),
+        nameOf(msg.destination, sizeof(msg.destination)),
+        nameOf(msg.approach, sizeof(msg.approach)),
+        nameOf(msg.movement, sizeof(msg.movement)),
+    };
+    for (uint32_t id : ids) {
+        defineName(id);
+    }
+    begin(kind);
+    putSigned(msg.vehicleId);
+    putSigned(msg.priority);
+    putByte((msg.isEmergency ? 1 : 0) | static_cast<uint8_t>(msg.kind) << 1);
+    for (uint32_t id : ids) {
+        putVarint(id);
+    }
+    putSigned(msg.originNode);
+    putSigned(msg.destinationNode);
+    putSigned(msg.hops);
+    putSigned(msg.eta);
+    end();
+}
+
+unsigned long Recorder::records() {
+    lock_guard<mutex> lock(writerMtx);
+    return recordCount;
+}
+
+unsigned long Recorder::bytes() {
+    lock_guard<mutex> lock(writerMtx);
+    return byteCount + (fd >= 0 ? buffer.size() : 0);
+}
+
+namespace {
+
+// Bounds-checked decoding; after a failed read `ok` is false and every
+// further read returns 0.
+struct Cursor {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+
+    uint8_t byte() {
+        if (!ok || pos >= size) {
+            ok = false;
+            return 0;
+        }
+        return data[pos++];
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t zigzag() {
+        uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    uint32_t nameId() {
+        uint64_t id = varint();
+        if (id >= MAX_NAME_ID) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<uint32_t>(id);
+    }
+};
+
+} // namespace
+
+RecordingReader::RecordingReader()
+    : data(nullptr),
+      size(0),
+      pos(0),
+      timeUs(0),
+      lastNowMs(0),
+      lastArrivals(0),
+      truncated(false) {}
+
+RecordingReader::~RecordingReader() {
+    close();
+}
+
+bool RecordingReader::open(const string &path) {
+    close();
+    int f = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (f < 0) {
+        cout << "[Recording] Cannot open " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(f, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(MAGIC))) {
+        cout << "[Recording] " << path << " is not a recording" << endl;
+        ::close(f);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, f, 0);
+    ::close(f);
+    if (mapped == MAP_FAILED) {
+        cout << "[Recording] Cannot map " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    data = static_cast<const uint8_t*>(mapped);
+    size = static_cast<size_t>(st.st_size);
+    if (memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        cout << "[Recording] " << path << " is not a recording" << endl;
+        close();
+        return false;
+    }
+    madvise(const_cast<uint8_t*>(data), size, MADV_SEQUENTIAL);
+    rewind();
+    return true;
+}
+
+void RecordingReader::close() {
+    if (data) {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    pos = 0;
+}
+
+void RecordingReader::rewind() {
+    pos = data ? sizeof(MAGIC) : 0;
+    timeUs = 0;
+    lastNowMs = 0;
+    lastArrivals = 0;
+    names.clear();
+    truncated = false;
+}
+
+const string& RecordingReader::name(uint32_t id) const {
+    static const string none;
+    return id < names.size() ? names[id] : none;
+}
+
+bool RecordingReader::next(RecordedEvent &e) {
+    while (pos < size) {
+        Cursor in{data, size, pos, true};
+        e = RecordedEvent();
+        e.kind = static_cast<RecordKind>(in.byte());
+        uint64_t delta = in.varint();
+
+        switch (e.kind) {
+        case RecordKind::NAME: {
+            uint32_t id = in.nameId();
+            uint64_t length = in.varint();
+            if (!in.ok || length > size - in.pos) {
+                in.ok = false;
+                break;
+            }
+            if (id >= names.size()) {
+                names.resize(id + 1);
+            }
+            names[id].assign(reinterpret_cast<const char*>(data + in.pos), length);
+            in.pos += length;
+            break;
+        }
+        case RecordKind::CONTROLLER:
+            e.site = in.nameId();
+            e.policy = in.nameId();
+            e.plan = in.nameId();
+            e.seconds = static_cast<int>(in.zigzag());
+            break;
+        case RecordKind::ARRIVAL: {
+            e.vehicleId = static_cast<int>(in.zigzag());
+            e.type = in.nameId();
+            e.site = in.nameId();
+            e.destination = in.nameId();
+            e.arrivalTime = static_cast<int>(in.zigzag());
+            uint8_t laneAndMovement = in.byte();
+            if ((laneAndMovement & 3) >= DIRECTION_COUNT || (laneAndMovement >> 2) >= MOVEMENT_COUNT) {
+                in.ok = false;
+            }
+            e.lane = directionAt(laneAndMovement & 3);
+            e.movement = movementAt(laneAndMovement >> 2);
+            break;
+        }
+        case RecordKind::STEP:
+            e.nowMs = lastNowMs + static_cast<long>(in.zigzag());
+            e.arrivals = lastArrivals + in.varint();
+            e.seconds = static_cast<int>(in.zigzag());
+            e.phase = static_cast<int>(in.zigzag());
+            break;
+        case RecordKind::CROSSING:
+        case RecordKind::HOLD: {
+            e.vehicleId = static_cast<int>(in.zigzag());
+            uint8_t lane = in.byte();
+            if (lane >= DIRECTION_COUNT) {
+                in.ok = false;
+            }
+            e.lane = directionAt(lane & 3);
+            break;
+        }
+        case RecordKind::PREEMPT: {
+            e.vehicleId = static_cast<int>(in.zigzag());
+            uint8_t lane = in.byte();
+            if (lane >= DIRECTION_COUNT) {
+                in.ok = false;
+            }
+            e.lane = directionAt(lane & 3);
+            e.nowMs = static_cast<long>(in.zigzag());
+            break;
+        }
+        case RecordKind::PHASE:
+            e.phase = static_cast<int>(in.zigzag());
+            break;
+        case RecordKind::PARKING:
+            e.parking = static_cast<LogEvent>(in.byte());
+            e.site = in.nameId();
+            e.vehicleId = static_cast<int>(in.zigzag());
+            break;
+        case RecordKind::MESSAGE_SENT:
+        case RecordKind::MESSAGE_RECEIVED: {
+            ControllerMessage &m = e.message;
+            m.vehicleId = static_cast<int>(in.zigzag());
+            m.priority = static_cast<int>(in.zigzag());
+            uint8_t flags = in.byte();
+            m.isEmergency = (flags & 1) != 0;
+            m.kind = static_cast<MessageKind>(flags >> 1);
+            struct { char* field; size_t size; } strings[5] = {
+                {m.type, sizeof(m.type)}, {m.origin, sizeof(m.origin)},
+                {m.destination, sizeof(m.destination)}, {m.approach, sizeof(m.approach)},
+                {m.movement, sizeof(m.movement)},
+            };
+            for (auto &s : strings) {
+                strncpy(s.field, name(in.nameId()).c_str(), s.size - 1);
+            }
+            m.originNode = static_cast<int32_t>(in.zigzag());
+            m.destinationNode = static_cast<int32_t>(in.zigzag());
+            m.hops = static_cast<int32_t>(in.zigzag());
+            m.eta = static_cast<int32_t>(in.zigzag());
+            break;
+        }
+        default:
+            in.ok = false;
+            break;
+        }
+
+        if (!in.ok) {
+            truncated = true;
+            pos = size;
+            return false;
+        }
+        pos = in.pos;
+        timeUs += delta;
+        e.timeUs = timeUs;
+        if (e.kind == RecordKind::STEP) {
+            lastNowMs = e.nowMs;
+            lastArrivals = e.arrivals;
+        }
+        if (e.kind != RecordKind::NAME) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,145 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "TrafficController.h"
+#include "Log.h"
+
+using namespace std;
+
+class Vehicle;
+enum class Direction : uint8_t;
+enum class Movement : uint8_t;
+
+// What a record in a recording describes. The values are part of the file
+// format: add new kinds at the end.
+enum class RecordKind : uint8_t {
+    NAME = 1,         // defines a name id used by later records (read internally)
+    CONTROLLER,       // site, policy, phase plan and green seconds of the controller
+    ARRIVAL,          // a vehicle moved from its arrival queue into its lane
+    STEP,             // one TrafficController::step decision
+    CROSSING,         // a vehicle released by the controller
+    PHASE,            // a green opened (phase >= 0) or went red (phase -1)
+    PARKING,          // a parking lot event, see `parking`
+    MESSAGE_SENT,     // a ControllerMessage handed to the transport
+    MESSAGE_RECEIVED, // a ControllerMessage taken from the transport
+    HOLD,             // the departure check kept a vehicle at its stop line
+    PREEMPT           // the controller took a requestPreemption
+};
+
+// One decoded record. Only the fields listed for its kind are set; names
+// are ids for RecordingReader::name.
+struct RecordedEvent {
+    RecordKind kind;
+    uint64_t timeUs;         // since the recording started
+
+    int vehicleId;           // ARRIVAL, CROSSING, PARKING, HOLD, PREEMPT
+    uint32_t type;           // ARRIVAL: vehicle type name
+    uint32_t site;           // ARRIVAL: origin; CONTROLLER: intersection; PARKING: lot
+    uint32_t destination;    // ARRIVAL
+    int arrivalTime;         // ARRIVAL: scenario seconds
+    Direction lane;          // ARRIVAL, CROSSING, HOLD, PREEMPT
+    Movement movement;       // ARRIVAL
+
+    long nowMs;              // STEP: controller time; PREEMPT: when the vehicle is due
+    uint64_t arrivals;       // STEP: vehicles moved into the lanes before the decision
+    int seconds;             // STEP: how long it holds; CONTROLLER: green seconds
+    int phase;               // STEP, PHASE: plan index of the open green, or -1
+
+    uint32_t policy;         // CONTROLLER: makePhasePolicy name
+    uint32_t plan;           // CONTROLLER: PhasePlan::byName name
+
+    LogEvent parking;        // PARKING: WAITING_FULL, SPOT_ACQUIRED, PARKING_LEFT, ...
+
+    ControllerMessage message; // MESSAGE_*: sentAtNs is not recorded
+};
+
+// Process-wide recorder of everything that decides a controller's run:
+// arrivals in the order they enter the lanes, each step with the number of
+// arrivals its snapshot saw, and what the step did, plus parking events and
+// controller messages. That order is what thread scheduling decides, so a
+// recording replays the same decisions (see Replay.h).
+//
+// Records are appended to a binary file: a kind byte, the microseconds
+// since the previous record as a varint, then varint/zigzag fields; names
+// are written once and referred to by id. Writers serialize on one mutex
+// and the file is written in 64 KB blocks. Arrivals are recorded under the
+// intersection's lock, so record one controller per process; like Log, a
+// fork()ed process must start its own recording.
+class Recorder {
+public:
+    // Truncate or create `path` and start recording. Returns false (and
+    // prints why) if it cannot be opened. Replaces a running recording.
+    static bool start(const string &path);
+
+    // Write out what is buffered and close the file.
+    static void stop();
+
+    // Off (and one load per call site) until started.
+    static bool enabled() { return on.load(memory_order_relaxed); }
+
+    // Use these behind `if (Recorder::enabled())`.
+    static void controller(const string &site, const string &policy, const string &plan, int greenSeconds);
+    static void arrival(const Vehicle* v);
+    static void step(long nowMs, uint64_t arrivals, int seconds, int phase);
+    static void crossing(const Vehicle* v, Direction lane);
+    static void hold(const Vehicle* v, Direction lane);
+    static void preempt(int vehicleId, Direction lane, long dueMs);
+    static void phase(int phase);
+    static void parking(LogEvent e, const string &lot, const Vehicle* v);
+    static void message(RecordKind kind, const ControllerMessage &msg);
+
+    // Records and bytes written by the current or last recording.
+    static unsigned long records();
+    static unsigned long bytes();
+
+private:
+    static atomic<bool> on;
+};
+
+// Reads a recording through a read-only mapping of the whole file, so
+// records are decoded straight from the page cache. A file cut short (e.g.
+// by a crash) reads up to its last complete record.
+class RecordingReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    uint64_t timeUs;
+    long lastNowMs;
+    uint64_t lastArrivals;
+    vector<string> names;     // by name id
+    bool truncated;
+
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    // Map a recording. Returns false (and prints why) if it cannot be read
+    // or is not a recording.
+    bool open(const string &path);
+    void close();
+
+    // Decode the next record. Returns false at the end of the recording.
+    bool next(RecordedEvent &e);
+
+    // Start again from the first record.
+    void rewind();
+
+    // The string for a name id, or "" if the recording never defined it.
+    const string& name(uint32_t id) const;
+
+    // True if the last next() stopped at a partial or corrupt record.
+    bool truncatedTail() const { return truncated; }
+    size_t fileSize() const { return size; }
+};
+
+#endif
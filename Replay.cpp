@@ -0,0 +1,151 @@
+#include "Replay.h"
+#include "Recording.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "PhasePolicy.h"
+#include "PhasePlan.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <memory>
+
+#include <time.h>
+
+namespace {
+
+double monotonicSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void printIds(const vector<int> &ids) {
+    cout << "[";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        cout << (i ? " " : "") << ids[i];
+    }
+    cout << "]";
+}
+
+} // namespace
+
+bool replayRecording(RecordingReader &reader, ReplayResult &result) {
+    result = ReplayResult();
+    result.firstMismatch = -1;
+    double start = monotonicSeconds();
+
+    Intersection intersection;
+    unique_ptr<TrafficController> controller;
+    deque<Vehicle*> pending;   // recorded arrivals not yet queued
+    uint64_t queued = 0;       // arrivals handed to the intersection
+    vector<int> recordedCrossings, replayedCrossings;
+    vector<Vehicle*> crossed;
+    vector<int> held;          // vehicles the recorded step kept at the stop line
+
+    reader.rewind();
+    RecordedEvent e;
+    while (reader.next(e)) {
+        ++result.records;
+        switch (e.kind) {
+        case RecordKind::CONTROLLER: {
+            controller.reset(new TrafficController(&intersection, e.seconds));
+            controller->setPolicy(makePhasePolicy(reader.name(e.policy), e.seconds));
+            PhasePlan plan;
+            if (PhasePlan::byName(reader.name(e.plan), plan)) {
+                controller->setPhasePlan(plan);
+            }
+            controller->setCrossingCallback([&](Vehicle* v) {
+                replayedCrossings.push_back(v->getId());
+                crossed.push_back(v);
+            });
+            controller->setDepartureCheck([&](const Vehicle* v) {
+                return find(held.begin(), held.end(), v->getId()) == held.end();
+            });
+            cout << "[Replay] Controller " << reader.name(e.site) << ": policy "
+                 << controller->policyName() << ", phases " << reader.name(e.plan)
+                 << ", green " << e.seconds << " s" << endl;
+            break;
+        }
+        case RecordKind::ARRIVAL: {
+            Vehicle* v = VehicleStore::create(e.vehicleId, reader.name(e.type), reader.name(e.site),
+                                              reader.name(e.destination), e.arrivalTime);
+            v->setApproach(e.lane);
+            v->setMovement(e.movement);
+            pending.push_back(v);
+            ++result.arrivals;
+            break;
+        }
+        case RecordKind::CROSSING:
+            recordedCrossings.push_back(e.vehicleId);
+            break;
+        case RecordKind::HOLD:
+            held.push_back(e.vehicleId);
+            break;
+        case RecordKind::PREEMPT:
+            if (controller) {
+                controller->requestPreemption(e.vehicleId, e.lane, e.nowMs);
+            }
+            break;
+        case RecordKind::STEP: {
+            if (!controller) {
+                cout << "[Replay] Step before the controller record; not a controller recording" << endl;
+                result.wallSeconds = monotonicSeconds() - start;
+                return false;
+            }
+            while (queued < e.arrivals && !pending.empty()) {
+                Vehicle* v = pending.front();
+                pending.pop_front();
+                intersection.addVehicle(v->getApproach(), v);
+                ++queued;
+            }
+            controller->setNowMs(e.nowMs);
+            int seconds = controller->step();
+            int phase = controller->currentPhase();
+
+            if (queued != e.arrivals || seconds != e.seconds || phase != e.phase ||
+                replayedCrossings != recordedCrossings) {
+                if (result.mismatches++ == 0) {
+                    result.firstMismatch = static_cast<long>(result.steps);
+                    cout << "[Replay] Step " << result.steps << " at " << e.nowMs
+                         << " ms differs. Recorded: " << e.arrivals << " arrivals, "
+                         << e.seconds << " s, phase " << e.phase << ", crossed ";
+                    printIds(recordedCrossings);
+                    cout << ". Replayed: " << queued << " arrivals, " << seconds << " s, phase "
+                         << phase << ", crossed ";
+                    printIds(replayedCrossings);
+                    cout << "." << endl;
+                }
+            }
+            ++result.steps;
+            result.crossings += replayedCrossings.size();
+            recordedCrossings.clear();
+            replayedCrossings.clear();
+            held.clear();
+            for (Vehicle* v : crossed) {
+                VehicleStore::destroy(v);
+            }
+            crossed.clear();
+            break;
+        }
+        default:
+            break; // phase changes, parking and messages are not inputs
+        }
+    }
+
+    // Whatever was still queued or never reached the intersection.
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        while (Vehicle* v = intersection.popVehicle(directionAt(i))) {
+            VehicleStore::destroy(v);
+        }
+    }
+    for (Vehicle* v : pending) {
+        VehicleStore::destroy(v);
+    }
+
+    result.complete = !reader.truncatedTail();
+    result.wallSeconds = monotonicSeconds() - start;
+    return result.complete && result.mismatches == 0;
+}
@@ -0,0 +1,35 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+
+using namespace std;
+
+class RecordingReader;
+
+// What a replay did, and how it compared with the recording.
+struct ReplayResult {
+    unsigned long records;
+    unsigned long arrivals;
+    unsigned long steps;
+    unsigned long crossings;
+    unsigned long mismatches;  // steps whose outcome differs from the recording
+    long firstMismatch;        // index of the first such step, or -1
+    double wallSeconds;
+    bool complete;             // read to the end without a truncated tail
+};
+
+// Re-drive a TrafficController from a recording made with Recorder: build
+// the controller its CONTROLLER record describes, then before each STEP
+// queue exactly the arrivals that step's snapshot saw, set the recorded
+// controller time and call step(). Vehicles the recorded step held at the
+// stop line (a full road onward) are held again, and expected emergencies
+// are requested as the recorded controller took them. There are no
+// vehicle threads and no sleeps, so the controller runs at full speed.
+//
+// Each step's held seconds, open phase and released vehicles are checked
+// against the recording; the first difference is printed. Returns true if
+// every step matched and the whole recording was read.
+bool replayRecording(RecordingReader &reader, ReplayResult &result);
+
+#endif
@@ -0,0 +1,182 @@
+#include "RoadNetwork.h"
+
+#include <fstream>
+#include <sstream>
+#include <queue>
+#include <climits>
+
+RoadNetwork::RoadNetwork() {}
+
+int RoadNetwork::addNode(const string &name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    int id = static_cast<int>(names.size());
+    names.push_back(name);
+    ids[name] = id;
+    xs.push_back(0);
+    ys.push_back(0);
+    outLinks.emplace_back();
+    return id;
+}
+
+void RoadNetwork::setPosition(int node, double x, double y) {
+    xs[node] = x;
+    ys[node] = y;
+}
+
+int RoadNetwork::addLink(int from, int to, int travelTime, int capacity, Direction approach) {
+    int index = static_cast<int>(links.size());
+    links.push_back(RoadLink{from, to, travelTime, capacity, approach});
+    outLinks[from].push_back(index);
+    return index;
+}
+
+int RoadNetwork::findNode(const string &name) const {
+    auto it = ids.find(name);
+    return it == ids.end() ? -1 : it->second;
+}
+
+bool RoadNetwork::load(const string &path) {
+    ifstream in(path);
+    if (!in) {
+        cout << "[RoadNetwork] Cannot open " << path << endl;
+        return false;
+    }
+
+    string line;
+    int lineNo = 0;
+    while (getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != string::npos) {
+            line.erase(hash);
+        }
+
+        istringstream fields(line);
+        string kind;
+        if (!(fields >> kind)) {
+            continue;
+        }
+
+        if (kind == "node") {
+            string name;
+            if (!(fields >> name)) {
+                cout << "[RoadNetwork] " << path << ":" << lineNo << ": node needs a name" << endl;
+                return false;
+            }
+            int id = addNode(name);
+            double x, y;
+            if (fields >> x) {
+                if (!(fields >> y)) {
+                    cout << "[RoadNetwork] " << path << ":" << lineNo
+                         << ": expected node <name> [<x> <y>]" << endl;
+                    return false;
+                }
+                setPosition(id, x, y);
+            }
+        } else if (kind == "link") {
+            string from, to, approachName;
+            int travel, capacity;
+            Direction approach;
+            if (!(fields >> from >> to >> travel >> capacity >> approachName) ||
+                !parseDirection(approachName, approach) || travel <= 0 || capacity <= 0) {
+                cout << "[RoadNetwork] " << path << ":" << lineNo
+                     << ": expected link <from> <to> <travel_seconds> <capacity> <approach>" << endl;
+                return false;
+            }
+            addLink(addNode(from), addNode(to), travel, capacity, approach);
+        } else {
+            cout << "[RoadNetwork] " << path << ":" << lineNo << ": unknown entry '" << kind << "'" << endl;
+            return false;
+        }
+    }
+
+    computeRoutes();
+    return true;
+}
+
+RoadNetwork RoadNetwork::grid(int rows, int cols, int travelTime, int capacity) {
+    RoadNetwork net;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int id = net.addNode("R" + to_string(r) + "C" + to_string(c));
+            net.setPosition(id, c * BLOCK_METRES, r * BLOCK_METRES);
+        }
+    }
+
+    // A road heading east enters its destination on the WEST approach, etc.
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int id = r * cols + c;
+            if (c + 1 < cols) {
+                net.addLink(id, id + 1, travelTime, capacity, Direction::WEST);
+                net.addLink(id + 1, id, travelTime, capacity, Direction::EAST);
+            }
+            if (r + 1 < rows) {
+                net.addLink(id, id + cols, travelTime, capacity, Direction::NORTH);
+                net.addLink(id + cols, id, travelTime, capacity, Direction::SOUTH);
+            }
+        }
+    }
+
+    net.computeRoutes();
+    return net;
+}
+
+void RoadNetwork::computeRoutes() {
+    int n = nodeCount();
+    routes.assign(static_cast<size_t>(n) * n, -1);
+
+    // Incoming links per node, for searching backwards from each destination.
+    vector<vector<int>> inLinks(n);
+    for (int i = 0; i < linkCount(); ++i) {
+        inLinks[links[i].to].push_back(i);
+    }
+
+    vector<int> dist(n);
+    typedef pair<int, int> Item; // (distance, node)
+    for (int dest = 0; dest < n; ++dest) {
+        dist.assign(n, INT_MAX);
+        dist[dest] = 0;
+        priority_queue<Item, vector<Item>, greater<Item>> pq;
+        pq.push(Item(0, dest));
+
+        while (!pq.empty()) {
+            Item top = pq.top();
+            pq.pop();
+            int d = top.first;
+            int node = top.second;
+            if (d != dist[node]) {
+                continue;
+            }
+            for (int li : inLinks[node]) {
+                const RoadLink &l = links[li];
+                int nd = d + l.travelTime;
+                if (nd < dist[l.from]) {
+                    dist[l.from] = nd;
+                    routes[static_cast<size_t>(l.from) * n + dest] = li;
+                    pq.push(Item(nd, l.from));
+                }
+            }
+        }
+    }
+}
+
+int RoadNetwork::nextHop(int from, int dest) const {
+    if (from == dest) {
+        return -1;
+    }
+    return routes[static_cast<size_t>(from) * nodeCount() + dest];
+}
+
+int RoadNetwork::minTravelTime() const {
+    int best = INT_MAX;
+    for (const RoadLink &l : links) {
+        if (l.travelTime < best) {
+            best = l.travelTime;
+        }
+    }
+    return links.empty() ? 1 : best;
+}
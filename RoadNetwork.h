@@ -0,0 +1,81 @@
+#ifndef ROAD_NETWORK_H
+#define ROAD_NETWORK_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Intersection.h"
+
+using namespace std;
+
+// A directed road from one intersection to a neighbour.
+struct RoadLink {
+    int from;
+    int to;
+    int travelTime;      // seconds
+    int capacity;        // vehicles that fit on the road
+    Direction approach;  // lane the road feeds at `to`
+};
+
+// Graph of intersections and the roads between them, plus a next-hop
+// routing table (shortest travel time) for forwarding controller messages
+// and vehicles.
+//
+// Text format, one item per line, '#' starts a comment:
+//     node <name> [<x> <y>]
+//     link <from> <to> <travel_seconds> <capacity> <NORTH|SOUTH|EAST|WEST>
+// where the direction is the approach the road enters `to` from and the
+// optional node position is in metres (used for parking guidance).
+class RoadNetwork {
+public:
+    RoadNetwork();
+
+    // Load a network file. Returns false (and prints why) on error.
+    bool load(const string &path);
+
+    // rows x cols grid with two-way links between neighbours, nodes named
+    // "R<row>C<col>" and placed BLOCK_METRES apart. Used for benchmarks.
+    static const int BLOCK_METRES = 500;
+    static RoadNetwork grid(int rows, int cols, int travelTime = 30, int capacity = 20);
+
+    int addNode(const string &name);
+    void setPosition(int node, double x, double y);
+    int addLink(int from, int to, int travelTime, int capacity, Direction approach);
+
+    // Rebuild the routing table. Called by load() and grid(); call again
+    // after adding nodes or links by hand.
+    void computeRoutes();
+
+    int nodeCount() const { return static_cast<int>(names.size()); }
+    int linkCount() const { return static_cast<int>(links.size()); }
+
+    const string& nodeName(int node) const { return names[node]; }
+    double nodeX(int node) const { return xs[node]; }
+    double nodeY(int node) const { return ys[node]; }
+
+    // Node id for a name, or -1.
+    int findNode(const string &name) const;
+
+    const RoadLink& link(int index) const { return links[index]; }
+    const vector<int>& outgoing(int node) const { return outLinks[node]; }
+
+    // First link on the fastest path from `from` to `dest`, or -1 if
+    // unreachable or from == dest.
+    int nextHop(int from, int dest) const;
+
+    // Shortest link travel time; the safe lookahead for lockstep runs.
+    int minTravelTime() const;
+
+private:
+    vector<string> names;
+    map<string, int> ids;
+    vector<double> xs;
+    vector<double> ys;
+    vector<RoadLink> links;
+    vector<vector<int>> outLinks;
+    vector<int> routes; // routes[from * nodeCount() + dest] = link index
+};
+
+#endif
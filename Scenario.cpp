@@ -0,0 +1,244 @@
+#include "Scenario.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+#include <cstdlib>
+
+bool ScenarioReader::open(const string &file) {
+    path = file;
+    in.open(file);
+    if (!in) {
+        cout << "[Scenario] Cannot open " << file << endl;
+        error = true;
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioReader::next(VehicleSpec &spec) {
+    while (!error && getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != string::npos) {
+            line.erase(hash);
+        }
+        if (line.find_first_not_of(" \t\r") == string::npos) {
+            continue;
+        }
+
+        // Split in place into trimmed [begin, end) ranges, so a row costs
+        // no allocations once the strings have grown to size.
+        const char* text = line.c_str();
+        size_t begin[8], end[8];
+        int count = 0;
+        size_t pos = 0;
+        while (count < 8) {
+            size_t comma = line.find(',', pos);
+            size_t stop = comma == string::npos ? line.size() : comma;
+            size_t b = pos, e = stop;
+            while (b < e && (text[b] == ' ' || text[b] == '\t' || text[b] == '\r')) ++b;
+            while (e > b && (text[e - 1] == ' ' || text[e - 1] == '\t' || text[e - 1] == '\r')) --e;
+            if (comma == string::npos && b == e && count > 0) {
+                break; // trailing comma
+            }
+            begin[count] = b;
+            end[count] = e;
+            ++count;
+            if (comma == string::npos) {
+                break;
+            }
+            pos = comma + 1;
+        }
+
+        char* stop = nullptr;
+        long arrival = count >= 6 ? strtol(text + begin[4], &stop, 10) : -1;
+        spec.movement = Movement::STRAIGHT;
+        bool ok = count >= 6 && count <= 7 && end[1] > begin[1] && end[2] > begin[2] &&
+                  end[3] > begin[3] && end[4] > begin[4] && stop == text + end[4] && arrival >= 0;
+        if (ok) {
+            field.assign(line, begin[5], end[5] - begin[5]);
+            ok = parseDirection(field, spec.approach);
+        }
+        if (ok && count == 7) {
+            field.assign(line, begin[6], end[6] - begin[6]);
+            ok = parseMovement(field, spec.movement);
+        }
+        if (!ok) {
+            cout << "[Scenario] " << path << ":" << lineNo
+                 << ": expected id,type,origin,destination,arrival,approach[,movement]" << endl;
+            error = true;
+            return false;
+        }
+
+        spec.id = atoi(text + begin[0]);
+        spec.type.assign(line, begin[1], end[1] - begin[1]);
+        spec.origin.assign(line, begin[2], end[2] - begin[2]);
+        spec.destination.assign(line, begin[3], end[3] - begin[3]);
+        spec.arrival = static_cast<int>(arrival);
+        return true;
+    }
+    return false;
+}
+
+ScenarioFeed::ScenarioFeed(VehicleSpecSource &r, const string &originFilter)
+    : reader(r),
+      origin(originFilter),
+      hasPending(false),
+      exhausted(false),
+      lastArrival(0),
+      ringHead(0),
+      ringCount(0),
+      createdCount(0) {}
+
+ScenarioFeed::~ScenarioFeed() {
+    for (size_t i = 0; i < ringCount; ++i) {
+        VehicleStore::destroy(ring[(ringHead + i) & (ring.size() - 1)]);
+    }
+}
+
+void ScenarioFeed::setVehicleSetup(function<void(Vehicle*)> func) {
+    setup = func;
+}
+
+bool ScenarioFeed::fill() {
+    while (!hasPending && !exhausted) {
+        if (!reader.next(pending)) {
+            exhausted = true;
+            break;
+        }
+        if (!origin.empty() && pending.origin != origin) {
+            continue;
+        }
+        if (pending.arrival < lastArrival) {
+            // Injecting it now would schedule an arrival in the past.
+            cout << "[Scenario] Vehicle " << pending.id << " arrives at " << pending.arrival
+                 << " s, before the previous vehicle (" << lastArrival
+                 << " s); rows must be sorted by arrival time. Skipped." << endl;
+            continue;
+        }
+        lastArrival = pending.arrival;
+        hasPending = true;
+    }
+    return hasPending;
+}
+
+long ScenarioFeed::nextArrival() {
+    return fill() ? pending.arrival : -1;
+}
+
+Vehicle* ScenarioFeed::takeNext() {
+    if (!fill()) {
+        return nullptr;
+    }
+    hasPending = false;
+
+    Vehicle* v = VehicleStore::create(pending.id, pending.type, pending.origin,
+                                      pending.destination, pending.arrival);
+    v->setApproach(pending.approach);
+    v->setMovement(pending.movement);
+    if (setup) {
+        setup(v);
+    }
+    if (ringCount == ring.size()) {
+        // Full (or empty): double it, unwrapping the live range.
+        vector<Vehicle*> grown(ring.empty() ? 64 : ring.size() * 2);
+        for (size_t i = 0; i < ringCount; ++i) {
+            grown[i] = ring[(ringHead + i) & (ring.size() - 1)];
+        }
+        ring.swap(grown);
+        ringHead = 0;
+    }
+    ring[(ringHead + ringCount) & (ring.size() - 1)] = v;
+    ++ringCount;
+    ++createdCount;
+    return v;
+}
+
+void ScenarioFeed::collect() {
+    // Vehicles finish roughly in arrival order; one still queued holds back
+    // the ones behind it until it crosses.
+    while (ringCount > 0 && ring[ringHead]->isFinished()) {
+        VehicleStore::destroy(ring[ringHead]);
+        ringHead = (ringHead + 1) & (ring.size() - 1);
+        --ringCount;
+    }
+}
+
+namespace {
+
+template <typename T>
+vector<double> weightsOf(const vector<pair<T, double>> &items) {
+    vector<double> weights;
+    for (const auto &item : items) {
+        weights.push_back(item.second);
+    }
+    return weights;
+}
+
+} // namespace
+
+SyntheticTrace::SyntheticTrace(const TraceOptions &o)
+    : options(o),
+      rng(o.seed),
+      gap(o.vehiclesPerHour > 0 ? o.vehiclesPerHour / 3600.0 : 1.0),
+      destDist(0, o.origins.empty() ? 0 : o.origins.size() - 1),
+      nextId(0) {
+    vector<double> types = weightsOf(options.mix);
+    typeDist = discrete_distribution<size_t>(types.begin(), types.end());
+    vector<double> turns = weightsOf(options.turns);
+    turnDist = discrete_distribution<size_t>(turns.begin(), turns.end());
+    if (options.origins.empty() || options.mix.empty() || options.vehiclesPerHour <= 0) {
+        return; // no streams, no rows
+    }
+
+    // One arrival stream per (origin, approach); merging them by next
+    // arrival keeps the rows sorted without buffering them.
+    size_t streamCount = options.origins.size() * DIRECTION_COUNT;
+    for (size_t i = 0; i < streamCount; ++i) {
+        streams.push(Next(gap(rng), i));
+    }
+}
+
+bool SyntheticTrace::next(VehicleSpec &spec) {
+    while (!streams.empty()) {
+        Next n = streams.top();
+        streams.pop();
+        if (n.first >= options.duration) {
+            continue; // stream finished
+        }
+
+        spec.id = ++nextId;
+        spec.type = options.mix[typeDist(rng)].first;
+        spec.origin = options.origins[n.second / DIRECTION_COUNT];
+        spec.destination = options.origins[destDist(rng)];
+        spec.arrival = static_cast<int>(n.first);
+        spec.approach = directionAt(static_cast<int>(n.second % DIRECTION_COUNT));
+        spec.movement = options.turns.empty() ? Movement::STRAIGHT : options.turns[turnDist(rng)].first;
+
+        streams.push(Next(n.first + gap(rng), n.second));
+        return true;
+    }
+    return false;
+}
+
+unsigned long writeSyntheticTrace(ostream &out, const TraceOptions &options) {
+    if (options.origins.empty() || options.mix.empty() || options.vehiclesPerHour <= 0) {
+        return 0;
+    }
+
+    bool withTurns = !options.turns.empty();
+    out << "# id,type,origin,destination,arrival,approach" << (withTurns ? ",movement\n" : "\n");
+    SyntheticTrace trace(options);
+    VehicleSpec spec;
+    unsigned long written = 0;
+    while (trace.next(spec)) {
+        out << spec.id << ',' << spec.type << ',' << spec.origin << ',' << spec.destination << ','
+            << spec.arrival << ',' << directionName(spec.approach);
+        if (withTurns) {
+            out << ',' << movementName(spec.movement);
+        }
+        out << '\n';
+        ++written;
+    }
+    return written;
+}
@@ -0,0 +1,146 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <random>
+#include <queue>
+#include "Intersection.h"
+#include "EventSimulator.h"
+
+using namespace std;
+
+// One row of a scenario file.
+struct VehicleSpec {
+    int id;
+    string type;
+    string origin;
+    string destination;
+    int arrival;        // seconds after the start of the run
+    Direction approach; // lane the vehicle queues in at its origin
+    Movement movement;  // STRAIGHT unless the row says otherwise
+};
+
+// Yields vehicle rows in arrival order, one at a time.
+class VehicleSpecSource {
+public:
+    virtual ~VehicleSpecSource() {}
+
+    // The next row, or false when there are no more.
+    virtual bool next(VehicleSpec &spec) = 0;
+};
+
+// Streaming reader for scenario files: one vehicle per line,
+//
+//     id,type,origin,destination,arrival,approach[,movement]
+//
+// with '#' comments and blank lines ignored. Rows are read one at a time,
+// so a trace of any length is never held in memory.
+class ScenarioReader : public VehicleSpecSource {
+public:
+    bool open(const string &path);
+
+    // Read the next vehicle. Returns false at end of file or on a malformed
+    // row, which is reported with its line number and sets failed().
+    bool next(VehicleSpec &spec) override;
+
+    bool failed() const { return error; }
+
+private:
+    ifstream in;
+    string path;
+    string line;
+    string field; // scratch for parsing one field
+    int lineNo = 0;
+    bool error = false;
+};
+
+// Turns the rows of one origin into Vehicles as the simulation reaches
+// them. Rows must be sorted by arrival time. The feed owns every vehicle it
+// creates: collect() destroys the ones that have crossed and left parking,
+// the destructor destroys the rest. Once the live window has stopped
+// growing, a vehicle's trip through the feed allocates nothing.
+class ScenarioFeed : public VehicleSource {
+public:
+    // origin filters rows by their origin column; empty takes every row.
+    ScenarioFeed(VehicleSpecSource &source, const string &origin);
+    ~ScenarioFeed();
+
+    ScenarioFeed(const ScenarioFeed&) = delete;
+    ScenarioFeed& operator=(const ScenarioFeed&) = delete;
+
+    // Called on every new vehicle before it is handed out, e.g. to install
+    // its intersection access callback.
+    void setVehicleSetup(function<void(Vehicle*)> setup);
+
+    long nextArrival() override;
+    Vehicle* takeNext() override;
+    void collect() override;
+
+    // Vehicles created and not yet deleted.
+    size_t live() const { return ringCount; }
+    unsigned long created() const { return createdCount; }
+
+private:
+    bool fill();
+
+    VehicleSpecSource &reader;
+    string origin;
+    function<void(Vehicle*)> setup;
+
+    VehicleSpec pending;
+    bool hasPending;
+    bool exhausted;
+    int lastArrival;
+
+    // Live vehicles in arrival order, a ring with a power-of-two size.
+    vector<Vehicle*> ring;
+    size_t ringHead;
+    size_t ringCount;
+    unsigned long createdCount;
+};
+
+// Parameters of a synthetic trace.
+struct TraceOptions {
+    long duration = 3600;          // seconds of arrivals
+    double vehiclesPerHour = 120;  // Poisson rate on each approach of each origin
+    vector<string> origins{"F10", "F11"};
+    // Vehicle types with relative weights.
+    vector<pair<string, double>> mix{{"car", 60}, {"bike", 10}, {"bus", 10},
+                                     {"tractor", 10}, {"ambulance", 5}, {"firetruck", 5}};
+    // Movements with relative weights, e.g. {{STRAIGHT, 70}, {LEFT, 15},
+    // {RIGHT, 15}}. Empty writes no movement column (everyone goes straight).
+    vector<pair<Movement, double>> turns;
+    unsigned seed = 42;
+};
+
+// Independent Poisson arrivals on every approach of every origin, sorted by
+// arrival time, destinations drawn uniformly from the origins. Generated
+// row by row, so a run can be fed without writing a file.
+class SyntheticTrace : public VehicleSpecSource {
+public:
+    explicit SyntheticTrace(const TraceOptions &options);
+
+    bool next(VehicleSpec &spec) override;
+
+private:
+    typedef pair<double, size_t> Next; // time, stream
+
+    TraceOptions options;
+    mt19937 rng;
+    exponential_distribution<double> gap;
+    uniform_int_distribution<size_t> destDist;
+    discrete_distribution<size_t> typeDist;
+    discrete_distribution<size_t> turnDist;
+    priority_queue<Next, vector<Next>, greater<Next>> streams;
+    int nextId;
+};
+
+// Write a SyntheticTrace as a scenario file. Returns the number of vehicles
+// written.
+unsigned long writeSyntheticTrace(ostream &out, const TraceOptions &options);
+
+#endif
@@ -0,0 +1,232 @@
+#include "ShmTransport.h"
+#include "Metrics.h"
+#include "Recording.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <new>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Shared between the two processes. Producer and consumer indices live on
+// separate cache lines so they don't bounce together.
+struct ShmRingHeader {
+    alignas(64) atomic<uint64_t> head;        // next slot to write
+    alignas(64) atomic<uint64_t> tail;        // next slot to read
+    alignas(64) atomic<uint32_t> dataSeq;     // futex word: bumped when data arrives
+    atomic<uint32_t> spaceSeq;                // futex word: bumped when space frees up
+    atomic<uint32_t> readerWaiting;
+    atomic<uint32_t> writerWaiting;
+    atomic<uint32_t> closed;
+    uint64_t capacity;                        // power of two
+};
+
+static uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Shared (not FUTEX_PRIVATE) operations, since the word is in a mapping
+// used by two processes.
+static void futexWait(atomic<uint32_t> &word, uint32_t expected, int timeoutMs) {
+    timespec ts;
+    timespec* tsp = nullptr;
+    if (timeoutMs >= 0) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, tsp, nullptr, 0);
+}
+
+static void futexWakeAll(atomic<uint32_t> &word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+ShmRing::ShmRing(ShmRingHeader* h, ControllerMessage* s, size_t bytes)
+    : header(h), slots(s), mappedBytes(bytes) {}
+
+ShmRing* ShmRing::create(size_t capacity) {
+    uint64_t cap = 1;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "/traffic-ring-%d-%llu", static_cast<int>(getpid()),
+             static_cast<unsigned long long>(monotonicNs()));
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        perror("shm_open");
+        return nullptr;
+    }
+    shm_unlink(name); // the mapping keeps the memory alive
+
+    size_t headerBytes = (sizeof(ShmRingHeader) + 63) & ~static_cast<size_t>(63);
+    size_t bytes = headerBytes + cap * sizeof(ControllerMessage);
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == -1) {
+        perror("ftruncate");
+        ::close(fd);
+        return nullptr;
+    }
+
+    void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return nullptr;
+    }
+
+    // Fresh shm is zero-filled; placement-new just sets up the header.
+    ShmRingHeader* h = new (mem) ShmRingHeader();
+    h->head = 0;
+    h->tail = 0;
+    h->dataSeq = 0;
+    h->spaceSeq = 0;
+    h->readerWaiting = 0;
+    h->writerWaiting = 0;
+    h->closed = 0;
+    h->capacity = cap;
+
+    ControllerMessage* s = reinterpret_cast<ControllerMessage*>(static_cast<char*>(mem) + headerBytes);
+    return new ShmRing(h, s, bytes);
+}
+
+ShmRing::~ShmRing() {
+    munmap(header, mappedBytes);
+}
+
+bool ShmRing::push(const ControllerMessage &msg) {
+    uint64_t head = header->head.load(memory_order_relaxed);
+
+    while (head - header->tail.load(memory_order_acquire) >= header->capacity) {
+        if (header->closed.load()) {
+            return false;
+        }
+        // Full: sleep until the reader frees a slot.
+        header->writerWaiting.store(1);
+        uint32_t seq = header->spaceSeq.load();
+        if (head - header->tail.load() >= header->capacity) {
+            futexWait(header->spaceSeq, seq, 100);
+        }
+        header->writerWaiting.store(0);
+    }
+    if (header->closed.load(memory_order_relaxed)) {
+        return false;
+    }
+
+    slots[head & (header->capacity - 1)] = msg;
+    // seq_cst, not release: the store must not pass the readerWaiting load
+    // below. The reader sets readerWaiting before re-checking head, so
+    // either it sees this message or we see it waiting.
+    header->head.store(head + 1);
+    if (header->readerWaiting.load()) {
+        header->dataSeq.fetch_add(1);
+        futexWakeAll(header->dataSeq);
+    }
+    return true;
+}
+
+void ShmRing::close() {
+    header->closed.store(1);
+    header->dataSeq.fetch_add(1);
+    futexWakeAll(header->dataSeq);
+}
+
+int ShmRing::popAll(vector<ControllerMessage> &out, int timeoutMs) {
+    uint64_t tail = header->tail.load(memory_order_relaxed);
+    uint64_t head = header->head.load(memory_order_acquire);
+
+    if (head == tail) {
+        if (header->closed.load()) {
+            return -1;
+        }
+        if (timeoutMs == 0) {
+            return 0;
+        }
+
+        header->readerWaiting.store(1);
+        uint32_t seq = header->dataSeq.load();
+        head = header->head.load();
+        if (head == tail && !header->closed.load()) {
+            futexWait(header->dataSeq, seq, timeoutMs);
+            head = header->head.load(memory_order_acquire);
+        }
+        header->readerWaiting.store(0);
+
+        if (head == tail) {
+            return header->closed.load() ? -1 : 0;
+        }
+    }
+
+    uint64_t mask = header->capacity - 1;
+    int count = 0;
+    for (; tail != head; ++tail, ++count) {
+        out.push_back(slots[tail & mask]);
+    }
+    // seq_cst for the same reason as head in push(): a writer about to
+    // sleep on a full ring must see this tail or be seen waiting.
+    header->tail.store(tail);
+
+    if (header->writerWaiting.load()) {
+        header->spaceSeq.fetch_add(1);
+        futexWakeAll(header->spaceSeq);
+    }
+    return count;
+}
+
+ShmTransport::ShmTransport(ShmRing* rxRing, ShmRing* txRing)
+    : rx(rxRing), tx(txRing) {}
+
+bool ShmTransport::send(const ControllerMessage &msg) {
+    if (!tx) {
+        return false;
+    }
+    lock_guard<mutex> lock(txMtx);
+    ControllerMessage stamped = msg;
+    stamped.sentAtNs = monotonicNs();
+    Metrics::count(MetricCounter::MESSAGES_SENT);
+    if (Recorder::enabled()) {
+        Recorder::message(RecordKind::MESSAGE_SENT, stamped);
+    }
+    return tx->push(stamped);
+}
+
+bool ShmTransport::flush() {
+    return true;
+}
+
+int ShmTransport::receive(vector<ControllerMessage> &out, int timeoutMs) {
+    if (!rx) {
+        return -1;
+    }
+    size_t first = out.size();
+    int count = rx->popAll(out, timeoutMs);
+    if (count > 0 && Metrics::enabled()) {
+        uint64_t now = monotonicNs();
+        Metrics::count(MetricCounter::MESSAGES_RECEIVED, count);
+        for (size_t i = first; i < out.size(); ++i) {
+            Metrics::record(MetricHistogram::IPC_LATENCY, (now - out[i].sentAtNs) / 1000);
+        }
+    }
+    if (count > 0 && Recorder::enabled()) {
+        for (size_t i = first; i < out.size(); ++i) {
+            Recorder::message(RecordKind::MESSAGE_RECEIVED, out[i]);
+        }
+    }
+    return count;
+}
+
+void ShmTransport::closeSend() {
+    if (tx) {
+        lock_guard<mutex> lock(txMtx);
+        tx->close();
+    }
+}
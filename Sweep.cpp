@@ -0,0 +1,191 @@
+#include "Sweep.h"
+#include "Scenario.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "PhasePolicy.h"
+#include "PhasePlan.h"
+#include "EventSimulator.h"
+#include "ParkingLot.h"
+#include "Vehicle.h"
+#include "Log.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Results start a cache line after the shared next-point counter.
+const size_t RESULTS_OFFSET = 64;
+
+} // namespace
+
+size_t SweepGrid::size() const {
+    return greenSeconds.size() * parkingSpots.size() * vehiclesPerHour.size() * policies.size() * phases.size() *
+           static_cast<size_t>(max(replicates, 0));
+}
+
+SweepPoint SweepGrid::at(size_t index) const {
+    // Mixed radix, replicates varying fastest.
+    SweepPoint p;
+    p.seed = baseSeed + static_cast<unsigned>(index % replicates);
+    index /= replicates;
+    p.phases = phases[index % phases.size()];
+    index /= phases.size();
+    p.policy = policies[index % policies.size()];
+    index /= policies.size();
+    p.vehiclesPerHour = vehiclesPerHour[index % vehiclesPerHour.size()];
+    index /= vehiclesPerHour.size();
+    p.parkingSpots = parkingSpots[index % parkingSpots.size()];
+    index /= parkingSpots.size();
+    p.greenSeconds = greenSeconds[index % greenSeconds.size()];
+    return p;
+}
+
+SweepResult runSweepPoint(const SweepPoint &point, long duration) {
+    uint64_t start = nowNs();
+    SweepResult r;
+    memset(&r, 0, sizeof(r));
+
+    // A vehicle takes a spot or gives up as soon as it arrives, so the
+    // waiting area never fills and its size is not a parameter.
+    ParkingLot lot("F10", point.parkingSpots);
+    Intersection intersection(&lot);
+    TrafficController controller(&intersection, point.greenSeconds);
+    controller.setPolicy(makePhasePolicy(point.policy, point.greenSeconds));
+    PhasePlan plan;
+    if (PhasePlan::byName(point.phases, plan)) {
+        controller.setPhasePlan(plan);
+    }
+    EventSimulator sim(intersection, controller, &lot);
+
+    int queued = 0;
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&](Vehicle* v) {
+        intersection.addVehicle(v->getApproach(), v);
+        r.maxQueue = max(r.maxQueue, ++queued);
+    };
+    vector<int> waits;
+    controller.setCrossingCallback([&](Vehicle* v) {
+        --queued;
+        waits.push_back(static_cast<int>(sim.now() - v->getArrivalTime()));
+    });
+
+    TraceOptions trace;
+    trace.origins = {"F10"};
+    trace.duration = duration;
+    trace.vehiclesPerHour = point.vehiclesPerHour;
+    trace.seed = point.seed;
+    SyntheticTrace source(trace);
+    ScenarioFeed feed(source, "F10");
+    feed.setVehicleSetup([&hooks](Vehicle* v) { v->setHooks(&hooks); });
+    sim.setSource(&feed);
+
+    r.simSeconds = sim.run();
+
+    r.vehicles = static_cast<uint32_t>(feed.created());
+    r.crossings = static_cast<uint32_t>(controller.getCrossedCount());
+    if (!waits.empty()) {
+        double sum = 0;
+        for (int w : waits) {
+            sum += w;
+        }
+        r.meanWait = sum / waits.size();
+        r.maxWait = *max_element(waits.begin(), waits.end());
+        nth_element(waits.begin(), waits.begin() + (waits.size() * 95) / 100, waits.end());
+        r.p95Wait = waits[(waits.size() * 95) / 100];
+    }
+    ParkingStats parking = lot.stats();
+    r.parked = static_cast<uint32_t>(parking.spotsAcquired);
+    r.wallMs = (nowNs() - start) / 1e6;
+    r.done = true;
+    return r;
+}
+
+bool runSweep(const SweepGrid &grid, int jobs, vector<SweepResult> &results) {
+    size_t count = grid.size();
+    results.assign(count, SweepResult());
+    for (SweepResult &r : results) {
+        memset(&r, 0, sizeof(r));
+    }
+    if (count == 0) {
+        return true;
+    }
+    if (jobs <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? static_cast<int>(cpus) : 1;
+    }
+    jobs = static_cast<int>(min(static_cast<size_t>(jobs), count));
+
+    // Shared with the workers: the next point to take, then one result per
+    // point. Anonymous mappings start zeroed.
+    size_t bytes = RESULTS_OFFSET + count * sizeof(SweepResult);
+    void* shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        cout << "[Sweep] mmap of " << bytes << " bytes failed" << endl;
+        return false;
+    }
+    atomic<uint64_t>* next = new (shared) atomic<uint64_t>(0);
+    SweepResult* slots = reinterpret_cast<SweepResult*>(static_cast<char*>(shared) + RESULTS_OFFSET);
+
+    cout.flush(); // or each child would write the parent's buffer again
+    vector<pid_t> workers;
+    for (int i = 0; i < jobs; ++i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        if (pid == 0) {
+            Log::setMode(LogMode::OFF);
+            uint64_t index;
+            while ((index = next->fetch_add(1)) < count) {
+                slots[index] = runSweepPoint(grid.at(index), grid.duration);
+            }
+            _exit(0);
+        }
+        workers.push_back(pid);
+    }
+
+    bool ok = !workers.empty();
+    for (pid_t pid : workers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            cout << "[Sweep] Worker " << pid << " failed with status " << status << endl;
+            ok = false;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = slots[i];
+        ok = ok && results[i].done;
+    }
+    munmap(shared, bytes);
+    return ok;
+}
+
+void writeSweepCsv(ostream &out, const SweepGrid &grid, const vector<SweepResult> &results) {
+    out << "run,green_s,parking,rate_vph,policy,phases,seed,vehicles,crossings,"
+           "mean_wait_s,p95_wait_s,max_wait_s,max_queue,parked,sim_s,wall_ms,ok\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        SweepPoint p = grid.at(i);
+        const SweepResult &r = results[i];
+        out << i << ',' << p.greenSeconds << ',' << p.parkingSpots << ','
+            << p.vehiclesPerHour << ',' << p.policy << ',' << p.phases << ',' << p.seed << ','
+            << r.vehicles << ',' << r.crossings << ',' << r.meanWait << ',' << r.p95Wait << ','
+            << r.maxWait << ',' << r.maxQueue << ',' << r.parked << ','
+            << r.simSeconds << ',' << r.wallMs << ',' << (r.done ? 1 : 0) << '\n';
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// One configuration of a sweep: a single intersection with its own lot,
+// fed a synthetic trace.
+struct SweepPoint {
+    int greenSeconds;
+    int parkingSpots;
+    double vehiclesPerHour; // Poisson rate on each approach
+    string policy;          // see makePhasePolicy
+    string phases;          // see PhasePlan::byName
+    unsigned seed;
+};
+
+// Outcome of one run. Plain data, so workers can write it to shared memory.
+struct SweepResult {
+    uint32_t vehicles;
+    uint32_t crossings;
+    double meanWait;     // seconds, arrival to crossing
+    int32_t p95Wait;
+    int32_t maxWait;
+    int32_t maxQueue;    // most vehicles queued at once
+    uint32_t parked;
+    int64_t simSeconds;  // until the intersection drained
+    double wallMs;
+    bool done;
+};
+
+// The cartesian product of every parameter list, times `replicates` seeds.
+// Replicate r uses seed baseSeed + r at every point, so points are compared
+// on the same traffic.
+struct SweepGrid {
+    vector<int> greenSeconds{5};
+    vector<int> parkingSpots{10};
+    vector<double> vehiclesPerHour{120};
+    vector<string> policies{"fixed"};
+    vector<string> phases{"single"};
+    int replicates = 1;
+    unsigned baseSeed = 42;
+    long duration = 3600; // seconds of arrivals
+
+    size_t size() const;
+    SweepPoint at(size_t index) const;
+};
+
+// Simulate one point in virtual time on the calling thread until every
+// vehicle has crossed.
+SweepResult runSweepPoint(const SweepPoint &point, long duration);
+
+// Run every point of the grid on `jobs` forked worker processes (0: one
+// per online CPU). Each process has its own VehicleStore, log and metrics,
+// so runs share nothing but the index of the next point to take. Results
+// come back in grid order. Returns false if a worker died; its points are
+// left with done == false.
+bool runSweep(const SweepGrid &grid, int jobs, vector<SweepResult> &results);
+
+// One CSV row per point, with a header.
+void writeSweepCsv(ostream &out, const SweepGrid &grid, const vector<SweepResult> &results);
+
+#endif
@@ -0,0 +1,216 @@
+#include "TraceAnalysis.h"
+#include "Columns.h"
+#include "Intersection.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+const size_t CHUNK = 4096;
+const int PARKING_EVENTS = 8; // ParkingColumnEvent values, rounded up
+
+struct LaneCounts {
+    uint64_t arrivals;
+    uint64_t crossings;
+    HistogramSnapshot wait;
+};
+
+struct LotState {
+    uint64_t events[PARKING_EVENTS];
+    int64_t lastMs;
+    int parked;
+    int peak;
+    double spotMs;
+    bool seen;
+};
+
+string siteName(const ColumnSet &set, size_t index) {
+    if (index < set.sites().size() && !set.sites()[index].name.empty()) {
+        return set.sites()[index].name;
+    }
+    return "site" + to_string(index);
+}
+
+// Smallest and largest value of a time column.
+void timeRange(const int64_t* t, size_t n, int64_t &lo, int64_t &hi) {
+    int64_t a = lo, b = hi;
+    for (size_t i = 0; i < n; ++i) {
+        a = t[i] < a ? t[i] : a;
+        b = t[i] > b ? t[i] : b;
+    }
+    lo = a;
+    hi = b;
+}
+
+uint16_t maxSite(const uint16_t* site, size_t n) {
+    uint16_t m = 0;
+    for (size_t i = 0; i < n; ++i) {
+        m = site[i] > m ? site[i] : m;
+    }
+    return m;
+}
+
+// keys[j] = site * DIRECTION_COUNT + lane for one chunk of rows.
+void laneKeys(const uint16_t* site, const uint8_t* lane, size_t n, uint32_t* keys) {
+    for (size_t j = 0; j < n; ++j) {
+        keys[j] = site[j] * static_cast<uint32_t>(DIRECTION_COUNT) + (lane[j] & 3u);
+    }
+}
+
+void addHistogram(HistogramSnapshot &into, const HistogramSnapshot &from) {
+    into.count += from.count;
+    into.sum += from.sum;
+    for (int b = 0; b < MetricBuckets::COUNT; ++b) {
+        into.buckets[b] += from.buckets[b];
+    }
+}
+
+} // namespace
+
+void analyzeColumns(const ColumnSet &set, TraceReport &report) {
+    const ArrivalColumns &a = set.arrivals;
+    const CrossingColumns &c = set.crossings;
+    const ParkingColumns &p = set.parking;
+    report.rows += a.rows + c.rows + p.rows;
+    report.bytes += set.bytes();
+    if (a.rows + c.rows + p.rows == 0) {
+        return;
+    }
+
+    int64_t firstMs = INT64_MAX, lastMs = INT64_MIN;
+    timeRange(a.timeMs, a.rows, firstMs, lastMs);
+    timeRange(c.timeMs, c.rows, firstMs, lastMs);
+    timeRange(p.timeMs, p.rows, firstMs, lastMs);
+    size_t sites = 1 + max(max(maxSite(a.site, a.rows), maxSite(c.site, c.rows)), maxSite(p.site, p.rows));
+
+    // Lanes: count arrivals, then crossings and their waits.
+    vector<LaneCounts> lanes(sites * DIRECTION_COUNT);
+    uint32_t keys[CHUNK];
+    for (size_t base = 0; base < a.rows; base += CHUNK) {
+        size_t n = min(CHUNK, a.rows - base);
+        laneKeys(a.site + base, a.lane + base, n, keys);
+        for (size_t j = 0; j < n; ++j) {
+            ++lanes[keys[j]].arrivals;
+        }
+    }
+    for (size_t base = 0; base < c.rows; base += CHUNK) {
+        size_t n = min(CHUNK, c.rows - base);
+        laneKeys(c.site + base, c.lane + base, n, keys);
+        const int32_t* wait = c.waitMs + base;
+        for (size_t j = 0; j < n; ++j) {
+            LaneCounts &l = lanes[keys[j]];
+            uint64_t ms = wait[j] > 0 ? static_cast<uint64_t>(wait[j]) : 0;
+            ++l.crossings;
+            ++l.wait.count;
+            l.wait.sum += ms;
+            ++l.wait.buckets[MetricBuckets::indexOf(ms)];
+        }
+    }
+
+    // Lots: event counts and occupied spots integrated between rows.
+    vector<LotState> lots(sites);
+    for (size_t i = 0; i < p.rows; ++i) {
+        LotState &l = lots[p.site[i]];
+        int64_t t = p.timeMs[i];
+        if (l.seen && t > l.lastMs) {
+            l.spotMs += static_cast<double>(l.parked) * (t - l.lastMs);
+        }
+        if (!l.seen || t > l.lastMs) {
+            l.lastMs = t;
+        }
+        l.seen = true;
+        l.parked = p.parked[i];
+        l.peak = max(l.peak, l.parked);
+        ++l.events[p.event[i] & (PARKING_EVENTS - 1)];
+    }
+
+    // Merge into the report by name.
+    int64_t spanMs = lastMs - firstMs;
+    for (size_t s = 0; s < sites; ++s) {
+        string name = siteName(set, s);
+        for (int d = 0; d < DIRECTION_COUNT; ++d) {
+            const LaneCounts &l = lanes[s * DIRECTION_COUNT + d];
+            if (l.arrivals == 0 && l.crossings == 0) {
+                continue;
+            }
+            LaneStats* into = nullptr;
+            for (LaneStats &r : report.lanes) {
+                if (r.site == name && r.lane == directionAt(d)) {
+                    into = &r;
+                }
+            }
+            if (!into) {
+                report.lanes.push_back(LaneStats()); // zeroed
+                into = &report.lanes.back();
+                into->site = name;
+                into->lane = directionAt(d);
+            }
+            into->arrivals += l.arrivals;
+            into->crossings += l.crossings;
+            into->spanMs += spanMs;
+            addHistogram(into->wait, l.wait);
+        }
+
+        const LotState &l = lots[s];
+        if (!l.seen) {
+            continue;
+        }
+        LotStats* into = nullptr;
+        for (LotStats &r : report.lots) {
+            if (r.lot == name) {
+                into = &r;
+            }
+        }
+        if (!into) {
+            report.lots.push_back(LotStats()); // zeroed
+            into = &report.lots.back();
+            into->lot = name;
+        }
+        int capacity = s < set.sites().size() ? set.sites()[s].capacity : 0;
+        into->capacity = max(into->capacity, capacity);
+        into->reserved += l.events[static_cast<int>(ParkingColumnEvent::RESERVED)];
+        into->turnedAway += l.events[static_cast<int>(ParkingColumnEvent::TURNED_AWAY)];
+        into->parked += l.events[static_cast<int>(ParkingColumnEvent::PARKED)];
+        into->gaveUp += l.events[static_cast<int>(ParkingColumnEvent::GAVE_UP)];
+        into->left += l.events[static_cast<int>(ParkingColumnEvent::LEFT)];
+        into->peak = max(into->peak, l.peak);
+        // Whatever is parked at the lot's last row stays until the run ends.
+        into->spotMs += l.spotMs + static_cast<double>(l.parked) * max<int64_t>(0, lastMs - l.lastMs);
+        into->capacityMs += static_cast<double>(capacity) * spanMs;
+    }
+}
+
+void printTraceReport(TraceReport &report, ostream &out) {
+    sort(report.lanes.begin(), report.lanes.end(), [](const LaneStats &x, const LaneStats &y) {
+        return x.site != y.site ? x.site < y.site : directionIndex(x.lane) < directionIndex(y.lane);
+    });
+    sort(report.lots.begin(), report.lots.end(), [](const LotStats &x, const LotStats &y) {
+        return x.lot < y.lot;
+    });
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+
+    out << left << setw(16) << "lane" << right << setw(12) << "arrivals" << setw(12) << "crossings"
+        << setw(10) << "veh/h" << setw(10) << "mean_ms" << setw(10) << "p50_ms" << setw(10)
+        << "p90_ms" << setw(10) << "p99_ms" << setw(10) << "max_ms" << "\n";
+    for (const LaneStats &l : report.lanes) {
+        out << left << setw(16) << (l.site + " " + directionName(l.lane)) << right
+            << setw(12) << l.arrivals << setw(12) << l.crossings << fixed << setprecision(1)
+            << setw(10) << l.perHour() << setw(10) << l.wait.mean()
+            << setw(10) << l.wait.quantile(0.5) << setw(10) << l.wait.quantile(0.9)
+            << setw(10) << l.wait.quantile(0.99) << setw(10) << l.wait.max() << "\n";
+    }
+
+    out << "\n" << left << setw(16) << "lot" << right << setw(10) << "capacity" << setw(12)
+        << "parked" << setw(12) << "turned_away" << setw(10) << "gave_up" << setw(8) << "peak"
+        << setw(14) << "utilization" << "\n";
+    for (const LotStats &l : report.lots) {
+        out << left << setw(16) << l.lot << right << setw(10) << l.capacity << setw(12) << l.parked
+            << setw(12) << l.turnedAway << setw(10) << l.gaveUp << setw(8) << l.peak
+            << setw(13) << fixed << setprecision(1) << 100.0 * l.utilization() << "%\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+    out.flush();
+}
@@ -0,0 +1,65 @@
+#ifndef TRACE_ANALYSIS_H
+#define TRACE_ANALYSIS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Metrics.h"
+
+using namespace std;
+
+class ColumnSet;
+enum class Direction : uint8_t;
+
+// One approach of one intersection.
+struct LaneStats {
+    string site;
+    Direction lane;
+    uint64_t arrivals;
+    uint64_t crossings;
+    int64_t spanMs;           // run time the lane was observed over
+    HistogramSnapshot wait;   // arrival-to-crossing ms
+
+    double perHour() const { return spanMs > 0 ? crossings * 3600000.0 / spanMs : 0; }
+};
+
+// One parking lot. Utilization is the time-weighted mean of occupied spots
+// over capacity, from the first row of the run to the last.
+struct LotStats {
+    string lot;
+    int capacity;
+    uint64_t reserved;
+    uint64_t turnedAway;
+    uint64_t parked;
+    uint64_t gaveUp;
+    uint64_t left;
+    int peak;
+    double spotMs;            // occupied spots integrated over time
+    double capacityMs;        // capacity times run time
+
+    double utilization() const { return capacityMs > 0 ? spotMs / capacityMs : 0; }
+};
+
+// What analyzeColumns found, summed over every ColumnSet given to it.
+// Lanes and lots with the same name in several sets are merged.
+struct TraceReport {
+    unsigned long rows;
+    unsigned long bytes;
+    vector<LaneStats> lanes;
+    vector<LotStats> lots;
+
+    TraceReport() : rows(0), bytes(0) {}
+};
+
+// Add per-lane throughput and wait distribution and per-lot parking
+// utilization from the mapped columns of one run to `report`. Each table
+// is read front to back once; the crossing and arrival passes build lane
+// keys a chunk at a time in a loop the compiler vectorizes, then count.
+void analyzeColumns(const ColumnSet &set, TraceReport &report);
+
+// Sort lanes and lots by name and print them as two tables.
+void printTraceReport(TraceReport &report, ostream &out);
+
+#endif
@@ -1,207 +1,428 @@
-#include "TrafficController.h"
-#include "Intersection.h"
-#include "Vehicle.h"
-
-TrafficLight::TrafficLight(const string &dir)
-    : direction(dir), green(false) {}
-
-void TrafficLight::setGreen(bool status) {
-    green = status;
-}
-
-void TrafficLight::setRed(bool status) {
-    green = !status;
-}
-
-bool TrafficLight::isGreen() const {
-    return green;
-}
-
-string TrafficLight::getDirection() const {
-    return direction;
-}
-
-TrafficController::TrafficController(Intersection* inter, int greenTime)
-    : intersection(inter),
-      northLight(Direction::NORTH),
-      southLight(Direction::SOUTH),
-      eastLight(Direction::EAST),
-      westLight(Direction::WEST),
-      greenDuration(greenTime),
-      running(true) {}
-
-Vehicle* TrafficController::checkEmergency() const {
-    if (intersection->hasVehicle(Direction::NORTH)) {
-        Vehicle* v = intersection->getNextVehicle(Direction::NORTH);
-        if (v && v->isEmergency()) return v;
-    }
-
-    if (intersection->hasVehicle(Direction::SOUTH)) {
-        Vehicle* v = intersection->getNextVehicle(Direction::SOUTH);
-        if (v && v->isEmergency()) return v;
-    }
-
-    if (intersection->hasVehicle(Direction::EAST)) {
-        Vehicle* v = intersection->getNextVehicle(Direction::EAST);
-        if (v && v->isEmergency()) return v;
-    }
-
-    if (intersection->hasVehicle(Direction::WEST)) {
-        Vehicle* v = intersection->getNextVehicle(Direction::WEST);
-        if (v && v->isEmergency()) return v;
-    }
-
-    return nullptr;
-}
-
-void TrafficController::crossVehicle(Vehicle* v) {
-    if (!v) {
-        return;
-    }
-
-    cout << "[TrafficController] Vehicle " << v->getId() << " (" << v->getType()
-         << ") is crossing from " << v->getOrigin() << " to " << v->getDestination() << endl;
-
-    // Determine from which lane this vehicle is crossing by checking
-    // which directional lane has it at the front. This keeps all
-    // lane and priority management inside the existing abstractions.
-    string dir;
-    if (intersection->hasVehicle(Direction::NORTH) &&
-        intersection->getNextVehicle(Direction::NORTH) == v) {
-        dir = Direction::NORTH;
-    } else if (intersection->hasVehicle(Direction::SOUTH) &&
-               intersection->getNextVehicle(Direction::SOUTH) == v) {
-        dir = Direction::SOUTH;
-    } else if (intersection->hasVehicle(Direction::EAST) &&
-               intersection->getNextVehicle(Direction::EAST) == v) {
-        dir = Direction::EAST;
-    } else if (intersection->hasVehicle(Direction::WEST) &&
-               intersection->getNextVehicle(Direction::WEST) == v) {
-        dir = Direction::WEST;
-    }
-
-    if (!dir.empty()) {
-        intersection->removeVehicle(dir);
-    } else {
-        cout << "[TrafficController] Warning: vehicle " << v->getId()
-             << " not found at the front of any lane; skipping removal." << endl;
-    }
-
-    sleep(2); // simulate crossing time
-}
-
-void TrafficController::runController() {
-    int cycle = 1;
-    while (running) {
-        // Always serve emergencies first.
-        Vehicle* emergencyVehicle = checkEmergency();
-        if (emergencyVehicle) {
-            cout << "\n[TrafficController] EMERGENCY phase: giving priority to vehicle "
-                 << emergencyVehicle->getId() << " (" << emergencyVehicle->getType() << ")" << endl;
-
-            // For visualization, briefly turn all lights red during emergency.
-            northLight.setRed(true);
-            southLight.setRed(true);
-            eastLight.setRed(true);
-            westLight.setRed(true);
-
-            crossVehicle(emergencyVehicle);
-            cout << endl;
-            continue;
-        }
-
-        cout << "\n[TrafficController] === Traffic light cycle " << cycle << " ===" << endl;
-
-        // ---------------- NORTH lane phase ----------------
-        cout << "[TrafficController] Phase: NORTH lane GREEN" << endl;
-        northLight.setGreen(true);
-        southLight.setRed(true);
-        eastLight.setRed(true);
-        westLight.setRed(true);
-
-        if (intersection->hasVehicle(Direction::NORTH)) {
-            Vehicle* v = intersection->getNextVehicle(Direction::NORTH);
-            crossVehicle(v);
-        }
-
-        sleep(greenDuration);
-        northLight.setRed(true);
-        cout << "[TrafficController] Phase: NORTH lane RED" << endl;
-
-        // ---------------- SOUTH lane phase ----------------
-        cout << "\n[TrafficController] Phase: SOUTH lane GREEN" << endl;
-        northLight.setRed(true);
-        southLight.setGreen(true);
-        eastLight.setRed(true);
-        westLight.setRed(true);
-
-        if (intersection->hasVehicle(Direction::SOUTH)) {
-            Vehicle* v = intersection->getNextVehicle(Direction::SOUTH);
-            crossVehicle(v);
-        }
-
-        sleep(greenDuration);
-        southLight.setRed(true);
-        cout << "[TrafficController] Phase: SOUTH lane RED" << endl;
-
-        // ---------------- EAST lane phase ----------------
-        cout << "\n[TrafficController] Phase: EAST lane GREEN" << endl;
-        northLight.setRed(true);
-        southLight.setRed(true);
-        eastLight.setGreen(true);
-        westLight.setRed(true);
-
-        if (intersection->hasVehicle(Direction::EAST)) {
-            Vehicle* v = intersection->getNextVehicle(Direction::EAST);
-            crossVehicle(v);
-        }
-
-        sleep(greenDuration);
-        eastLight.setRed(true);
-        cout << "[TrafficController] Phase: EAST lane RED" << endl;
-
-        // ---------------- WEST lane phase ----------------
-        cout << "\n[TrafficController] Phase: WEST lane GREEN" << endl;
-        northLight.setRed(true);
-        southLight.setRed(true);
-        eastLight.setRed(true);
-        westLight.setGreen(true);
-
-        if (intersection->hasVehicle(Direction::WEST)) {
-            Vehicle* v = intersection->getNextVehicle(Direction::WEST);
-            crossVehicle(v);
-        }
-
-        sleep(greenDuration);
-        westLight.setRed(true);
-        cout << "[TrafficController] Phase: WEST lane RED" << endl;
-
-        cout << "[TrafficController] === End of cycle " << cycle << " ===" << endl;
-        ++cycle;
-    }
-}
-
-void* TrafficController::runThread(void* arg) {
-    TrafficController* controller = static_cast<TrafficController*>(arg);
-    controller->runController();
-    return nullptr;
-}
-
-void TrafficController::startController() {
-    pthread_create(&controllerThread, nullptr, runThread, this);
-}
-
-void TrafficController::stopController() {
-    running = false;
-    pthread_join(controllerThread, nullptr);
-}
-
-bool TrafficController::sendMessage(int fd, const ControllerMessage &msg) {
-    ssize_t written = write(fd, &msg, sizeof(msg));
-    return written == static_cast<ssize_t>(sizeof(msg));
-}
-
-bool TrafficController::receiveMessage(int fd, ControllerMessage &msg) {
-    ssize_t readBytes = read(fd, &msg, sizeof(msg));
-    return readBytes == static_cast<ssize_t>(sizeof(msg));
-}
+#include "TrafficController.h"
+#include "Intersection.h"
+#include "Vehicle.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Recording.h"
+#include "Columns.h"
+#include "PhasePolicy.h"
+#include "PhasePlan.h"
+
+#include <cerrno>
+#include <algorithm>
+#include <chrono>
+
+TrafficLight::TrafficLight(Direction dir)
+    : direction(dir), green(false) {}
+
+void TrafficLight::setGreen(bool status) {
+    green = status;
+}
+
+void TrafficLight::setRed(bool status) {
+    green = !status;
+}
+
+bool TrafficLight::isGreen() const {
+    return green;
+}
+
+Direction TrafficLight::getDirection() const {
+    return direction;
+}
+
+TrafficController::TrafficController(Intersection* inter, int greenTime)
+    : intersection(inter),
+      lights{TrafficLight(Direction::NORTH), TrafficLight(Direction::SOUTH),
+             TrafficLight(Direction::EAST), TrafficLight(Direction::WEST)},
+      policy(new FixedTimePolicy(greenTime)),
+      plan(new PhasePlan(PhasePlan::singleDirection())),
+      running(true),
+      timeScale(1.0),
+      nowMs(0),
+      emergenciesSeen(0),
+      cycle(1),
+      cycleOpen(false),
+      phaseIndex(0),
+      phaseOpen(false),
+      phaseElapsed(0),
+      phaseServed(0),
+      crossedCount(0),
+      heldCount(0),
+      preemptRequested(false),
+      preemptionCount(0) {}
+
+TrafficController::~TrafficController() {}
+
+void TrafficController::setPolicy(unique_ptr<PhasePolicy> p) {
+    if (p) {
+        closePhase();
+        policy = move(p);
+    }
+}
+
+const char* TrafficController::policyName() const {
+    return policy->name();
+}
+
+void TrafficController::setPhasePlan(const PhasePlan &p) {
+    closePhase();
+    plan.reset(new PhasePlan(p));
+}
+
+const PhasePlan& TrafficController::phasePlan() const {
+    return *plan;
+}
+
+void TrafficController::setCrossingCallback(function<void(Vehicle*)> func) {
+    onCrossing = func;
+}
+
+void TrafficController::setDepartureCheck(function<bool(const Vehicle*)> check) {
+    mayDepart = check;
+}
+
+bool TrafficController::canDepart(const Vehicle* v, Direction lane) {
+    if (!mayDepart || mayDepart(v)) {
+        return true;
+    }
+    ++heldCount;
+    if (Recorder::enabled()) {
+        Recorder::hold(v, lane);
+    }
+    return false;
+}
+
+void TrafficController::requestPreemption(int vehicleId, Direction approach, long dueMs) {
+    lock_guard<mutex> lock(preemptMtx);
+    requested.push_back(Preemption{vehicleId, approach, dueMs});
+    preemptRequested = true;
+}
+
+void TrafficController::takePreemptions() {
+    if (preemptRequested.load(memory_order_acquire)) {
+        lock_guard<mutex> lock(preemptMtx);
+        for (const Preemption &r : requested) {
+            auto same = find_if(preemptions.begin(), preemptions.end(),
+                                [&](const Preemption &p) { return p.vehicleId == r.vehicleId; });
+            if (same != preemptions.end()) {
+                *same = r;
+            } else {
+                preemptions.push_back(r);
+            }
+            if (Recorder::enabled()) {
+                Recorder::preempt(r.vehicleId, r.approach, r.dueMs);
+            }
+        }
+        requested.clear();
+        preemptRequested = false;
+    }
+    preemptions.erase(remove_if(preemptions.begin(), preemptions.end(),
+                                [this](const Preemption &p) { return nowMs > p.dueMs + PREEMPT_TIMEOUT * 1000L; }),
+                      preemptions.end());
+}
+
+const TrafficController::Preemption* TrafficController::activePreemption() const {
+    const Preemption* first = nullptr;
+    for (const Preemption &p : preemptions) {
+        if (nowMs < p.dueMs - PRECLEAR_TIME * 1000L) {
+            continue;
+        }
+        if (!first || p.dueMs < first->dueMs || (p.dueMs == first->dueMs && p.vehicleId < first->vehicleId)) {
+            first = &p;
+        }
+    }
+    return first;
+}
+
+void TrafficController::setTimeScale(double scale) {
+    if (scale > 0) {
+        timeScale = scale;
+    }
+}
+
+Vehicle* TrafficController::checkEmergency() const {
+    return intersection->nextEmergency();
+}
+
+bool TrafficController::releaseVehicle(const LaneTicket &ticket) {
+    Vehicle* v = ticket.get();
+    if (!v) {
+        return false;
+    }
+
+    LOG_EVENT(INFO, LogEvent::CROSSING, v, v->getOrigin(), v->getDestination());
+
+    if (!intersection->removeVehicle(ticket)) {
+        LOG_EVENT(WARN, LogEvent::CROSSING_NOT_FOUND, v);
+        return false;
+    }
+    ++crossedCount;
+    if (!preemptions.empty()) {
+        int id = v->getId();
+        preemptions.erase(remove_if(preemptions.begin(), preemptions.end(),
+                                    [id](const Preemption &p) { return p.vehicleId == id; }),
+                          preemptions.end());
+    }
+    if (Recorder::enabled()) {
+        Recorder::crossing(v, ticket.lane);
+    }
+    if (Metrics::enabled()) {
+        Metrics::count(MetricCounter::VEHICLES_CROSSED);
+        Metrics::recordWait(v->getVehicleType(), max(0L, nowMs - v->getArrivalTime() * 1000L));
+    }
+    if (ColumnWriter::enabled()) {
+        ColumnWriter::crossing(v, ticket.lane, max(0L, nowMs - v->getArrivalTime() * 1000L));
+    }
+    if (onCrossing) {
+        onCrossing(v);
+    }
+    // Last: from here on the vehicle's owner may free it (see
+    // setCrossingCallback).
+    v->markCrossed();
+    return true;
+}
+
+bool TrafficController::releaseVehicle(Vehicle* v) {
+    if (!v) {
+        return false;
+    }
+    return releaseVehicle(LaneTicket::of(v, v->getApproach()));
+}
+
+void TrafficController::crossVehicle(Vehicle* v) {
+    if (!v) {
+        return;
+    }
+
+    releaseVehicle(v);
+    sleep(CROSSING_TIME); // simulate crossing time
+}
+
+void TrafficController::closePhase() {
+    if (!phaseOpen) {
+        return;
+    }
+    phaseOpen = false;
+
+    const Phase &phase = plan->at(phaseIndex);
+    for (TrafficLight &light : lights) {
+        if (phase.greenOn(light.getDirection())) {
+            light.setRed(true);
+        }
+    }
+    LOG_EVENT(INFO, LogEvent::PHASE_RED, nullptr, phase.name);
+    if (Recorder::enabled()) {
+        Recorder::phase(-1);
+    }
+}
+
+void TrafficController::openPhase(int index, bool blankLine) {
+    phaseIndex = index;
+    const Phase &phase = plan->at(phaseIndex);
+    LOG_EVENT(INFO, LogEvent::PHASE_GREEN, nullptr, phase.name, string(), blankLine);
+    Metrics::count(MetricCounter::GREEN_PHASES);
+    if (Recorder::enabled()) {
+        Recorder::phase(phaseIndex);
+    }
+    for (TrafficLight &light : lights) {
+        light.setGreen(phase.greenOn(light.getDirection()));
+    }
+    phaseOpen = true;
+    phaseElapsed = 0;
+    phaseServed = 0;
+}
+
+int TrafficController::servePreemption(const LaneSnapshot &snap, const Preemption &p) {
+    if (!phaseOpen || !plan->at(phaseIndex).greenOn(p.approach)) {
+        int index = 0;
+        while (index < plan->size() && !plan->at(index).greenOn(p.approach)) {
+            ++index;
+        }
+        if (index == plan->size()) {
+            return 0;
+        }
+        closePhase();
+        LOG_EVENT(INFO, LogEvent::PREEMPT_GREEN, nullptr, plan->at(index).name, directionName(p.approach),
+                  static_cast<int>(max(0L, p.dueMs - nowMs) / 1000));
+        openPhase(index, true);
+        ++preemptionCount;
+    }
+
+    // Clear whatever the green serves; wait a second at a time for the
+    // vehicle when there is nothing to release.
+    const Phase &phase = plan->at(phaseIndex);
+    int seconds = PhasePolicy::IDLE_SECONDS;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        if (phase.serves(directionAt(i), snap.heads[i]) && canDepart(snap.heads[i], directionAt(i))) {
+            releaseVehicle(snap.ticket(directionAt(i)));
+            ++phaseServed;
+            seconds = CROSSING_TIME;
+        }
+    }
+    phaseElapsed += seconds;
+    return seconds;
+}
+
+int TrafficController::continueGreen(const LaneSnapshot &snap) {
+    const Phase &phase = plan->at(phaseIndex);
+    GreenStep next = policy->greenStep(snap, phase, phaseElapsed, phaseServed);
+
+    int seconds = 0;
+    if (next.action == GreenStep::RELEASE) {
+        // Compatible movements cross side by side in the same CROSSING_TIME.
+        for (int i = 0; i < DIRECTION_COUNT; ++i) {
+            if (phase.serves(directionAt(i), snap.heads[i]) && canDepart(snap.heads[i], directionAt(i))) {
+                releaseVehicle(snap.ticket(directionAt(i)));
+                ++phaseServed;
+            }
+        }
+        seconds = CROSSING_TIME;
+    } else if (next.action == GreenStep::HOLD) {
+        seconds = max(next.seconds, 1);
+    }
+    phaseElapsed += seconds;
+    return seconds;
+}
+
+int TrafficController::step() {
+    // Emergencies counted from here on wake the real-time loop early.
+    emergenciesSeen = intersection->emergencyArrivalCount();
+
+    // Pull in everything that arrived since the last decision.
+    intersection->drainArrivals();
+    LaneSnapshot snap = intersection->snapshot();
+    if (Metrics::enabled()) {
+        for (int i = 0; i < DIRECTION_COUNT; ++i) {
+            Metrics::recordQueueLength(directionAt(i), snap.sizes[i]);
+        }
+    }
+
+    takePreemptions();
+    int seconds = decide(snap);
+    if (Recorder::enabled()) {
+        Recorder::step(nowMs, snap.arrivals, seconds, currentPhase());
+    }
+    return seconds;
+}
+
+int TrafficController::decide(const LaneSnapshot &snap) {
+    // An emergency whose road onward is full waits like everyone else.
+    if (snap.emergency && canDepart(snap.emergency, snap.emergencyLane)) {
+        closePhase(); // preempt the current green
+        LOG_EVENT(INFO, LogEvent::EMERGENCY_PHASE, snap.emergency);
+        if (Metrics::enabled()) {
+            Metrics::count(MetricCounter::EMERGENCY_PREEMPTIONS);
+            Metrics::record(MetricHistogram::PREEMPTION_LATENCY,
+                            max(0L, nowMs - snap.emergency->getArrivalTime() * 1000L));
+        }
+
+        // For visualization, briefly turn all lights red during emergency.
+        for (TrafficLight &light : lights) {
+            light.setRed(true);
+        }
+
+        releaseVehicle(LaneTicket::of(snap.emergency, snap.emergencyLane));
+        return CROSSING_TIME;
+    }
+
+    if (const Preemption* p = activePreemption()) {
+        int seconds = servePreemption(snap, *p);
+        if (seconds > 0) {
+            return seconds;
+        }
+    }
+
+    if (phaseOpen) {
+        int seconds = continueGreen(snap);
+        if (seconds > 0) {
+            return seconds;
+        }
+        closePhase();
+    }
+
+    PhaseChoice choice;
+    if (!policy->choosePhase(snap, *plan, choice)) {
+        return PhasePolicy::IDLE_SECONDS; // all red until something arrives
+    }
+
+    if (choice.cycleStart) {
+        if (cycleOpen) {
+            LOG_EVENT(INFO, LogEvent::CYCLE_END, nullptr, string(), string(), cycle);
+            ++cycle;
+        }
+        cycleOpen = true;
+        LOG_EVENT(INFO, LogEvent::CYCLE_START, nullptr, string(), string(), cycle);
+    }
+
+    // Green for every approach with a movement in the phase, red for the rest.
+    openPhase(choice.phase, !choice.cycleStart);
+
+    int seconds = continueGreen(snap);
+    if (seconds == 0) {
+        closePhase(); // the policy ended the green straight away
+        return PhasePolicy::IDLE_SECONDS;
+    }
+    return seconds;
+}
+
+void TrafficController::runController() {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (running) {
+        nowMs = static_cast<long>(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / timeScale);
+        int seconds = step();
+        chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+            chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds * timeScale));
+        intersection->waitForEmergency(emergenciesSeen, deadline);
+    }
+    closePhase();
+}
+
+void* TrafficController::runThread(void* arg) {
+    TrafficController* controller = static_cast<TrafficController*>(arg);
+    controller->runController();
+    return nullptr;
+}
+
+void TrafficController::startController() {
+    pthread_create(&controllerThread, nullptr, runThread, this);
+}
+
+void TrafficController::stopController() {
+    running = false;
+    intersection->interruptWait();
+    pthread_join(controllerThread, nullptr);
+}
+
+bool TrafficController::sendMessage(int fd, const ControllerMessage &msg) {
+    const char* data = reinterpret_cast<const char*>(&msg);
+    size_t left = sizeof(msg);
+    while (left > 0) {
+        ssize_t written = write(fd, data, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool TrafficController::receiveMessage(int fd, ControllerMessage &msg) {
+    char* data = reinterpret_cast<char*>(&msg);
+    size_t left = sizeof(msg);
+    while (left > 0) {
+        ssize_t readBytes = read(fd, data, left);
+        if (readBytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (readBytes == 0) {
+            return false; // EOF, possibly mid-message
+        }
+        data += readBytes;
+        left -= static_cast<size_t>(readBytes);
+    }
+    return true;
+}
@@ -5,11 +5,32 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <string>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <mutex>
 
 using namespace std;
 
 class Intersection;
 class Vehicle;
+class PhasePolicy;
+class PhasePlan;
+struct LaneSnapshot;
+struct LaneTicket;
+enum class Direction : uint8_t;
+
+// What a ControllerMessage is for. NOTIFY is zero, so a zeroed message is a
+// plain notification.
+enum class MessageKind : uint8_t {
+    NOTIFY,     // a vehicle is coming, e.g. an emergency on its way
+    HANDOFF,    // a vehicle crossed the sender and is on the road to the receiver
+    LINK_EXIT,  // a handed-off vehicle left the road (crossed the receiver)
+    DONE,       // the sender will hand off no more vehicles
+    PREEMPT     // an emergency is due on `approach` of the receiver `eta` seconds after sending
+};
 
 // Simple POD struct used for inter-controller IPC over pipes and
 // to visualize lanes and traffic lights.
@@ -20,46 +41,187 @@ struct ControllerMessage {
     char type[16];        // e.g., "car", "ambulance"
     char origin[8];       // intersection id, e.g., "F10"
     char destination[8];  // intersection id, e.g., "F11"
-    char approach[8];     // lane direction at origin intersection: "N", "S", "E", "W" 
+    char approach[8];     // lane direction at origin intersection: "N", "S", "E", "W"
+                          // (PREEMPT: at the receiver)
     char movement[16];    // intended movement: "STRAIGHT", "LEFT", "RIGHT"
+    uint64_t sentAtNs;    // CLOCK_MONOTONIC when sent, for hop latency; set by ControllerChannel
+    int32_t  originNode;      // RoadNetwork node ids, for routing in network runs
+    int32_t  destinationNode;
+    int32_t  hops;            // links traversed so far
+    int32_t  eta;             // PREEMPT: seconds from sentAtNs until the vehicle is due
+    MessageKind kind;
 };
 
 class TrafficLight {
-    string direction;
+    Direction direction;
     bool green;
 
 public:
-    explicit TrafficLight(const string &dir);
+    explicit TrafficLight(Direction dir);
 
     void setGreen(bool status);
     void setRed(bool status);
     bool isGreen() const;
 
-    string getDirection() const;
+    Direction getDirection() const;
 };
 
 class TrafficController {
     Intersection* intersection;
-    TrafficLight northLight;
-    TrafficLight southLight;
-    TrafficLight eastLight;
-    TrafficLight westLight;
-    int greenDuration;
-    bool running;
+    TrafficLight lights[4]; // indexed like Direction
+    unique_ptr<PhasePolicy> policy;
+    unique_ptr<PhasePlan> plan;
+    atomic<bool> running;
+    double timeScale;                 // wall seconds per controller second
+    long nowMs;                       // controller time, for wait metrics
+    unsigned long emergenciesSeen;    // Intersection::emergencyArrivalCount() at the last step
+
+    // Signal plan position, advanced by step().
+    int cycle;
+    bool cycleOpen;       // a cycle has started and not yet ended
+    int phaseIndex;       // plan index of the current green
+    bool phaseOpen;       // a green phase is waiting for its RED transition
+    int phaseElapsed;     // seconds into the current green
+    int phaseServed;      // vehicles released in the current green
+    int crossedCount;
+    int heldCount;        // releases the departure check refused
+
+    function<void(Vehicle*)> onCrossing;
+    function<bool(const Vehicle*)> mayDepart;
+
+    // A green scheduled for an emergency vehicle on its way here.
+    struct Preemption {
+        int vehicleId;
+        Direction approach;
+        long dueMs;       // controller time it is expected at the stop line
+    };
+    mutex preemptMtx;
+    vector<Preemption> requested;    // from requestPreemption, under preemptMtx
+    atomic<bool> preemptRequested;   // requested is not empty
+    vector<Preemption> preemptions;  // taken by step(); controller thread only
+    int preemptionCount;             // greens opened for expected emergencies
 
     pthread_t controllerThread;
 
+    // Turn the current green RED.
+    void closePhase();
+
+    // Turn plan phase `index` GREEN.
+    void openPhase(int index, bool blankLine);
+
+    // Take new preemption requests and drop those that timed out.
+    void takePreemptions();
+
+    // The earliest-due preemption whose pre-clear has begun, or nullptr.
+    const Preemption* activePreemption() const;
+
+    // Hold green on the preempted approach and release every head the
+    // phase serves. Returns the seconds it takes, or 0 if no phase has the
+    // approach green.
+    int servePreemption(const LaneSnapshot &snap, const Preemption &p);
+
+    // Ask the policy for the next step of the open green and carry it out.
+    // Returns the seconds it takes, or 0 if the policy ended the green.
+    int continueGreen(const LaneSnapshot &snap);
+
+    // Ask the departure check about a lane head; counts a refusal.
+    bool canDepart(const Vehicle* v, Direction lane);
+
+    // The decision part of step(), on a snapshot it has taken.
+    int decide(const LaneSnapshot &snap);
+
 public:
-    explicit TrafficController(Intersection* inter, int greenTime = 5);
+    // Seconds a vehicle occupies the intersection while crossing.
+    static const int CROSSING_TIME = 2;
 
-    // Check all approaches for an emergency vehicle, preferring the earliest one.
+    // An expected emergency's approach turns green this many seconds before
+    // it is due, and stays green for it until at most PREEMPT_TIMEOUT
+    // seconds after.
+    static const int PRECLEAR_TIME = 20;
+    static const int PREEMPT_TIMEOUT = 60;
+
+    // Starts with a FixedTimePolicy of greenTime seconds over the
+    // single-direction PhasePlan.
+    explicit TrafficController(Intersection* inter, int greenTime = 5);
+    ~TrafficController();
+
+    // Replace the signal timing plan; takes effect at the next phase.
+    void setPolicy(unique_ptr<PhasePolicy> p);
+    const char* policyName() const;
+
+    // Replace the set of phases; takes effect at the next phase.
+    void setPhasePlan(const PhasePlan &p);
+    const PhasePlan& phasePlan() const;
+
+    // Called for every vehicle released, e.g. to record its wait. It runs
+    // inside the release, before the vehicle is marked crossed: the callback
+    // must not free the vehicle, nor hand it to another thread that may,
+    // since the controller still writes it after the callback returns. An
+    // owner on another thread frees it once hasCrossed() is true.
+    void setCrossingCallback(function<void(Vehicle*)> func);
+
+    // Asked before each release. A vehicle it refuses (its road onward is
+    // full) stays at the head of its lane and blocks it until a later step
+    // lets it go, so a full link spills back into this intersection.
+    void setDepartureCheck(function<bool(const Vehicle*)> check);
+
+    // Expect emergency vehicle `vehicleId` on `approach` at controller time
+    // `dueMs`. From PRECLEAR_TIME before then the approach has green, so the
+    // queue ahead of the vehicle drains (and with it the road feeding the
+    // approach), and keeps it until the vehicle has crossed. Expected
+    // emergencies are served by due time; a new request for the same
+    // vehicle replaces the old one. Thread-safe; taken at the next step().
+    void requestPreemption(int vehicleId, Direction approach, long dueMs);
+
+    // Real-time runs wait `scale` wall seconds per controller second
+    // (1.0, the default, is real time). Set before startController().
+    void setTimeScale(double scale);
+
+    // Controller time in milliseconds since the run started, against which
+    // arrival times are measured for the wait metrics. EventSimulator sets
+    // it before each step; the real-time loop keeps it from the wall clock.
+    void setNowMs(long ms) { nowMs = ms; }
+
+    // The earliest-arriving emergency vehicle queued on any approach.
     Vehicle* checkEmergency() const;
 
-    // Allow a single vehicle to cross and remove it from its lane.
+    // Let a queued vehicle cross: remove it from its lane in one locked
+    // step without waiting for the crossing time to pass. Returns false
+    // (and logs a warning) if it is not queued there.
+    bool releaseVehicle(const LaneTicket &ticket);
+
+    // Same for a vehicle queued on its own approach.
+    bool releaseVehicle(Vehicle* v);
+
+    // Allow a single vehicle to cross and remove it from its lane, then
+    // wait CROSSING_TIME seconds.
     void crossVehicle(Vehicle* v);
 
-    // Main controller loop: always serve emergencies first, then
-    // cycle through the four directions.
+    // Make one controller decision and return how many seconds it holds
+    // the intersection (at least one). A queued emergency vehicle preempts
+    // everything: the open green goes red and the emergency crosses (unless
+    // the departure check holds it, when the step carries on as usual).
+    // Next comes the green for an expected emergency (requestPreemption).
+    // Otherwise, during a green the policy releases every lane head the
+    // phase serves at once, holds or ends the phase; between phases the
+    // policy picks the next green. Does not sleep, so both the real-time
+    // loop and EventSimulator drive the same signal plan.
+    int step();
+
+    // Number of vehicles released so far.
+    int getCrossedCount() const { return crossedCount; }
+
+    // Number of releases the departure check held back.
+    int getHeldCount() const { return heldCount; }
+
+    // Number of greens opened for expected emergencies.
+    int getPreemptionCount() const { return preemptionCount; }
+
+    // Plan index of the open green, or -1 between phases.
+    int currentPhase() const { return phaseOpen ? phaseIndex : -1; }
+
+    // Main controller loop: wait out each step() until stopped. An
+    // emergency arrival cuts the wait short so it is served at once.
     void runController();
 
     static void* runThread(void* arg);
@@ -67,7 +229,10 @@ public:
     void startController();
     void stopController();
 
-    // IPC helpers for use by controller processes.
+    // Unframed single-message IPC helpers for use by controller processes.
+    // Both block until the whole message is transferred, resuming after
+    // partial transfers and EINTR. receiveMessage returns false on EOF.
+    // ControllerChannel is the batched, non-blocking alternative.
     static bool sendMessage(int fd, const ControllerMessage &msg);
     static bool receiveMessage(int fd, ControllerMessage &msg);
 };
@@ -1,70 +1,132 @@
 #include "Vehicle.h"
 #include "ParkingLot.h"
+#include "Intersection.h"
+#include "Log.h"
+#include "VehicleStore.h"
 
-Vehicle::Vehicle(int id, const string &type, const string &origin, 
-                 const string &destination, int priority, int arr_time)
+VehicleType vehicleTypeOf(const string &name)
 {
+    if(name == "car") return VehicleType::CAR;
+    if(name == "bike") return VehicleType::BIKE;
+    if(name == "bus") return VehicleType::BUS;
+    if(name == "tractor") return VehicleType::TRACTOR;
+    if(name == "ambulance") return VehicleType::AMBULANCE;
+    if(name == "firetruck") return VehicleType::FIRETRUCK;
+    return VehicleType::OTHER;
+}
+
+Vehicle::Vehicle(uint32_t index, int id, const string &type, const string &origin, 
+                 const string &destination, int arr_time)
+{
+    this->index = index;
     this->id = id;
-    this->type = type;
-    this->origin = origin;
-    this->destination = destination;
     this->arrival_time = arr_time;
+    this->typeName = NameTable::intern(type);
+    this->originName = NameTable::intern(origin);
+    this->destinationName = NameTable::intern(destination);
+    this->kind = vehicleTypeOf(type);
     this->parking_reserved = false;
+    this->done = 0;
+    this->approach = Direction::NORTH;
+    this->movement = Movement::STRAIGHT;
+    this->reservedLot = nullptr;
+    this->hooks = nullptr;
+    this->arrivalLink = nullptr;
+
+    emergency = (kind == VehicleType::AMBULANCE || kind == VehicleType::FIRETRUCK);
 
-    if(type == "ambulance" || type == "firetruck")
+    if(emergency)
         this->priority = 1;
-    else if(type == "bus")
+    else if(kind == VehicleType::BUS)
         this->priority = 2;
     else
         this->priority = 3;
 
-    if(type == "car" || type == "bus" || type == "tractor" || type == "bike")
-        can_park = true;
-    else
-        can_park = false;
+    can_park = (kind == VehicleType::CAR || kind == VehicleType::BUS ||
+                kind == VehicleType::TRACTOR || kind == VehicleType::BIKE);
 }
 
-int Vehicle::getId() const { return id; }
-string Vehicle::getType() const { return type; }
-string Vehicle::getOrigin() const { return origin; }
-string Vehicle::getDestination() const { return destination; }
-int Vehicle::getPriority() const { return priority; }
-int Vehicle::getArrivalTime() const { return arrival_time; }
-bool Vehicle::canPark() const { return can_park; }
-bool Vehicle::isEmergency() const { return (type == "ambulance" || type == "firetruck"); }
+const string& Vehicle::getType() const { return NameTable::name(typeName); }
+const string& Vehicle::getOrigin() const { return NameTable::name(originName); }
+const string& Vehicle::getDestination() const { return NameTable::name(destinationName); }
+Direction Vehicle::getApproach() const { return approach; }
+void Vehicle::setApproach(Direction d) { approach = d; }
+Movement Vehicle::getMovement() const { return movement; }
+void Vehicle::setMovement(Movement m) { movement = m; }
+void Vehicle::markCrossed() { done.fetch_or(DONE_CROSSING, memory_order_release); }
+bool Vehicle::hasCrossed() const { return (done.load(memory_order_acquire) & DONE_CROSSING) != 0; }
+void Vehicle::finishArrival() { done.fetch_or(DONE_ARRIVAL, memory_order_release); }
+bool Vehicle::isFinished() const
+{
+    return done.load(memory_order_acquire) == (DONE_CROSSING | DONE_ARRIVAL);
+}
 
-void Vehicle::setRequestIntersectionAccessFunction(function<void(Vehicle*)> func)
+void Vehicle::setHooks(const VehicleHooks* h)
 {
-    this->requestIntersectionAccess = func;
+    this->hooks = h;
 }
 
 bool Vehicle::parkingVehicle(ParkingLot &lot)
 {
-    if(!can_park || isEmergency()) return false;
+    if(!can_park || emergency) return false;
 
     bool ok = lot.tryReserveWaitingSlot(this);
-    if(ok) parking_reserved = true;
+    if(ok)
+    {
+        parking_reserved = true;
+        reservedLot = &lot;
+    }
     return ok;
 }
 
 void Vehicle::occupyReservedParking(ParkingLot &lot)
 {
-    if(!parking_reserved) return;
-
-    if(lot.aquireParkingSpot(this))
+    if(beginParking(lot))
     {
-        cout << "[Vehicle] " << origin << " -> Vehicle " << id
-             << " (" << type << ") has parked at parking lot "
-             << lot.getParkingLotID() << endl;
-
-        sleep(5);
-        lot.leaveParking(this);
+        sleep(PARKING_DURATION);
+        endParking(*reservedLot);
     }
-    else
+}
+
+bool Vehicle::takeSpot(ParkingLot &lot)
+{
+    if(lot.aquireParkingSpot(this))
     {
-        lot.releaseWaitingSlot(this);
+        LOG_EVENT(DEBUG, LogEvent::VEHICLE_PARKED, this, getOrigin(), lot.getParkingLotID());
+        return true;
     }
+
+    lot.releaseWaitingSlot(this);
+    parking_reserved = false;
+    reservedLot = nullptr;
+    return false;
+}
+
+bool Vehicle::beginParking(ParkingLot &lot)
+{
+    if(!parking_reserved) return false;
+    if(takeSpot(lot)) return true;
+
+    // Every spot taken: try the nearest lot that has one, but only once
+    ParkingLot* other = (hooks && hooks->parkingFallback) ? hooks->parkingFallback(this) : nullptr;
+    return other && takeSpot(*other);
+}
+
+void Vehicle::endParking(ParkingLot &lot)
+{
+    lot.leaveParking(this);
     parking_reserved = false;
+    reservedLot = nullptr;
+}
+
+bool Vehicle::hasParkingReservation() const
+{
+    return parking_reserved;
+}
+
+ParkingLot* Vehicle::getReservedLot() const
+{
+    return parking_reserved ? reservedLot : nullptr;
 }
 
 void Vehicle::cancelParkingReservation(ParkingLot &lot)
@@ -73,41 +135,55 @@ void Vehicle::cancelParkingReservation(ParkingLot &lot)
     {
         lot.releaseWaitingSlot(this);
         parking_reserved = false;
+        reservedLot = nullptr;
     }
 }
 
 void Vehicle::crossingIntersection()
 {
-    cout << "[Vehicle] " << origin << " -> Vehicle " << id
-         << " (" << type << ") is crossing intersection "
-         << destination << "." << endl;
-    cout << "[Vehicle] Vehicle " << id << " (" << type
-         << ") has crossed intersection " << destination << "." << endl;
+    LOG_EVENT(INFO, LogEvent::VEHICLE_CROSSED, this, getOrigin(), getDestination());
+    markCrossed();
 }
 
-void Vehicle::runVehicle(ParkingLot &F10, ParkingLot &F11)
+ParkingLot* Vehicle::originLot(ParkingLot &F10, ParkingLot &F11) const
 {
-    sleep(arrival_time);
+    const string &origin = getOrigin();
+    if(origin == "F10") return &F10;
+    if(origin == "F11") return &F11;
+    return nullptr;
+}
+
+void Vehicle::arrive(ParkingLot &F10, ParkingLot &F11)
+{
+    arriveAt(originLot(F10, F11));
+}
 
-    cout << "[Vehicle] " << origin << " -> Vehicle " << id
-         << " (" << type << ") has arrived at its intersection." << endl;
+void Vehicle::arriveAt(ParkingLot* lot)
+{
+    LOG_EVENT(DEBUG, LogEvent::VEHICLE_ARRIVED, this, getOrigin());
 
-    // Try parking
-    if(origin == "F10") parkingVehicle(F10);
-    else if(origin == "F11") parkingVehicle(F11);
+    // Try parking, then another lot if the origin's waiting area is full
+    if(lot && !parkingVehicle(*lot) && hooks && hooks->parkingFallback && can_park && !emergency)
+        hooks->parkingFallback(this);
 
     // Request intersection
-    if(requestIntersectionAccess) 
-        requestIntersectionAccess(this);
+    if(hooks && hooks->requestIntersectionAccess) 
+        hooks->requestIntersectionAccess(this);
     else 
         crossingIntersection();
+}
+
+void Vehicle::runVehicle(ParkingLot &F10, ParkingLot &F11)
+{
+    sleep(arrival_time);
+
+    arrive(F10, F11);
 
     // If parking was reserved, actually park
     if(parking_reserved)
-    {
-        if(origin == "F10") occupyReservedParking(F10);
-        else if(origin == "F11") occupyReservedParking(F11);
-    }
+        occupyReservedParking(*reservedLot);
+
+    finishArrival();
 }
 
 void* Vehicle::threadStart(void* arg)
@@ -118,11 +194,11 @@ void* Vehicle::threadStart(void* arg)
     return nullptr;
 }
 
-bool Vehicle::start(ParkingLot &F10, ParkingLot &F11)
+bool Vehicle::start(ParkingLot &F10, ParkingLot &F11, pthread_t &tid)
 {
     ThreadArg* ta = new ThreadArg{this, &F10, &F11};
 
-    int rc = pthread_create(&thread_id, nullptr, threadStart, ta);
+    int rc = pthread_create(&tid, nullptr, threadStart, ta);
     if(rc != 0)
     {
         cout << "pthread_create failed for vehicle " << id << endl;
@@ -131,7 +207,3 @@ bool Vehicle::start(ParkingLot &F10, ParkingLot &F11)
     }
     return true;
 }
-
-void Vehicle::wait(){
-    pthread_join(thread_id, nullptr);
-}
@@ -4,55 +4,166 @@
 #include <iostream>
 #include <pthread.h>
 #include <semaphore.h>
-#include <mutex>
 #include <functional>
 #include <unistd.h>
+#include <cstdint>
+#include <atomic>
 using namespace std;
 
 class ParkingLot;
+class Vehicle;
+enum class Direction : uint8_t;
+enum class Movement : uint8_t;
 
+// Vehicle types with their own rules; anything else is OTHER (priority 3,
+// cannot park) and keeps its name for logs.
+enum class VehicleType : uint8_t { CAR, BIKE, BUS, TRACTOR, AMBULANCE, FIRETRUCK, OTHER };
+
+VehicleType vehicleTypeOf(const string &name);
+
+// Reference to a vehicle that notices when the vehicle is gone; resolve it
+// with VehicleStore::get.
+struct VehicleHandle {
+    static const uint32_t NO_INDEX = 0xffffffffu;
+
+    uint32_t index;
+    uint32_t generation;
+
+    static VehicleHandle null() { return VehicleHandle{NO_INDEX, 0}; }
+    bool isNull() const { return index == NO_INDEX; }
+};
+
+// Callbacks shared by every vehicle of an intersection or node, so a
+// vehicle carries one pointer rather than its own closures.
+struct VehicleHooks {
+    // Queue the vehicle at its intersection. Without it the vehicle
+    // crosses on arrival.
+    function<void(Vehicle*)> requestIntersectionAccess;
+
+    // Called when the origin lot cannot take the vehicle (waiting area
+    // full, or no spot free once it gets there); reserves at another lot
+    // and returns it, or nullptr.
+    function<ParkingLot*(Vehicle*)> parkingFallback;
+};
+
+// One trip, sized for millions of queued vehicles: names are interned ids,
+// type-derived rules are worked out once at construction, and the vehicle
+// lives in a VehicleStore slot addressed by a 32-bit index. Create and
+// destroy vehicles through VehicleStore.
 class Vehicle
 {
-    int id; 
-    string type; 
-    string origin; 
-    string destination; 
-    int priority; 
-    int arrival_time; 
+    uint32_t index;          // slot in VehicleStore
+    int id;
+    int arrival_time;
+    uint32_t typeName;       // NameTable ids
+    uint32_t originName;
+    uint32_t destinationName;
+
+    VehicleType kind;
+    uint8_t priority;
     bool can_park;
-    
+    bool emergency;
     bool parking_reserved;
-    mutex mtx;
-    pthread_t thread_id;
+    // DONE_* bits, each set last by the controller and by whatever runs
+    // the arrival stage, so a vehicle showing both is no longer touched
+    // by either thread.
+    atomic<uint8_t> done;
+    static const uint8_t DONE_CROSSING = 1, DONE_ARRIVAL = 2;
+    Direction approach; // lane it queues in at its origin
+    Movement movement;  // straight on, left or right at its origin
 
-    function<void(Vehicle*)> requestIntersectionAccess;
+    ParkingLot* reservedLot; // lot holding this vehicle's waiting slot or spot
+    const VehicleHooks* hooks;
+
+    // Intrusive link for ArrivalQueue while the vehicle waits to be
+    // drained into a lane.
+    Vehicle* arrivalLink;
+    friend class ArrivalQueue;
+
+    // Move from the waiting slot at `lot` to a spot, or give the slot up.
+    bool takeSpot(ParkingLot &lot);
+
+    friend class VehicleStore;
+    Vehicle(uint32_t index, int id, const string &type, const string &origin,
+            const string &destination, int arr_time);
+    ~Vehicle() = default;
     
 public:
 
-    Vehicle(int id, const string &type, const string &origin, 
-            const string &destination, int priority, int arr_time);
-
     Vehicle(const Vehicle&) = delete;
     Vehicle& operator=(const Vehicle&) = delete;
 
     //Getters
-    int getId() const;
-    string getType() const;
-    string getOrigin() const;
-    string getDestination() const;
-    int getPriority() const;
-    int getArrivalTime() const;
-    bool canPark() const;
-    bool isEmergency() const;
+    uint32_t getIndex() const { return index; }
+    int getId() const { return id; }
+    const string& getType() const;
+    VehicleType getVehicleType() const { return kind; }
+    const string& getOrigin() const;
+    const string& getDestination() const;
+    uint32_t getTypeId() const { return typeName; }
+    uint32_t getOriginId() const { return originName; }
+    uint32_t getDestinationId() const { return destinationName; }
+    int getPriority() const { return priority; }
+    int getArrivalTime() const { return arrival_time; }
+    bool canPark() const { return can_park; }
+    bool isEmergency() const { return emergency; }
+    Direction getApproach() const;
+    void setApproach(Direction d);
+    Movement getMovement() const;
+    void setMovement(Movement m);
+
+    // Set once the vehicle has crossed its intersection; the controller
+    // calls it after its last use of the vehicle.
+    void markCrossed();
+    bool hasCrossed() const;
+
+    // Called by the executor, thread or simulator running the arrival
+    // stage once it is over (any parking stay included), as its last use
+    // of the vehicle.
+    void finishArrival();
+
+    // Crossed and done arriving and parking, so nothing refers to the
+    // vehicle any more and another thread may destroy it.
+    bool isFinished() const;
+
+    // Hooks are not owned and must outlive the vehicle's trip.
+    void setHooks(const VehicleHooks* h);
 
-    void setRequestIntersectionAccessFunction(function<void(Vehicle*)> func);
+    // How long a parked vehicle stays in its spot, in seconds.
+    static const int PARKING_DURATION = 5;
 
     bool parkingVehicle(ParkingLot &lot);
     void occupyReservedParking(ParkingLot &lot);
     void cancelParkingReservation(ParkingLot &lot);
 
+    // Non-blocking halves of occupyReservedParking, for executors that
+    // schedule the parking stay instead of sleeping through it.
+    // beginParking returns true if the vehicle is now parked and must
+    // call endParking after PARKING_DURATION; with no spot free it tries
+    // the parking fallback once, so the vehicle may end up parked at
+    // getReservedLot() rather than `lot`.
+    bool beginParking(ParkingLot &lot);
+    void endParking(ParkingLot &lot);
+
+    bool hasParkingReservation() const;
+
+    // Lot the reservation is held at: the origin lot, or the one the
+    // parking fallback redirected to. nullptr without a reservation.
+    ParkingLot* getReservedLot() const;
+
     void crossingIntersection();
 
+    // Lot at this vehicle's origin intersection, or nullptr if none.
+    ParkingLot* originLot(ParkingLot &F10, ParkingLot &F11) const;
+
+    // Arrival stage of a trip: try to reserve parking at the origin lot,
+    // then request intersection access.
+    void arrive(ParkingLot &F10, ParkingLot &F11);
+
+    // Same, when the caller already knows the origin's lot (nullptr if the
+    // intersection has none).
+    void arriveAt(ParkingLot* lot);
+
     void runVehicle(ParkingLot &F10 , ParkingLot &F11);
 
     struct ThreadArg {
@@ -63,8 +174,8 @@ public:
 
     static void* threadStart(void* arg);
 
-    bool start(ParkingLot &F10, ParkingLot &F11);
-    void wait();
+    // Run the trip on its own thread; join `tid` to wait for it.
+    bool start(ParkingLot &F10, ParkingLot &F11, pthread_t &tid);
 };
 
 #endif
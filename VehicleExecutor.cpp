@@ -0,0 +1,235 @@
+#include "VehicleExecutor.h"
+#include "Vehicle.h"
+#include "ParkingLot.h"
+
+#include <time.h>
+#include <unistd.h>
+
+TimerWheel::TimerWheel() : tick(0) {
+    for (int i = 0; i < SLOTS; ++i) {
+        slots[i] = nullptr;
+    }
+}
+
+void TimerWheel::schedule(Entry* e, unsigned long ticks) {
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    unsigned long due = tick + ticks;
+    // The slot is visited once per turn; rounds counts the visits to skip.
+    e->rounds = (ticks - 1) / SLOTS;
+    Entry* &slot = slots[due % SLOTS];
+    e->next = slot;
+    slot = e;
+}
+
+TimerWheel::Entry* TimerWheel::advance() {
+    ++tick;
+    Entry* &slot = slots[tick % SLOTS];
+
+    Entry* expired = nullptr;
+    Entry* keep = nullptr;
+    Entry* e = slot;
+    while (e) {
+        Entry* next = e->next;
+        if (e->rounds == 0) {
+            e->next = expired;
+            expired = e;
+        } else {
+            --e->rounds;
+            e->next = keep;
+            keep = e;
+        }
+        e = next;
+    }
+    slot = keep;
+    return expired;
+}
+
+VehicleExecutor::VehicleExecutor(int workerCount)
+    : freeTasks(nullptr),
+      readyHead(nullptr),
+      readyTail(nullptr),
+      remaining(0),
+      running(false),
+      requestedWorkers(workerCount) {
+    if (requestedWorkers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        requestedWorkers = cpus > 0 ? static_cast<int>(cpus) : 1;
+    }
+}
+
+VehicleExecutor::~VehicleExecutor() {
+    stop();
+}
+
+void VehicleExecutor::submit(Vehicle* v, ParkingLot &F10, ParkingLot &F11) {
+    lock_guard<mutex> lock(mtx);
+    VehicleTask* t = freeTasks;
+    if (t) {
+        freeTasks = t->nextReady;
+    } else {
+        tasks.emplace_back();
+        t = &tasks.back();
+    }
+    *t = VehicleTask{TimerWheel::Entry(), v, &F10, &F11, TaskState::ARRIVING, nullptr};
+    ++remaining;
+    if (running) {
+        scheduleArrival(t);
+    }
+}
+
+void VehicleExecutor::scheduleAfterMs(VehicleTask* t, long ms) {
+    // Caller holds mtx.
+    wheel.schedule(&t->timer, (ms + TICK_MS - 1) / TICK_MS);
+}
+
+void VehicleExecutor::scheduleArrival(VehicleTask* t) {
+    // Caller holds mtx. Arrivals are relative to start(), i.e. tick 0.
+    unsigned long due = (t->vehicle->getArrivalTime() * 1000UL + TICK_MS - 1) / TICK_MS;
+    unsigned long now = wheel.currentTick();
+    wheel.schedule(&t->timer, due > now ? due - now : 1);
+}
+
+void VehicleExecutor::start() {
+    {
+        lock_guard<mutex> lock(mtx);
+        running = true;
+        for (VehicleTask &t : tasks) {
+            if (t.state == TaskState::ARRIVING) {
+                scheduleArrival(&t);
+            }
+        }
+    }
+
+    pthread_create(&timerThread, nullptr, timerThreadStart, this);
+    for (int i = 0; i < requestedWorkers; ++i) {
+        pthread_t tid;
+        if (pthread_create(&tid, nullptr, workerThreadStart, this) != 0) {
+            cout << "[VehicleExecutor] pthread_create failed for worker " << i << endl;
+            continue;
+        }
+        workers.push_back(tid);
+    }
+}
+
+void VehicleExecutor::waitAll() {
+    unique_lock<mutex> lock(mtx);
+    doneCv.wait(lock, [this] { return remaining == 0; });
+}
+
+void VehicleExecutor::stop() {
+    {
+        lock_guard<mutex> lock(mtx);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    readyCv.notify_all();
+
+    pthread_join(timerThread, nullptr);
+    for (pthread_t tid : workers) {
+        pthread_join(tid, nullptr);
+    }
+    workers.clear();
+}
+
+void VehicleExecutor::runTask(VehicleTask* t) {
+    Vehicle* v = t->vehicle;
+
+    switch (t->state) {
+    case TaskState::ARRIVING: {
+        v->arrive(*t->f10, *t->f11);
+        ParkingLot* lot = v->getReservedLot();
+        if (lot && v->beginParking(*lot)) {
+            t->state = TaskState::PARKED;
+            lock_guard<mutex> lock(mtx);
+            scheduleAfterMs(t, Vehicle::PARKING_DURATION * 1000L);
+            return;
+        }
+        break;
+    }
+
+    case TaskState::PARKED:
+        v->endParking(*v->getReservedLot());
+        break;
+
+    case TaskState::DONE:
+        return;
+    }
+
+    v->finishArrival(); // last use: the vehicle may be freed from here on
+    lock_guard<mutex> lock(mtx);
+    t->state = TaskState::DONE;
+    t->nextReady = freeTasks;
+    freeTasks = t;
+    if (--remaining == 0) {
+        doneCv.notify_all();
+    }
+}
+
+void VehicleExecutor::timerLoop() {
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (true) {
+        next.tv_nsec += TICK_MS * 1000000L;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            ++next.tv_sec;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+
+        lock_guard<mutex> lock(mtx);
+        if (!running) {
+            return;
+        }
+
+        TimerWheel::Entry* e = wheel.advance();
+        bool any = (e != nullptr);
+        while (e) {
+            VehicleTask* t = reinterpret_cast<VehicleTask*>(e);
+            e = e->next;
+            t->nextReady = nullptr;
+            if (readyTail) {
+                readyTail->nextReady = t;
+            } else {
+                readyHead = t;
+            }
+            readyTail = t;
+        }
+        if (any) {
+            readyCv.notify_all();
+        }
+    }
+}
+
+void VehicleExecutor::workerLoop() {
+    while (true) {
+        VehicleTask* t;
+        {
+            unique_lock<mutex> lock(mtx);
+            readyCv.wait(lock, [this] { return readyHead != nullptr || !running; });
+            if (!running) {
+                return;
+            }
+            t = readyHead;
+            readyHead = t->nextReady;
+            if (!readyHead) {
+                readyTail = nullptr;
+            }
+        }
+        runTask(t);
+    }
+}
+
+void* VehicleExecutor::timerThreadStart(void* arg) {
+    static_cast<VehicleExecutor*>(arg)->timerLoop();
+    return nullptr;
+}
+
+void* VehicleExecutor::workerThreadStart(void* arg) {
+    static_cast<VehicleExecutor*>(arg)->workerLoop();
+    return nullptr;
+}
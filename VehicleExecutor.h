@@ -0,0 +1,121 @@
+#ifndef VEHICLE_EXECUTOR_H
+#define VEHICLE_EXECUTOR_H
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <pthread.h>
+
+using namespace std;
+
+class Vehicle;
+class ParkingLot;
+
+// How a controller process runs its vehicles.
+enum class VehicleExecutionMode {
+    THREAD_PER_VEHICLE, // legacy: one pthread per vehicle, sleeping in place
+    WORKER_POOL         // VehicleExecutor: fixed pool plus timer wheel
+};
+
+// Hashed timer wheel. Entries are intrusive so scheduling never allocates.
+// Not thread-safe on its own; VehicleExecutor guards it with its mutex.
+class TimerWheel {
+public:
+    struct Entry {
+        Entry* next = nullptr;
+        unsigned long rounds = 0; // full wheel turns left before firing
+    };
+
+    static const int SLOTS = 512;
+
+    TimerWheel();
+
+    // Fire `e` after `ticks` ticks (at least one).
+    void schedule(Entry* e, unsigned long ticks);
+
+    // Advance one tick, returning the expired entries as a linked list.
+    Entry* advance();
+
+    unsigned long currentTick() const { return tick; }
+
+private:
+    Entry* slots[SLOTS];
+    unsigned long tick;
+};
+
+// Drives vehicles as small state machines on a fixed set of worker threads.
+// A vehicle's trip is arrive -> reserve parking -> request intersection ->
+// park for Vehicle::PARKING_DURATION -> leave, and the waits between stages
+// are timer wheel entries rather than sleeping threads.
+class VehicleExecutor {
+public:
+    static const int TICK_MS = 10;
+
+    // workers <= 0 means one worker per online CPU.
+    explicit VehicleExecutor(int workers = 0);
+    ~VehicleExecutor();
+
+    VehicleExecutor(const VehicleExecutor&) = delete;
+    VehicleExecutor& operator=(const VehicleExecutor&) = delete;
+
+    // Queue a vehicle whose arrival is v->getArrivalTime() seconds after
+    // start(). May be called before or after start(), so vehicles can be
+    // fed in as they become due; one whose arrival has passed runs on the
+    // next tick. Finished tasks are reused, so a steady stream of submits
+    // stops allocating once the pool covers the vehicles in flight.
+    void submit(Vehicle* v, ParkingLot &F10, ParkingLot &F11);
+
+    void start();
+
+    // Block until every submitted vehicle has finished its trip. Call after
+    // the last submit().
+    void waitAll();
+
+    // Stop the timer and worker threads. Called by the destructor.
+    void stop();
+
+    int workerCount() const { return static_cast<int>(workers.size()); }
+
+private:
+    enum class TaskState { ARRIVING, PARKED, DONE };
+
+    // Entry must stay the first member so a fired timer entry can be cast
+    // back to its task.
+    struct VehicleTask {
+        TimerWheel::Entry timer;
+        Vehicle* vehicle;
+        ParkingLot* f10;
+        ParkingLot* f11;
+        TaskState state;
+        VehicleTask* nextReady;
+    };
+
+    void scheduleAfterMs(VehicleTask* t, long ms);
+    void scheduleArrival(VehicleTask* t);
+    void runTask(VehicleTask* t);
+
+    void timerLoop();
+    void workerLoop();
+    static void* timerThreadStart(void* arg);
+    static void* workerThreadStart(void* arg);
+
+    deque<VehicleTask> tasks; // deque keeps task addresses stable
+    VehicleTask* freeTasks;   // finished tasks, linked through nextReady
+    TimerWheel wheel;
+
+    mutex mtx;
+    condition_variable readyCv;
+    condition_variable doneCv;
+    VehicleTask* readyHead;
+    VehicleTask* readyTail;
+    size_t remaining;
+    bool running;
+
+    pthread_t timerThread;
+    vector<pthread_t> workers;
+    int requestedWorkers;
+};
+
+#endif
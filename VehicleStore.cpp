@@ -0,0 +1,94 @@
+#include "VehicleStore.h"
+
+#include <new>
+#include <unordered_map>
+
+string* NameTable::chunks[NameTable::MAX_CHUNKS];
+
+namespace {
+mutex nameMtx;
+unordered_map<string, uint32_t> nameIds;
+}
+
+uint32_t NameTable::intern(const string &name) {
+    lock_guard<mutex> lock(nameMtx);
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(nameIds.size());
+    if ((id >> CHUNK_BITS) >= MAX_CHUNKS) {
+        cout << "[NameTable] Out of name ids; storing '" << name << "' as id 0" << endl;
+        return 0;
+    }
+    string* &chunk = chunks[id >> CHUNK_BITS];
+    if (!chunk) {
+        chunk = new string[CHUNK_SIZE];
+    }
+    chunk[id & (CHUNK_SIZE - 1)] = name;
+    nameIds.emplace(name, id);
+    return id;
+}
+
+unsigned char* VehicleStore::chunks[VehicleStore::MAX_CHUNKS];
+atomic<uint32_t>* VehicleStore::generations[VehicleStore::MAX_CHUNKS];
+mutex VehicleStore::mtx;
+atomic<uint32_t> VehicleStore::slots(0);
+uint32_t VehicleStore::freeHead = VehicleStore::NO_INDEX;
+uint32_t VehicleStore::liveVehicles = 0;
+
+Vehicle* VehicleStore::create(int id, const string &type, const string &origin,
+                              const string &destination, int arr_time) {
+    uint32_t index;
+    {
+        lock_guard<mutex> lock(mtx);
+        if (freeHead != NO_INDEX) {
+            index = freeHead;
+            freeHead = *reinterpret_cast<uint32_t*>(at(index));
+        } else {
+            index = slots.load(memory_order_relaxed);
+            if (index == NO_INDEX) {
+                cout << "[VehicleStore] Out of vehicle slots" << endl;
+                return nullptr;
+            }
+            uint32_t c = index >> CHUNK_BITS;
+            if (!chunks[c]) {
+                chunks[c] = static_cast<unsigned char*>(::operator new(sizeof(Vehicle) * CHUNK_SIZE));
+                generations[c] = new atomic<uint32_t>[CHUNK_SIZE]();
+            }
+            // The chunk is in place before get() can see the index.
+            slots.store(index + 1, memory_order_release);
+        }
+        ++liveVehicles;
+    }
+    return new (at(index)) Vehicle(index, id, type, origin, destination, arr_time);
+}
+
+void VehicleStore::destroy(Vehicle* v) {
+    if (!v) {
+        return;
+    }
+    uint32_t index = v->getIndex();
+    v->~Vehicle();
+    generationOf(index).fetch_add(1, memory_order_release);
+
+    // The dead slot holds the free-list link.
+    lock_guard<mutex> lock(mtx);
+    *reinterpret_cast<uint32_t*>(at(index)) = freeHead;
+    freeHead = index;
+    --liveVehicles;
+}
+
+uint32_t VehicleStore::liveCount() {
+    lock_guard<mutex> lock(mtx);
+    return liveVehicles;
+}
+
+uint32_t VehicleStore::slotCount() {
+    return slots.load(memory_order_acquire);
+}
+
+uint32_t VehicleStore::chunkCount() {
+    return (slotCount() + CHUNK_SIZE - 1) >> CHUNK_BITS;
+}
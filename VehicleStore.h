@@ -0,0 +1,96 @@
+#ifndef VEHICLE_STORE_H
+#define VEHICLE_STORE_H
+
+#include <iostream>
+#include <string>
+#include <mutex>
+#include <cstdint>
+#include <atomic>
+
+#include "Vehicle.h"
+
+using namespace std;
+
+// Interned strings for vehicle types and intersection names. A vehicle
+// stores 32-bit ids and compares them instead of strings. Ids are never
+// reused; name() takes no lock.
+class NameTable {
+public:
+    static uint32_t intern(const string &name);
+    static const string& name(uint32_t id) {
+        return chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+    }
+
+private:
+    static const int CHUNK_BITS = 10;
+    static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static const uint32_t MAX_CHUNKS = 4096;
+
+    static string* chunks[MAX_CHUNKS];
+};
+
+// Process-wide store of vehicles in fixed-size slots, so each vehicle can
+// be named by a 32-bit index (Vehicle::getIndex) and lanes can hold indices
+// instead of pointers. Slots come in large chunks that never move, so a
+// Vehicle* stays valid until destroy(); at() takes no lock.
+//
+// Freed slots go on an intrusive free list and are reused by later
+// vehicles, so once a run has reached its peak number of live vehicles,
+// create and destroy never touch the heap. Each controller is its own
+// process, which makes this the controller's vehicle pool.
+//
+// Reuse is why a slot also has a generation, bumped by destroy(): a
+// VehicleHandle taken from one vehicle resolves to nullptr once that
+// vehicle is gone, instead of to whichever vehicle got its slot next.
+class VehicleStore {
+public:
+    static const uint32_t NO_INDEX = VehicleHandle::NO_INDEX;
+
+    static Vehicle* create(int id, const string &type, const string &origin,
+                           const string &destination, int arr_time);
+    static void destroy(Vehicle* v);
+
+    static Vehicle* at(uint32_t index) {
+        return reinterpret_cast<Vehicle*>(chunks[index >> CHUNK_BITS]) + (index & (CHUNK_SIZE - 1));
+    }
+
+    static VehicleHandle handle(const Vehicle* v) {
+        uint32_t index = v->getIndex();
+        return VehicleHandle{index, generationOf(index).load(memory_order_acquire)};
+    }
+
+    // The vehicle `h` was taken from, or nullptr if it has been destroyed
+    // (or `h` is null).
+    static Vehicle* get(VehicleHandle h) {
+        if (h.index == NO_INDEX || h.index >= slots.load(memory_order_acquire) ||
+            generationOf(h.index).load(memory_order_acquire) != h.generation) {
+            return nullptr;
+        }
+        return at(h.index);
+    }
+
+    // Vehicles alive now, and slots allocated so far.
+    static uint32_t liveCount();
+    static uint32_t slotCount();
+
+    // Heap allocations made by the store itself (one per chunk of slots).
+    static uint32_t chunkCount();
+
+private:
+    static const int CHUNK_BITS = 16;
+    static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static const uint32_t MAX_CHUNKS = 1u << (32 - CHUNK_BITS);
+
+    static atomic<uint32_t>& generationOf(uint32_t index) {
+        return generations[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+    }
+
+    static unsigned char* chunks[MAX_CHUNKS];
+    static atomic<uint32_t>* generations[MAX_CHUNKS];
+    static mutex mtx;
+    static atomic<uint32_t> slots;  // slots ever handed out
+    static uint32_t freeHead;       // free list through dead slots
+    static uint32_t liveVehicles;
+};
+
+#endif
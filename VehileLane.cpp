@@ -1,74 +1,126 @@
-#include "VehileLane.h"
-
-VehicleLane::VehicleLane() : count(0) {
-    for (int i = 0; i < MAX_CAPACITY; ++i) {
-        vehicles[i] = nullptr;
-    }
-}
-
-void VehicleLane::reorder() {
-    for (int i = 0; i < count - 1; ++i) {
-        for (int j = 0; j < count - i - 1; ++j) {
-            Vehicle* v1 = vehicles[j];
-            Vehicle* v2 = vehicles[j + 1];
-
-            if (!v1 || !v2) {
-                continue;
-            }
-
-            if (v1->getPriority() > v2->getPriority() ||
-                (v1->getPriority() == v2->getPriority() &&
-                 v1->getArrivalTime() > v2->getArrivalTime())) {
-                Vehicle* temp = vehicles[j];
-                vehicles[j] = vehicles[j + 1];
-                vehicles[j + 1] = temp;
-            }
-        }
-    }
-}
-
-bool VehicleLane::push(Vehicle* v) {
-    if (count >= MAX_CAPACITY) {
-        cout << "VehicleLane is full. Cannot add more vehicles." << endl;
-        return false;
-    }
-    vehicles[count++] = v;
-    reorder();
-    return true;
-}
-
-Vehicle* VehicleLane::front() const {
-    if (count == 0) {
-        return nullptr;
-    }
-    return vehicles[0];
-}
-
-void VehicleLane::pop() {
-    if (count == 0) {
-        return;
-    }
-    for (int i = 1; i < count; ++i) {
-        vehicles[i - 1] = vehicles[i];
-    }
-    vehicles[count - 1] = nullptr;
-    --count;
-}
-
-int VehicleLane::size() const {
-    return count;
-}
-
-bool VehicleLane::empty() const {
-    return count == 0;
-}
-
-void VehicleLane::print() const {
-    cout << "Lane: \n";
-    for (int i = 0; i < count; ++i) {
-        if (vehicles[i]) {
-            cout << vehicles[i]->getType() << "(" << vehicles[i]->getPriority() << ") ";
-        }
-    }
-    cout << endl;
-}
+#include "VehileLane.h"
+#include "VehicleStore.h"
+#include <algorithm>
+
+static const int PRIORITY_SHIFT = 56;
+
+VehicleLane::VehicleLane() : nextSeq(0) {}
+
+bool VehicleLane::before(const Entry &a, const Entry &b) {
+    uint64_t pa = a.order >> PRIORITY_SHIFT, pb = b.order >> PRIORITY_SHIFT;
+    if (pa != pb) {
+        return pa < pb;
+    }
+    if (a.arrival_time != b.arrival_time) {
+        return a.arrival_time < b.arrival_time;
+    }
+    return a.order < b.order;
+}
+
+void VehicleLane::siftUp(size_t i) {
+    Entry e = heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!before(e, heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = e;
+}
+
+void VehicleLane::siftDown(size_t i) {
+    size_t n = heap.size();
+    Entry e = heap[i];
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && before(heap[child + 1], heap[child])) {
+            ++child;
+        }
+        if (!before(heap[child], e)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = e;
+}
+
+bool VehicleLane::push(Vehicle* v) {
+    if (!v) {
+        return false;
+    }
+    uint64_t order = static_cast<uint64_t>(v->getPriority()) << PRIORITY_SHIFT | nextSeq++;
+    heap.push_back(Entry{v->getArrivalTime(), v->getIndex(), order});
+    siftUp(heap.size() - 1);
+    return true;
+}
+
+Vehicle* VehicleLane::front() const {
+    if (heap.empty()) {
+        return nullptr;
+    }
+    return VehicleStore::at(heap[0].vehicle);
+}
+
+void VehicleLane::pop() {
+    if (heap.empty()) {
+        return;
+    }
+    heap[0] = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        siftDown(0);
+    }
+}
+
+bool VehicleLane::erase(Vehicle* v) {
+    if (!v) {
+        return false;
+    }
+    uint32_t index = v->getIndex();
+    size_t i = 0;
+    if (heap.empty() || heap[0].vehicle != index) {
+        while (i < heap.size() && heap[i].vehicle != index) {
+            ++i;
+        }
+        if (i == heap.size()) {
+            return false;
+        }
+    }
+    heap[i] = heap.back();
+    heap.pop_back();
+    if (i < heap.size()) {
+        // The moved entry may belong above or below its new slot.
+        siftUp(i);
+        siftDown(i);
+    }
+    return true;
+}
+
+int VehicleLane::size() const {
+    return static_cast<int>(heap.size());
+}
+
+bool VehicleLane::empty() const {
+    return heap.empty();
+}
+
+void VehicleLane::reserve(size_t n) {
+    heap.reserve(n);
+}
+
+void VehicleLane::print() const {
+    vector<Entry> ordered(heap);
+    sort(ordered.begin(), ordered.end(), before);
+
+    cout << "Lane: \n";
+    for (const Entry &e : ordered) {
+        cout << VehicleStore::at(e.vehicle)->getType() << "(" << (e.order >> PRIORITY_SHIFT) << ") ";
+    }
+    cout << endl;
+}
@@ -3,24 +3,39 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "Vehicle.h"
 
 using namespace std;
 
 // A priority-ordered lane of vehicles. Highest priority and earliest arrival
-// are always at the front of the lane.
+// are always at the front of the lane; vehicles with equal priority and
+// arrival time keep their insertion order.
+//
+// Backed by a growable binary min-heap, so push and pop are O(log n) and
+// front is O(1). The ordering key is copied into each heap entry so sifting
+// never has to dereference the vehicle, and vehicles are held by their
+// 32-bit VehicleStore index, so an entry is 16 bytes.
 class VehicleLane {
-    static const int MAX_CAPACITY = 100;
-    Vehicle* vehicles[MAX_CAPACITY];
-    int count;
+    struct Entry {
+        int arrival_time;
+        uint32_t vehicle;   // VehicleStore index
+        uint64_t order;     // priority in the top byte, then insertion order
+    };
 
-    // Reorder vehicles in-place by (priority, arrival_time).
-    void reorder();
+    vector<Entry> heap;
+    uint64_t nextSeq;
+
+    static bool before(const Entry &a, const Entry &b);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
 
 public:
     VehicleLane();
 
-    // Insert vehicle according to its priority. Returns false if lane is full.
+    // Insert vehicle according to its priority. Always succeeds; the lane
+    // grows as needed.
     bool push(Vehicle* v);
 
     // Peek at the next vehicle to cross, or nullptr if empty.
@@ -29,9 +44,17 @@ public:
     // Remove the vehicle at the front (no-op if empty).
     void pop();
 
+    // Remove a given vehicle wherever it is queued: O(log n) at the front,
+    // O(n) elsewhere. Returns false if it is not in the lane.
+    bool erase(Vehicle* v);
+
     int size() const;
     bool empty() const;
 
+    // Pre-size the lane for an expected number of queued vehicles.
+    void reserve(size_t n);
+
+    // Prints in crossing order. Sorts a copy, so keep it off hot paths.
     void print() const;
 };
 
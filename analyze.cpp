@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "Columns.h"
+#include "TraceAnalysis.h"
+
+using namespace std;
+
+// Analyzer for column output (main_sim --columns=DIR): per-lane arrivals,
+// crossings per hour and wait percentiles, and per-lot parking outcomes and
+// utilization. Several directories (e.g. DIR.F10 and DIR.F11) are summed.
+//
+// Usage: ./analyze DIR [DIR...]
+
+static double monotonicSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || string(argv[1]).compare(0, 2, "--") == 0) {
+        cerr << "Usage: " << argv[0] << " DIR [DIR...]" << endl;
+        return 1;
+    }
+
+    double start = monotonicSeconds();
+    TraceReport report;
+    for (int i = 1; i < argc; ++i) {
+        ColumnSet set;
+        if (!set.open(argv[i])) {
+            return 1;
+        }
+        if (set.unevenTail()) {
+            cout << "[Analyze] " << argv[i] << " ends in a partial row; reading up to it." << endl;
+        }
+        analyzeColumns(set, report);
+    }
+    double wall = monotonicSeconds() - start;
+
+    printTraceReport(report, cout);
+    cout << "\n[Analyze] " << report.rows << " rows (" << report.bytes / 1e6 << " MB) from "
+         << argc - 1 << " director" << (argc == 2 ? "y" : "ies") << " in " << wall << " s ("
+         << (wall > 0 ? report.rows / wall / 1e6 : 0) << "M rows/s)." << endl;
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <type_traits>
+#include <time.h>
+
+using namespace std;
+
+// Monotonic clock in nanoseconds for benchmark timing.
+inline uint64_t benchNowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// BENCH_FORMAT=json in the environment switches results to JSON lines.
+inline bool benchJson() {
+    static const bool json = [] {
+        const char* f = getenv("BENCH_FORMAT");
+        return f && string(f) == "json";
+    }();
+    return json;
+}
+
+// One result line in "key=value" form, printed when the object goes out of
+// scope. Easy to read and easy to grep/parse. With BENCH_FORMAT=json it is
+// one JSON object instead, tagged with BENCH_VERSION if that is set, so
+// runs of different versions can be compared by tools.
+class BenchResult {
+    ostringstream line;
+
+    template <typename T>
+    void jsonValue(const T &value, true_type) {
+        if (is_floating_point<T>::value && !isfinite(static_cast<double>(value))) {
+            line << "null";
+        } else {
+            line << value;
+        }
+    }
+
+    template <typename T>
+    void jsonValue(const T &value, false_type) {
+        ostringstream text;
+        text << value;
+        line << '"';
+        for (char c : text.str()) {
+            if (c == '"' || c == '\\') {
+                line << '\\';
+            }
+            line << c;
+        }
+        line << '"';
+    }
+
+public:
+    explicit BenchResult(const string &bench) {
+        if (!benchJson()) {
+            line << "bench=" << bench;
+            return;
+        }
+        line << "{\"bench\":";
+        jsonValue(bench, false_type());
+        if (const char* version = getenv("BENCH_VERSION")) {
+            line << ",\"version\":";
+            jsonValue(string(version), false_type());
+        }
+    }
+
+    template <typename T>
+    BenchResult& add(const string &key, const T &value) {
+        if (!benchJson()) {
+            line << ' ' << key << '=' << value;
+            return *this;
+        }
+        line << ",\"" << key << "\":";
+        jsonValue(value, integral_constant<bool, is_arithmetic<T>::value>());
+        return *this;
+    }
+
+    ~BenchResult() {
+        if (benchJson()) {
+            line << '}';
+        }
+        cout << line.str() << endl;
+    }
+};
+
+#endif
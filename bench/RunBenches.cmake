@@ -0,0 +1,50 @@
+# Runs the hot-path benchmarks with BENCH_FORMAT=json and appends their
+# results to OUTPUT, tagged with the source tree's git revision.
+#
+# cmake -DBENCH_DIR=build/bench -DSOURCE_DIR=. -DOUTPUT=results.jsonl -P bench/RunBenches.cmake
+
+set(SUITE
+    "lane_bench"
+    "ingress_bench"
+    "crossing_stress,20000"
+    "decision_bench"
+    "parking_bench,200000"
+    "ipc_bench,200000"
+    "transport_bench"
+)
+
+set(version "unknown")
+find_program(GIT git)
+if(GIT)
+    execute_process(COMMAND ${GIT} describe --always --dirty
+                    WORKING_DIRECTORY ${SOURCE_DIR}
+                    OUTPUT_VARIABLE version OUTPUT_STRIP_TRAILING_WHITESPACE
+                    ERROR_QUIET)
+endif()
+
+set(ENV{BENCH_FORMAT} json)
+set(ENV{BENCH_VERSION} ${version})
+
+set(failed)
+foreach(entry ${SUITE})
+    string(REPLACE "," ";" command "${entry}")
+    list(GET command 0 name)
+    list(REMOVE_AT command 0)
+    message(STATUS "bench: ${name} ${command}")
+    execute_process(COMMAND ${BENCH_DIR}/${name} ${command}
+                    OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+    # Keep only result lines; some benches let the simulator print too.
+    string(REGEX MATCHALL "{\"bench\"[^\n]*" lines "${out}")
+    foreach(line ${lines})
+        message("${line}")
+        file(APPEND ${OUTPUT} "${line}\n")
+    endforeach()
+    if(NOT rc EQUAL 0)
+        list(APPEND failed ${name})
+    endif()
+endforeach()
+
+message(STATUS "bench: results appended to ${OUTPUT}")
+if(failed)
+    message(FATAL_ERROR "bench: failed: ${failed}")
+endif()
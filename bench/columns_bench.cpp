@@ -0,0 +1,239 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "BenchUtil.h"
+#include "Columns.h"
+#include "TraceAnalysis.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "Scenario.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "ParkingLot.h"
+#include "Log.h"
+
+using namespace std;
+
+// Column output and analysis. Writes a synthetic run of `rows` events
+// (arrivals, crossings and parking at 16 intersections) through
+// ColumnWriter, then maps and analyzes it, in rows/sec. The first 4M
+// arrival and crossing rows rendered as `key=value` log lines and scraped
+// back, the way runs were analyzed before, are the baseline. Also reports the cost of writing
+// columns during a discrete-event run.
+//
+// Build: g++ -O3 -I. -o columns_bench bench/columns_bench.cpp Columns.cpp TraceAnalysis.cpp Scenario.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp ArrivalQueue.cpp Log.cpp Metrics.cpp Recording.cpp -pthread
+// Usage: ./columns_bench [rows=10000000]
+
+namespace {
+
+const char* COLUMNS_DIR = "/tmp/columns_bench";
+const int SITES = 16;
+
+// Per-lane crossings and waits from `key=value` lines, as a script over
+// the log would compute them.
+void scrapeText(const string &text, vector<HistogramSnapshot> &lanes) {
+    const char* p = text.c_str();
+    while (*p) {
+        const char* end = strchr(p, '\n');
+        if (!end) {
+            break;
+        }
+        const char* event = strstr(p, "event=");
+        if (event && event < end && strncmp(event + 6, "CROSSING ", 9) == 0) {
+            const char* site = strstr(event, "site=F");
+            const char* peer = strstr(event, "peer=");
+            const char* value = strstr(event, "value=");
+            if (site && peer && value && value < end) {
+                int s = atoi(site + 6);
+                Direction lane;
+                string laneName(peer + 5, strcspn(peer + 5, " "));
+                if (s >= 0 && s < SITES && parseDirection(laneName, lane)) {
+                    uint64_t ms = strtoull(value + 6, nullptr, 10);
+                    HistogramSnapshot &h = lanes[s * DIRECTION_COUNT + directionIndex(lane)];
+                    ++h.count;
+                    h.sum += ms;
+                    ++h.buckets[MetricBuckets::indexOf(ms)];
+                }
+            }
+        }
+        p = end + 1;
+    }
+}
+
+void removeDir(const char* dir) {
+    if (DIR* d = opendir(dir)) {
+        while (dirent* e = readdir(d)) {
+            if (e->d_name[0] != '.') {
+                unlink((string(dir) + "/" + e->d_name).c_str());
+            }
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+double runDiscreteEvent(const string &trace, bool columns, int &crossed) {
+    ParkingLot lot("F10", 10, 15);
+    Intersection intersection(&lot);
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+        intersection.addVehicle(veh->getApproach(), veh);
+    };
+    TrafficController controller(&intersection, 5);
+    EventSimulator sim(intersection, controller, &lot);
+    ScenarioReader reader;
+    reader.open(trace);
+    ScenarioFeed feed(reader, "F10");
+    feed.setVehicleSetup([&hooks](Vehicle* v) { v->setHooks(&hooks); });
+    sim.setSource(&feed);
+
+    if (columns) {
+        ColumnWriter::start(COLUMNS_DIR);
+    }
+    uint64_t t0 = benchNowNs();
+    sim.run();
+    ColumnWriter::stop();
+    double wall = (benchNowNs() - t0) / 1e9;
+    crossed = controller.getCrossedCount();
+    return wall;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned long rows = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+    Log::setMode(LogMode::OFF);
+
+    // One vehicle per site and type is enough to stamp rows with.
+    static const char* types[] = {"car", "bike", "bus", "tractor", "ambulance", "firetruck"};
+    vector<Vehicle*> vehicles;
+    vector<string> lots;
+    for (int s = 0; s < SITES; ++s) {
+        lots.push_back("F" + to_string(s));
+        for (const char* type : types) {
+            int id = static_cast<int>(vehicles.size()); // site = id / 6
+            vehicles.push_back(VehicleStore::create(id, type, lots.back(), lots.back(), 0));
+        }
+    }
+
+    // Each vehicle arrives and crosses; one in four also parks and leaves.
+    mt19937 rng(7);
+    uniform_int_distribution<int> pick(0, SITES * 6 - 1);
+    uniform_int_distribution<int> lanePick(0, DIRECTION_COUNT - 1);
+    exponential_distribution<double> waitMs(1.0 / 20000);
+    unsigned long written = 0;
+    vector<int> parked(SITES, 0);
+
+    ColumnWriter::start(COLUMNS_DIR);
+    uint64_t t0 = benchNowNs();
+    for (long ms = 0; written < rows; ms += 50) {
+        ColumnWriter::setTime(ms);
+        Vehicle* v = vehicles[pick(rng)];
+        int site = static_cast<int>(v->getId() / 6);
+        Direction lane = directionAt(lanePick(rng));
+        long wait = static_cast<long>(waitMs(rng));
+        ColumnWriter::arrival(v, lane);
+        ColumnWriter::crossing(v, lane, wait);
+        written += 2;
+        if (written % 8 == 2 && parked[site] < 10) {
+            ColumnWriter::parking(LogEvent::WAITING_RESERVED, lots[site], 10, parked[site], v);
+            ColumnWriter::parking(LogEvent::SPOT_ACQUIRED, lots[site], 10, ++parked[site], v);
+            written += 2;
+        } else if (written % 8 == 6 && parked[site] > 0) {
+            ColumnWriter::parking(LogEvent::PARKING_LEFT, lots[site], 10, --parked[site], v);
+            ++written;
+        }
+    }
+    ColumnWriter::stop();
+    double writeWall = (benchNowNs() - t0) / 1e9;
+
+    ColumnSet set;
+    if (!set.open(COLUMNS_DIR)) {
+        return 1;
+    }
+    TraceReport report;
+    t0 = benchNowNs();
+    analyzeColumns(set, report);
+    double analyzeWall = (benchNowNs() - t0) / 1e9;
+
+    // The first arrivals and crossings again, as log lines.
+    string text;
+    unsigned long textRows = 0;
+    for (size_t i = 0; i < set.crossings.rows && textRows < 4000000; ++i, textRows += 2) {
+        char line[512];
+        const string &site = set.sites()[set.crossings.site[i]].name;
+        const char* lane = directionName(directionAt(set.crossings.lane[i])).c_str();
+        int n = snprintf(line, sizeof(line),
+                         "ts_ns=%lld000000 thread=1 level=DEBUG event=VEHICLE_ARRIVED vehicle=%d type=car "
+                         "site=%s peer=%s value=0 value2=0\n"
+                         "ts_ns=%lld000000 thread=1 level=INFO event=CROSSING vehicle=%d type=car "
+                         "site=%s peer=%s value=%d value2=0\n",
+                         static_cast<long long>(set.arrivals.timeMs[i]), set.arrivals.vehicle[i], site.c_str(), lane,
+                         static_cast<long long>(set.crossings.timeMs[i]), set.crossings.vehicle[i], site.c_str(), lane,
+                         set.crossings.waitMs[i]);
+        text.append(line, n);
+    }
+    vector<HistogramSnapshot> scraped(SITES * DIRECTION_COUNT);
+    t0 = benchNowNs();
+    scrapeText(text, scraped);
+    double scrapeWall = (benchNowNs() - t0) / 1e9;
+
+    uint64_t crossings = 0;
+    for (const LaneStats &l : report.lanes) {
+        crossings += l.crossings;
+    }
+    BenchResult("columns_analyze")
+        .add("rows", report.rows)
+        .add("bytes", report.bytes)
+        .add("bytes_per_row", static_cast<double>(report.bytes) / report.rows)
+        .add("crossings", crossings)
+        .add("write_rows_per_s", written / writeWall)
+        .add("analyze_s", analyzeWall)
+        .add("analyze_rows_per_s", report.rows / analyzeWall)
+        .add("text_rows", textRows)
+        .add("text_scrape_rows_per_s", textRows / scrapeWall)
+        .add("speedup", (report.rows / analyzeWall) / (textRows / scrapeWall));
+    set.close();
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+
+    TraceOptions options;
+    options.origins = {"F10"};
+    options.vehiclesPerHour = 400;
+    options.duration = 86400;
+    string tracePath = "/tmp/columns_bench_trace.csv";
+    unsigned long traced;
+    {
+        ofstream out(tracePath);
+        traced = writeSyntheticTrace(out, options);
+    }
+    int crossedOff, crossedOn;
+    double off = runDiscreteEvent(tracePath, false, crossedOff);
+    double on = runDiscreteEvent(tracePath, true, crossedOn);
+    remove(tracePath.c_str());
+    BenchResult("columns_write_cost")
+        .add("vehicles", traced)
+        .add("off_vehicles_per_s", traced / off)
+        .add("on_vehicles_per_s", traced / on)
+        .add("overhead_pct", 100.0 * (on - off) / off)
+        .add("rows", ColumnWriter::rows());
+
+    removeDir(COLUMNS_DIR);
+
+    if (crossedOff != crossedOn) {
+        cerr << "columns_bench: writing columns changed the run" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <atomic>
+#include <cstdlib>
+#include <pthread.h>
+
+#include "BenchUtil.h"
+#include "Intersection.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Crossing under concurrent arrivals: 1-16 producer threads queue vehicles
+// of mixed priority while one controller thread keeps letting lane heads
+// cross, then drains the intersection. Every vehicle must cross exactly
+// once. "probe" is the old release path (find the lane from a snapshot,
+// then pop whatever is at its front); "ticket" removes exactly the vehicle
+// from the snapshot. Exits non-zero if the ticket path loses or repeats a
+// vehicle.
+//
+// Build: g++ -O2 -I. -o crossing_stress bench/crossing_stress.cpp Intersection.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./crossing_stress [vehicles_per_producer=20000]
+
+namespace {
+
+struct Shared {
+    Intersection* inter;
+    vector<Vehicle*>* vehicles;
+    int producers;
+    atomic<int> producersLeft;
+};
+
+struct ProducerArgs {
+    Shared* shared;
+    int index;
+};
+
+void* producer(void* arg) {
+    ProducerArgs* a = static_cast<ProducerArgs*>(arg);
+    vector<Vehicle*> &vehicles = *a->shared->vehicles;
+    for (size_t i = a->index; i < vehicles.size(); i += a->shared->producers) {
+        a->shared->inter->addVehicle(vehicles[i]->getApproach(), vehicles[i]);
+    }
+    a->shared->producersLeft.fetch_sub(1);
+    return nullptr;
+}
+
+// One crossing per lane head in the snapshot. Returns how many crossed.
+long crossHeads(Intersection &inter, bool tickets, vector<int> &crossings) {
+    LaneSnapshot snap = inter.snapshot();
+    long n = 0;
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        Vehicle* v = snap.heads[i];
+        if (!v) {
+            continue;
+        }
+        if (tickets) {
+            if (!inter.removeVehicle(snap.ticket(directionAt(i)))) {
+                continue;
+            }
+        } else {
+            // A higher-priority arrival can reach the front in between.
+            inter.removeVehicle(directionAt(i));
+        }
+        ++crossings[v->getId()];
+        ++n;
+    }
+    return n;
+}
+
+bool run(bool tickets, int producers, int perProducer) {
+    int total = producers * perProducer;
+    mt19937 rng(7);
+    uniform_int_distribution<int> typeDist(0, 9);
+    uniform_int_distribution<int> arrivalDist(0, 1000);
+    static const char* types[] = {"car", "car", "car", "car", "car", "bike", "bus", "bus", "tractor", "ambulance"};
+
+    vector<Vehicle*> vehicles;
+    for (int i = 0; i < total; ++i) {
+        vehicles.push_back(VehicleStore::create(i, types[typeDist(rng)], "F10", "F11", arrivalDist(rng)));
+        vehicles.back()->setApproach(directionAt(i % DIRECTION_COUNT));
+    }
+    vector<int> crossings(total, 0);
+
+    Intersection inter(nullptr);
+    Shared shared{&inter, &vehicles, producers, {producers}};
+    vector<ProducerArgs> args(producers);
+    vector<pthread_t> tids(producers);
+
+    uint64_t t0 = benchNowNs();
+    for (int p = 0; p < producers; ++p) {
+        args[p] = ProducerArgs{&shared, p};
+        pthread_create(&tids[p], nullptr, producer, &args[p]);
+    }
+    long crossed = 0;
+    while (shared.producersLeft.load() > 0) {
+        crossed += crossHeads(inter, tickets, crossings);
+    }
+    for (pthread_t t : tids) {
+        pthread_join(t, nullptr);
+    }
+    while (!inter.empty()) {
+        crossed += crossHeads(inter, tickets, crossings);
+    }
+    double wall = (benchNowNs() - t0) / 1e9;
+
+    long lost = 0;
+    long duplicates = 0;
+    for (int c : crossings) {
+        if (c == 0) {
+            ++lost;
+        } else if (c > 1) {
+            duplicates += c - 1;
+        }
+    }
+
+    BenchResult("crossing_stress")
+        .add("mode", tickets ? "ticket" : "probe")
+        .add("producers", producers)
+        .add("vehicles", total)
+        .add("crossings", crossed)
+        .add("lost", lost)
+        .add("duplicates", duplicates)
+        .add("crossings_per_s", crossed / wall);
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+    return lost == 0 && duplicates == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int perProducer = argc > 1 ? atoi(argv[1]) : 20000;
+
+    bool ok = true;
+    for (int producers : {1, 4, 16}) {
+        run(false, producers, perProducer);
+        ok = run(true, producers, perProducer) && ok;
+    }
+    return ok ? 0 : 1;
+}
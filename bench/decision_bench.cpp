@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+
+#include "BenchUtil.h"
+#include "Intersection.h"
+#include "VehileLane.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Per-decision cost of the controller: string-keyed lanes probed with
+// separately locked hasVehicle/getNextVehicle calls (the original
+// Intersection API) vs Direction-indexed lanes read with one snapshot.
+//
+// A decision is what TrafficController::step() does at a cycle start:
+// look for an emergency at any lane head, then release the head of the
+// phase's lane and find which lane it came from.
+//
+// Build: g++ -O2 -I. -o decision_bench bench/decision_bench.cpp Intersection.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+
+namespace {
+
+const string NORTH = "NORTH";
+const string SOUTH = "SOUTH";
+const string EAST  = "EAST";
+const string WEST  = "WEST";
+const string* LEGACY_DIRS[] = {&NORTH, &SOUTH, &EAST, &WEST};
+
+// The original string-dispatched intersection.
+class LegacyIntersection {
+    VehicleLane northLane, southLane, eastLane, westLane;
+    mutable mutex mtx;
+
+    const VehicleLane* lane(const string &d) const {
+        if (d == NORTH) return &northLane;
+        else if (d == SOUTH) return &southLane;
+        else if (d == EAST) return &eastLane;
+        else if (d == WEST) return &westLane;
+        return nullptr;
+    }
+
+public:
+    void addVehicle(const string &d, Vehicle* v) {
+        lock_guard<mutex> lock(mtx);
+        const_cast<VehicleLane*>(lane(d))->push(v);
+    }
+    Vehicle* getNextVehicle(const string &d) const {
+        lock_guard<mutex> lock(mtx);
+        return lane(d)->front();
+    }
+    void removeVehicle(const string &d) {
+        lock_guard<mutex> lock(mtx);
+        const_cast<VehicleLane*>(lane(d))->pop();
+    }
+    bool hasVehicle(const string &d) const {
+        lock_guard<mutex> lock(mtx);
+        return !lane(d)->empty();
+    }
+};
+
+Vehicle* legacyDecision(LegacyIntersection &inter, int phase) {
+    for (const string* d : LEGACY_DIRS) {
+        if (inter.hasVehicle(*d)) {
+            Vehicle* v = inter.getNextVehicle(*d);
+            if (v && v->isEmergency()) return v;
+        }
+    }
+
+    const string &dir = *LEGACY_DIRS[phase];
+    if (!inter.hasVehicle(dir)) return nullptr;
+    Vehicle* v = inter.getNextVehicle(dir);
+
+    for (const string* d : LEGACY_DIRS) {
+        if (inter.hasVehicle(*d) && inter.getNextVehicle(*d) == v) {
+            inter.removeVehicle(*d);
+            break;
+        }
+    }
+    return v;
+}
+
+Vehicle* indexedDecision(Intersection &inter, int phase) {
+    LaneSnapshot snap = inter.snapshot();
+    for (Vehicle* v : snap.heads) {
+        if (v && v->isEmergency()) return v;
+    }
+
+    Vehicle* v = snap.heads[phase];
+    if (!v) return nullptr;
+
+    snap = inter.snapshot();
+    for (int i = 0; i < DIRECTION_COUNT; ++i) {
+        if (snap.heads[i] == v) {
+            inter.removeVehicle(directionAt(i));
+            break;
+        }
+    }
+    return v;
+}
+
+} // namespace
+
+int main() {
+    const int QUEUED = 64;       // vehicles kept queued per lane
+    const int DECISIONS = 2000000;
+
+    vector<Vehicle*> pool;
+    for (int i = 0; i < QUEUED * DIRECTION_COUNT; ++i) {
+        pool.push_back(VehicleStore::create(i, i % 2 ? "car" : "bus", "F10", "F11", i));
+    }
+
+    // Each decision releases one non-emergency vehicle, which is pushed
+    // straight back so queue lengths stay constant.
+    {
+        LegacyIntersection inter;
+        for (int i = 0; i < QUEUED * DIRECTION_COUNT; ++i) {
+            inter.addVehicle(*LEGACY_DIRS[i % DIRECTION_COUNT], pool[i]);
+        }
+        uint64_t t0 = benchNowNs();
+        for (int i = 0; i < DECISIONS; ++i) {
+            int phase = i % DIRECTION_COUNT;
+            Vehicle* v = legacyDecision(inter, phase);
+            inter.addVehicle(*LEGACY_DIRS[phase], v);
+        }
+        uint64_t t1 = benchNowNs();
+        BenchResult("controller_decision").add("impl", "string_lanes")
+            .add("decisions", DECISIONS).add("ns_per_decision", static_cast<double>(t1 - t0) / DECISIONS);
+    }
+
+    {
+        Intersection inter;
+        for (int i = 0; i < QUEUED * DIRECTION_COUNT; ++i) {
+            inter.addVehicle(directionAt(i % DIRECTION_COUNT), pool[i]);
+        }
+        uint64_t t0 = benchNowNs();
+        for (int i = 0; i < DECISIONS; ++i) {
+            int phase = i % DIRECTION_COUNT;
+            Vehicle* v = indexedDecision(inter, phase);
+            inter.addVehicle(directionAt(phase), v);
+        }
+        uint64_t t1 = benchNowNs();
+        BenchResult("controller_decision").add("impl", "indexed_snapshot")
+            .add("decisions", DECISIONS).add("ns_per_decision", static_cast<double>(t1 - t0) / DECISIONS);
+    }
+
+    for (Vehicle* v : pool) VehicleStore::destroy(v);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdlib>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "ParkingLot.h"
+
+using namespace std;
+
+// Runs a full simulated day at one intersection in discrete-event mode and
+// reports how long it takes on the wall clock.
+//
+// Build: g++ -O2 -I. -o des_bench bench/des_bench.cpp EventSimulator.cpp Intersection.cpp ArrivalQueue.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./des_bench [mean_seconds_between_arrivals_per_approach=40]
+
+int main(int argc, char* argv[]) {
+    double meanGap = argc > 1 ? atof(argv[1]) : 40.0;
+    const long DAY = 24 * 3600;
+
+    // Event logs would dominate the measurement.
+    Log::setMode(LogMode::OFF);
+    streambuf* out = cout.rdbuf(nullptr);
+
+    static const char* types[] = {"car", "car", "car", "bike", "bus", "tractor", "ambulance", "firetruck"};
+
+    ParkingLot lot("F10", 10, 15);
+    Intersection intersection(&lot);
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+        intersection.addVehicle(veh->getApproach(), veh);
+    };
+    TrafficController controller(&intersection, 5);
+    EventSimulator sim(intersection, controller, &lot);
+
+    // Poisson arrivals on each approach, fixed seed.
+    mt19937 rng(42);
+    exponential_distribution<double> gap(1.0 / meanGap);
+    uniform_int_distribution<int> typeDist(0, 7);
+
+    vector<Vehicle*> vehicles;
+    for (int lane = 0; lane < 4; ++lane) {
+        double t = 0;
+        while ((t += gap(rng)) < DAY) {
+            Vehicle* v = VehicleStore::create(static_cast<int>(vehicles.size()), types[typeDist(rng)],
+                                     "F10", "F11", static_cast<int>(t));
+            v->setApproach(directionAt(lane));
+            v->setHooks(&hooks);
+            vehicles.push_back(v);
+            sim.addVehicle(v);
+        }
+    }
+
+    uint64_t t0 = benchNowNs();
+    long simulated = sim.run();
+    uint64_t t1 = benchNowNs();
+
+    cout.rdbuf(out);
+    double wall = (t1 - t0) / 1e9;
+    BenchResult("des_day")
+        .add("vehicles", vehicles.size())
+        .add("crossings", controller.getCrossedCount())
+        .add("events", sim.processedEvents())
+        .add("simulated_s", simulated)
+        .add("wall_s", wall)
+        .add("speedup", simulated / wall);
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "PhasePolicy.h"
+#include "EventSimulator.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Emergency preemption latency, from an emergency vehicle's arrival to its
+// crossing, under heavy background traffic.
+//
+// des:      four simulated hours, cars on every approach plus 20 emergencies
+//           an hour; latency in simulated seconds.
+// realtime: the controller thread at 1 ms per controller second while a
+//           producer thread queues cars and an emergency every 5 ms; latency
+//           in wall-clock microseconds. "sleep" waits out every step as the
+//           controller loop used to, "wait" is runController's wait that an
+//           emergency arrival cuts short.
+//
+// Build: g++ -O2 -I. -o emergency_bench bench/emergency_bench.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./emergency_bench
+
+// Percentiles and a coarse histogram of `samples`, with bucket upper bounds
+// in the same unit.
+static void report(BenchResult &r, vector<double> samples, const vector<double> &bounds,
+                   const string &unit) {
+    if (samples.empty()) {
+        r.add("emergencies", 0);
+        return;
+    }
+    sort(samples.begin(), samples.end());
+    r.add("emergencies", samples.size())
+     .add("p50_" + unit, samples[samples.size() / 2])
+     .add("p99_" + unit, samples[(samples.size() * 99) / 100])
+     .add("max_" + unit, samples.back());
+
+    size_t i = 0;
+    for (double bound : bounds) {
+        size_t n = 0;
+        while (i < samples.size() && samples[i] <= bound) {
+            ++i;
+            ++n;
+        }
+        r.add("le_" + to_string(static_cast<long>(bound)), n);
+    }
+    r.add("gt_" + to_string(static_cast<long>(bounds.back())), samples.size() - i);
+}
+
+static void runDes(const string &policyName, double carsPerHour) {
+    const long HORIZON = 4 * 3600;
+
+    Intersection intersection(nullptr);
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+        intersection.addVehicle(veh->getApproach(), veh);
+    };
+    TrafficController controller(&intersection, 5);
+    controller.setPolicy(makePhasePolicy(policyName));
+    EventSimulator sim(intersection, controller, nullptr);
+
+    vector<double> latencies;
+    controller.setCrossingCallback([&](Vehicle* v) {
+        if (v->isEmergency()) {
+            latencies.push_back(sim.now() - v->getArrivalTime());
+        }
+    });
+
+    mt19937 rng(42);
+    vector<Vehicle*> vehicles;
+    auto addStream = [&](int lane, double perHour, const char* type) {
+        exponential_distribution<double> gap(perHour / 3600.0);
+        double t = 0;
+        while ((t += gap(rng)) < HORIZON) {
+            Vehicle* v = VehicleStore::create(static_cast<int>(vehicles.size()), type, "F10", "F11",
+                                     static_cast<int>(t));
+            v->setApproach(directionAt(lane));
+            v->setHooks(&hooks);
+            vehicles.push_back(v);
+            sim.addVehicle(v);
+        }
+    };
+    for (int lane = 0; lane < DIRECTION_COUNT; ++lane) {
+        addStream(lane, carsPerHour, "car");
+        addStream(lane, 5, "ambulance");
+    }
+
+    sim.run(HORIZON);
+
+    BenchResult r("emergency_des");
+    r.add("policy", controller.policyName()).add("cars_per_hour", DIRECTION_COUNT * carsPerHour);
+    report(r, latencies, {0, 2, 5, 10, 60}, "s");
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+}
+
+struct RealtimeRun {
+    Intersection* intersection;
+    TrafficController* controller;
+    atomic<bool> done;
+    bool sleepLoop;
+    double scale;
+};
+
+// The old controller loop: wait out each step whatever arrives meanwhile.
+static void* sleepingController(void* arg) {
+    RealtimeRun* run = static_cast<RealtimeRun*>(arg);
+    while (!run->done) {
+        int seconds = run->controller->step();
+        usleep(static_cast<useconds_t>(seconds * run->scale * 1e6));
+    }
+    return nullptr;
+}
+
+static void runRealtime(bool sleepLoop) {
+    const int EMERGENCIES = 400;
+    const int CARS_PER_EMERGENCY = 50;
+    const double SCALE = 0.001; // 1 ms per controller second
+
+    Intersection intersection(nullptr);
+    TrafficController controller(&intersection, 5);
+    controller.setPolicy(makePhasePolicy("actuated"));
+    controller.setTimeScale(SCALE);
+
+    int total = EMERGENCIES * (CARS_PER_EMERGENCY + 1);
+    vector<Vehicle*> vehicles;
+    vector<uint64_t> arrivedNs(total, 0);
+    vector<double> latencies;
+    for (int i = 0; i < total; ++i) {
+        bool emergency = (i % (CARS_PER_EMERGENCY + 1)) == CARS_PER_EMERGENCY;
+        vehicles.push_back(VehicleStore::create(i, emergency ? "ambulance" : "car", "F10", "F11", 0));
+        vehicles.back()->setApproach(directionAt(i % DIRECTION_COUNT));
+    }
+    controller.setCrossingCallback([&](Vehicle* v) {
+        if (v->isEmergency()) {
+            latencies.push_back((benchNowNs() - arrivedNs[v->getId()]) / 1e3);
+        }
+    });
+
+    RealtimeRun run{&intersection, &controller, {false}, sleepLoop, SCALE};
+    pthread_t loop;
+    if (sleepLoop) {
+        pthread_create(&loop, nullptr, sleepingController, &run);
+    } else {
+        controller.startController();
+    }
+
+    // Cars every 100 us, an emergency every 5 ms.
+    for (int i = 0; i < total; ++i) {
+        arrivedNs[i] = benchNowNs();
+        intersection.addVehicle(vehicles[i]->getApproach(), vehicles[i]);
+        usleep(100);
+    }
+    usleep(20000); // let the last emergency through
+
+    if (sleepLoop) {
+        run.done = true;
+        pthread_join(loop, nullptr);
+    } else {
+        controller.stopController();
+    }
+
+    BenchResult r("emergency_realtime");
+    r.add("loop", sleepLoop ? "sleep" : "wait").add("queued_at_end", total - controller.getCrossedCount());
+    report(r, latencies, {10, 100, 1000, 10000}, "us");
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+}
+
+int main() {
+    Log::setMode(LogMode::OFF);
+
+    for (double carsPerHour : {300.0, 600.0}) {
+        for (const char* policy : {"fixed", "actuated", "max-pressure"}) {
+            runDes(policy, carsPerHour);
+        }
+    }
+    runRealtime(true);
+    runRealtime(false);
+    return 0;
+}
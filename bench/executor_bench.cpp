@@ -0,0 +1,100 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "ParkingLot.h"
+#include "VehicleExecutor.h"
+
+using namespace std;
+
+// Compares thread-per-vehicle against VehicleExecutor. Each mode runs in
+// its own forked child so peak RSS (ru_maxrss from wait4) is per mode.
+//
+// Build: g++ -O2 -I. -o executor_bench bench/executor_bench.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp VehicleExecutor.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./executor_bench [vehicles=10000]
+
+namespace {
+
+void runMode(VehicleExecutionMode mode, int count) {
+    // Vehicle and parking logs would dominate the measurement.
+    Log::setMode(LogMode::OFF);
+    cout.rdbuf(nullptr);
+
+    static const char* types[] = {"car", "bus", "bike", "tractor", "ambulance", "firetruck"};
+    ParkingLot lot("F10", 10, 15);
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [](Vehicle*) {};
+
+    vector<Vehicle*> vehicles;
+    vehicles.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // Spread arrivals over 0..2 s so the run stays short.
+        Vehicle* v = VehicleStore::create(i, types[i % 6], "F10", "F11", i % 3);
+        v->setHooks(&hooks);
+        vehicles.push_back(v);
+    }
+
+    if (mode == VehicleExecutionMode::THREAD_PER_VEHICLE) {
+        vector<pthread_t> threads(vehicles.size());
+        for (size_t i = 0; i < vehicles.size(); ++i) {
+            if (!vehicles[i]->start(lot, lot, threads[i])) {
+                _exit(2);
+            }
+        }
+        for (pthread_t tid : threads) {
+            pthread_join(tid, nullptr);
+        }
+    } else {
+        VehicleExecutor executor;
+        for (Vehicle* v : vehicles) {
+            executor.submit(v, lot, lot);
+        }
+        executor.start();
+        executor.waitAll();
+        executor.stop();
+    }
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+
+    const VehicleExecutionMode modes[] = {VehicleExecutionMode::THREAD_PER_VEHICLE,
+                                          VehicleExecutionMode::WORKER_POOL};
+    for (VehicleExecutionMode mode : modes) {
+        uint64_t t0 = benchNowNs();
+        pid_t pid = fork();
+        if (pid == 0) {
+            runMode(mode, count);
+            _exit(0);
+        }
+
+        int status = 0;
+        rusage usage{};
+        wait4(pid, &status, 0, &usage);
+        uint64_t t1 = benchNowNs();
+
+        BenchResult("vehicle_executor")
+            .add("mode", mode == VehicleExecutionMode::THREAD_PER_VEHICLE ? "thread" : "pool")
+            .add("vehicles", count)
+            .add("wall_s", (t1 - t0) / 1e9)
+            .add("peak_rss_kb", usage.ru_maxrss)
+            .add("ok", (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? "yes" : "no");
+    }
+    return 0;
+}
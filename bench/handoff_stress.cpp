@@ -0,0 +1,182 @@
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <cstdlib>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Intersection.h"
+#include "ParkingLot.h"
+#include "TrafficController.h"
+#include "ControllerChannel.h"
+#include "LinkHandoff.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Hand-offs between two real-time controllers in one process, as fast as
+// they go: each side queues vehicles bound for the other over a zero-length
+// road of capacity 4, while freeing its own finished vehicles the way
+// ScenarioFeed does, so VehicleStore slots are reused while the peer's
+// vehicles are still being freed by the listener threads. Both sides then
+// drain. Every vehicle must be handed off once and cross twice. Exits
+// non-zero otherwise; meant to be run under -fsanitize=address or thread
+// as well.
+//
+// Build: g++ -O2 -I. -o handoff_stress bench/handoff_stress.cpp LinkHandoff.cpp ControllerChannel.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Intersection.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./handoff_stress [vehicles_per_side=2000]
+
+namespace {
+
+const double TIME_SCALE = 0.0001; // a controller second takes 0.1 ms
+
+struct Side {
+    Side(const string &self, const string &peer, int readFd, int writeFd)
+        : name(self), lot(self), intersection(&lot), controller(&intersection), channel(readFd, writeFd),
+          stop(false) {
+        RoadLink out{0, 1, 0, 4, Direction::WEST};
+        RoadLink in{1, 0, 0, 4, Direction::EAST};
+        handoff.reset(new LinkHandoff(self, peer, out, in, channel, intersection, benchNowNs() / 1e9));
+        controller.setTimeScale(TIME_SCALE);
+        controller.setDepartureCheck([this](const Vehicle* v) { return handoff->mayDepart(v); });
+        controller.setCrossingCallback([this](Vehicle* v) { handoff->crossed(v); });
+    }
+
+    string name;
+    ParkingLot lot;
+    Intersection intersection;
+    TrafficController controller;
+    ControllerChannel channel;
+    unique_ptr<LinkHandoff> handoff;
+    atomic<bool> stop;
+    bool drained = false;
+};
+
+void* listen(void* arg) {
+    Side* s = static_cast<Side*>(arg);
+    vector<ControllerMessage> batch;
+    while (!s->stop.load()) {
+        s->channel.flush();
+        s->handoff->poll();
+        batch.clear();
+        if (s->channel.receive(batch, 1) < 0) {
+            s->handoff->peerClosed();
+            usleep(1000);
+            continue;
+        }
+        for (const ControllerMessage &msg : batch) {
+            s->handoff->receive(msg);
+        }
+    }
+    s->channel.flush();
+    return nullptr;
+}
+
+struct ProducerArgs {
+    Side* side;
+    string peer;
+    int firstId;
+    int count;
+};
+
+void* produce(void* arg) {
+    ProducerArgs* a = static_cast<ProducerArgs*>(arg);
+    mt19937 rng(a->firstId);
+    // Not the lane the inbound road feeds: a local vehicle waiting on a full
+    // outbound road would hold the peer's vehicles behind it, and the peer's
+    // the same, for good.
+    const Direction lanes[] = {Direction::NORTH, Direction::SOUTH, Direction::WEST};
+    uniform_int_distribution<int> lane(0, 2);
+    deque<Vehicle*> owned;
+    for (int i = 0; i < a->count; ++i) {
+        Vehicle* v = VehicleStore::create(a->firstId + i, i % 5 ? "car" : "bus", a->side->name, a->peer, 0);
+        v->setApproach(lanes[lane(rng)]);
+        a->side->handoff->expect(v);
+        a->side->intersection.addVehicle(v->getApproach(), v);
+        v->finishArrival();
+        owned.push_back(v);
+        while (!owned.empty() && owned.front()->isFinished()) {
+            VehicleStore::destroy(owned.front());
+            owned.pop_front();
+        }
+        if (i % 8 == 0) {
+            usleep(100);
+        }
+    }
+    a->side->drained = a->side->handoff->drain(1);
+    // Both controllers still run; drain() waited until these crossed.
+    while (!owned.empty()) {
+        while (!owned.front()->isFinished()) {
+            usleep(1000);
+        }
+        VehicleStore::destroy(owned.front());
+        owned.pop_front();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+    Log::setMode(LogMode::OFF);
+
+    int ab[2], ba[2];
+    if (pipe(ab) != 0 || pipe(ba) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    streambuf* out = cout.rdbuf(nullptr);
+    Side a("A", "B", ba[0], ab[1]);
+    Side b("B", "A", ab[0], ba[1]);
+
+    uint64_t t0 = benchNowNs();
+    a.controller.startController();
+    b.controller.startController();
+    pthread_t listeners[2], producers[2];
+    pthread_create(&listeners[0], nullptr, listen, &a);
+    pthread_create(&listeners[1], nullptr, listen, &b);
+    ProducerArgs pa{&a, "B", 1, count}, pb{&b, "A", 1 + count, count};
+    pthread_create(&producers[0], nullptr, produce, &pa);
+    pthread_create(&producers[1], nullptr, produce, &pb);
+    pthread_join(producers[0], nullptr);
+    pthread_join(producers[1], nullptr);
+    uint64_t t1 = benchNowNs();
+
+    a.controller.stopController();
+    b.controller.stopController();
+    a.stop = b.stop = true;
+    pthread_join(listeners[0], nullptr);
+    pthread_join(listeners[1], nullptr);
+    a.channel.closeSend();
+    b.channel.closeSend();
+    cout.rdbuf(out);
+
+    bool ok = a.drained && b.drained &&
+              a.handoff->handedOff() == static_cast<unsigned long>(count) &&
+              b.handoff->handedOff() == static_cast<unsigned long>(count) &&
+              a.handoff->taken() == b.handoff->handedOff() && b.handoff->taken() == a.handoff->handedOff() &&
+              a.controller.getCrossedCount() == 2 * count && b.controller.getCrossedCount() == 2 * count;
+    BenchResult("handoff_stress")
+        .add("vehicles_per_side", count)
+        .add("handed_off", a.handoff->handedOff() + b.handoff->handedOff())
+        .add("taken", a.handoff->taken() + b.handoff->taken())
+        .add("crossings", a.controller.getCrossedCount() + b.controller.getCrossedCount())
+        .add("held", a.controller.getHeldCount() + b.controller.getHeldCount())
+        .add("wall_s", (t1 - t0) / 1e9)
+        .add("ok", ok ? 1 : 0);
+    close(ab[0]);
+    close(ba[0]);
+    if (!ok) {
+        cerr << "handoff_stress: vehicles lost, repeated or stuck on the road" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <pthread.h>
+
+#include "BenchUtil.h"
+#include "Intersection.h"
+#include "VehileLane.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Arrival contention: 1..64 producer threads call addVehicle while one
+// controller thread keeps making decisions. Compares the lock-free ingress
+// queue against the original design where producers and the controller
+// share the intersection mutex.
+//
+// Build: g++ -O2 -I. -o ingress_bench bench/ingress_bench.cpp Intersection.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+
+namespace {
+
+const int PER_PRODUCER = 5000;
+
+// The original locking scheme: every arrival takes the controller's mutex.
+class LockedIntersection {
+    VehicleLane lanes[DIRECTION_COUNT];
+    mutable mutex mtx;
+
+public:
+    void addVehicle(Direction d, Vehicle* v) {
+        lock_guard<mutex> lock(mtx);
+        lanes[directionIndex(d)].push(v);
+    }
+    LaneSnapshot snapshot() const {
+        lock_guard<mutex> lock(mtx);
+        LaneSnapshot snap;
+        for (int i = 0; i < DIRECTION_COUNT; ++i) {
+            snap.heads[i] = lanes[i].front();
+            snap.sizes[i] = lanes[i].size();
+        }
+        snap.emergency = nullptr;
+        return snap;
+    }
+    void removeVehicle(Direction d) {
+        lock_guard<mutex> lock(mtx);
+        lanes[directionIndex(d)].pop();
+    }
+};
+
+template <typename Inter>
+struct Shared {
+    Inter* inter;
+    vector<Vehicle*>* vehicles;
+    atomic<int> producersLeft;
+    atomic<bool> go;
+    vector<uint64_t> decisionNs;
+    long crossed;
+};
+
+template <typename Inter>
+struct ProducerArg {
+    Shared<Inter>* shared;
+    int index;
+};
+
+template <typename Inter>
+void* producer(void* arg) {
+    ProducerArg<Inter>* pa = static_cast<ProducerArg<Inter>*>(arg);
+    Shared<Inter>* sh = pa->shared;
+    while (!sh->go.load(memory_order_acquire)) {}
+
+    size_t base = static_cast<size_t>(pa->index) * PER_PRODUCER;
+    for (int i = 0; i < PER_PRODUCER; ++i) {
+        sh->inter->addVehicle(directionAt(i % DIRECTION_COUNT), (*sh->vehicles)[base + i]);
+    }
+    sh->producersLeft.fetch_sub(1, memory_order_release);
+    return nullptr;
+}
+
+template <typename Inter>
+void* controller(void* arg) {
+    Shared<Inter>* sh = static_cast<Shared<Inter>*>(arg);
+    while (!sh->go.load(memory_order_acquire)) {}
+
+    int phase = 0;
+    while (true) {
+        bool producing = sh->producersLeft.load(memory_order_acquire) > 0;
+
+        uint64_t t0 = benchNowNs();
+        LaneSnapshot snap = sh->inter->snapshot();
+        bool any = false;
+        for (int i = 0; i < DIRECTION_COUNT; ++i) {
+            if (snap.heads[i]) any = true;
+        }
+        if (snap.heads[phase]) {
+            sh->inter->removeVehicle(directionAt(phase));
+            ++sh->crossed;
+        }
+        uint64_t t1 = benchNowNs();
+
+        if (producing) {
+            sh->decisionNs.push_back(t1 - t0);
+        } else if (!any) {
+            break;
+        }
+        phase = (phase + 1) % DIRECTION_COUNT;
+    }
+    return nullptr;
+}
+
+template <typename Inter>
+void run(const string &impl, int producers, vector<Vehicle*> &vehicles) {
+    Inter inter;
+    Shared<Inter> sh;
+    sh.inter = &inter;
+    sh.vehicles = &vehicles;
+    sh.producersLeft = producers;
+    sh.go = false;
+    sh.crossed = 0;
+    sh.decisionNs.reserve(1 << 20);
+
+    vector<ProducerArg<Inter>> args(producers);
+    vector<pthread_t> tids(producers);
+    pthread_t ctrl;
+    pthread_create(&ctrl, nullptr, controller<Inter>, &sh);
+    for (int i = 0; i < producers; ++i) {
+        args[i] = ProducerArg<Inter>{&sh, i};
+        pthread_create(&tids[i], nullptr, producer<Inter>, &args[i]);
+    }
+
+    uint64_t t0 = benchNowNs();
+    sh.go.store(true, memory_order_release);
+    for (pthread_t t : tids) pthread_join(t, nullptr);
+    uint64_t t1 = benchNowNs();
+    pthread_join(ctrl, nullptr);
+
+    vector<uint64_t> &lat = sh.decisionNs;
+    sort(lat.begin(), lat.end());
+    auto pct = [&lat](double p) -> uint64_t {
+        return lat.empty() ? 0 : lat[static_cast<size_t>(p * (lat.size() - 1))];
+    };
+
+    long total = static_cast<long>(producers) * PER_PRODUCER;
+    BenchResult("intersection_ingress")
+        .add("impl", impl)
+        .add("producers", producers)
+        .add("arrivals_per_s", total / ((t1 - t0) / 1e9))
+        .add("decisions", lat.size())
+        .add("decision_p50_ns", pct(0.50))
+        .add("decision_p99_ns", pct(0.99))
+        .add("crossed", sh.crossed)
+        .add("lost", total - sh.crossed);
+}
+
+} // namespace
+
+int main() {
+    const int MAX_PRODUCERS = 64;
+    vector<Vehicle*> vehicles;
+    vehicles.reserve(static_cast<size_t>(MAX_PRODUCERS) * PER_PRODUCER);
+    for (int i = 0; i < MAX_PRODUCERS * PER_PRODUCER; ++i) {
+        vehicles.push_back(VehicleStore::create(i, (i % 7) ? "car" : "bus", "F10", "F11", i));
+    }
+
+    for (int p = 1; p <= MAX_PRODUCERS; p *= 2) {
+        run<LockedIntersection>("mutex", p, vehicles);
+        run<Intersection>("lockfree_mpsc", p, vehicles);
+    }
+
+    for (Vehicle* v : vehicles) VehicleStore::destroy(v);
+    return 0;
+}
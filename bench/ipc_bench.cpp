@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "BenchUtil.h"
+#include "TrafficController.h"
+#include "ControllerChannel.h"
+
+using namespace std;
+
+// One-way ControllerMessage throughput and latency between two processes:
+// one write/read syscall per message (sendMessage/receiveMessage) vs the
+// batched ControllerChannel. The receiving child reports the results.
+//
+// Build: g++ -O2 -I. -o ipc_bench bench/ipc_bench.cpp ControllerChannel.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Intersection.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./ipc_bench [messages=200000]
+
+namespace {
+
+void report(const string &impl, vector<uint64_t> &lat, uint64_t firstSent, uint64_t lastRecv) {
+    sort(lat.begin(), lat.end());
+    auto pct = [&lat](double p) -> uint64_t {
+        return lat.empty() ? 0 : lat[static_cast<size_t>(p * (lat.size() - 1))];
+    };
+    BenchResult("ipc_one_way")
+        .add("impl", impl)
+        .add("messages", lat.size())
+        .add("msgs_per_s", lat.size() / ((lastRecv - firstSent) / 1e9))
+        .add("lat_p50_ns", pct(0.50))
+        .add("lat_p99_ns", pct(0.99));
+}
+
+void run(const string &impl, int messages) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[1]);
+        vector<uint64_t> lat;
+        lat.reserve(messages);
+        uint64_t firstSent = 0, lastRecv = 0;
+
+        if (impl == "unbatched") {
+            ControllerMessage msg{};
+            while (TrafficController::receiveMessage(fds[0], msg)) {
+                lastRecv = benchNowNs();
+                if (!firstSent) firstSent = msg.sentAtNs;
+                lat.push_back(lastRecv - msg.sentAtNs);
+            }
+        } else {
+            ControllerChannel channel(fds[0], -1);
+            vector<ControllerMessage> batch;
+            while (true) {
+                batch.clear();
+                int n = channel.receive(batch, -1);
+                if (n < 0) break;
+                lastRecv = benchNowNs();
+                for (const ControllerMessage &msg : batch) {
+                    if (!firstSent) firstSent = msg.sentAtNs;
+                    lat.push_back(lastRecv - msg.sentAtNs);
+                }
+            }
+        }
+        report(impl, lat, firstSent, lastRecv);
+        _exit(0);
+    }
+
+    close(fds[0]);
+    ControllerMessage msg{};
+    msg.priority = 1;
+    msg.isEmergency = true;
+
+    if (impl == "unbatched") {
+        for (int i = 0; i < messages; ++i) {
+            msg.vehicleId = i;
+            msg.sentAtNs = benchNowNs();
+            TrafficController::sendMessage(fds[1], msg);
+        }
+    } else {
+        ControllerChannel channel(-1, fds[1]);
+        for (int i = 0; i < messages; ++i) {
+            msg.vehicleId = i;
+            channel.send(msg);
+        }
+        channel.flush();
+    }
+    close(fds[1]);
+    waitpid(pid, nullptr, 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int messages = argc > 1 ? atoi(argv[1]) : 200000;
+    run("unbatched", messages);
+    run("channel", messages);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+
+#include "BenchUtil.h"
+#include "VehileLane.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Microbenchmark for VehicleLane: heap-backed lane vs the original
+// fixed-array lane that bubble-sorted on every push.
+//
+// Build: g++ -O2 -I. -o lane_bench bench/lane_bench.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+
+namespace {
+
+// The pre-heap implementation, kept verbatim (minus printing) as a baseline.
+class LegacyVehicleLane {
+public:
+    static const int MAX_CAPACITY = 100;
+
+private:
+    Vehicle* vehicles[MAX_CAPACITY];
+    int count = 0;
+
+    void reorder() {
+        for (int i = 0; i < count - 1; ++i) {
+            for (int j = 0; j < count - i - 1; ++j) {
+                Vehicle* v1 = vehicles[j];
+                Vehicle* v2 = vehicles[j + 1];
+                if (v1->getPriority() > v2->getPriority() ||
+                    (v1->getPriority() == v2->getPriority() &&
+                     v1->getArrivalTime() > v2->getArrivalTime())) {
+                    vehicles[j] = v2;
+                    vehicles[j + 1] = v1;
+                }
+            }
+        }
+    }
+
+public:
+    bool push(Vehicle* v) {
+        if (count >= MAX_CAPACITY) return false;
+        vehicles[count++] = v;
+        reorder();
+        return true;
+    }
+
+    Vehicle* front() const { return count ? vehicles[0] : nullptr; }
+
+    void pop() {
+        if (count == 0) return;
+        for (int i = 1; i < count; ++i) vehicles[i - 1] = vehicles[i];
+        --count;
+    }
+};
+
+vector<Vehicle*> makeVehicles(size_t n, unsigned seed) {
+    static const char* types[] = {"car", "car", "car", "bike", "bus", "tractor", "ambulance", "firetruck"};
+    mt19937 rng(seed);
+    uniform_int_distribution<int> typeDist(0, 7);
+    uniform_int_distribution<int> arrDist(0, 86400);
+
+    vector<Vehicle*> out;
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        out.push_back(VehicleStore::create(static_cast<int>(i), types[typeDist(rng)], "F10", "F11", arrDist(rng)));
+    }
+    return out;
+}
+
+template <typename Lane>
+void runFillDrain(const string &impl, const vector<Vehicle*> &vehicles) {
+    Lane lane;
+    size_t n = vehicles.size();
+
+    uint64_t t0 = benchNowNs();
+    for (Vehicle* v : vehicles) lane.push(v);
+    uint64_t t1 = benchNowNs();
+
+    // Check the ordering contract while draining.
+    bool ordered = true;
+    Vehicle* prev = nullptr;
+    uint64_t t2 = benchNowNs();
+    for (size_t i = 0; i < n; ++i) {
+        Vehicle* v = lane.front();
+        if (prev && (prev->getPriority() > v->getPriority() ||
+                     (prev->getPriority() == v->getPriority() &&
+                      prev->getArrivalTime() > v->getArrivalTime()))) {
+            ordered = false;
+        }
+        prev = v;
+        lane.pop();
+    }
+    uint64_t t3 = benchNowNs();
+
+    BenchResult("lane_fill_drain")
+        .add("impl", impl)
+        .add("n", n)
+        .add("push_ns", static_cast<double>(t1 - t0) / n)
+        .add("pop_ns", static_cast<double>(t3 - t2) / n)
+        .add("ordered", ordered ? "yes" : "no");
+}
+
+} // namespace
+
+int main() {
+    const size_t sizes[] = {100, 10000, 1000000};
+
+    for (size_t n : sizes) {
+        vector<Vehicle*> vehicles = makeVehicles(n, 42);
+
+        runFillDrain<VehicleLane>("heap", vehicles);
+        if (n <= static_cast<size_t>(LegacyVehicleLane::MAX_CAPACITY)) {
+            runFillDrain<LegacyVehicleLane>("legacy", vehicles);
+        } else {
+            BenchResult("lane_fill_drain").add("impl", "legacy").add("n", n)
+                .add("skipped", "capacity_100");
+        }
+
+        for (Vehicle* v : vehicles) VehicleStore::destroy(v);
+    }
+    return 0;
+}
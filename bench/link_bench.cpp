@@ -0,0 +1,89 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "RoadNetwork.h"
+#include "NetworkSimulation.h"
+
+using namespace std;
+
+// Vehicles travelling over links. Each grid runs one hour of Poisson
+// traffic with random destinations under the actuated policy, once with
+// roomy links (20 vehicles) and once with links that hold 8, where queues
+// spill back into upstream intersections until the grid locks up. Reports
+// network-wide trips per hour, mean trip time and hops, hand-offs and the
+// releases held back by a full link (spillback). Every run is repeated on
+// one worker and must come out the same, since occupancy and hand-offs only
+// change between windows.
+//
+// Build: g++ -O2 -I. -o link_bench bench/link_bench.cpp NetworkSimulation.cpp ParkingGuide.cpp RoadNetwork.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./link_bench [workers=cores]
+
+namespace {
+
+struct LinkRun {
+    long crossings;
+    long handoffs;
+    long trips;
+    long holds;
+    double tripSeconds;
+    double hops;
+    double wall;
+};
+
+LinkRun runGrid(int rows, int cols, int capacity, long duration, int workers) {
+    RoadNetwork network = RoadNetwork::grid(rows, cols, 30, capacity);
+    NetworkSimulation sim(network);
+    sim.setPhasePolicy("actuated");
+    sim.generateTraffic(duration, 60.0, 42);
+
+    uint64_t t0 = benchNowNs();
+    sim.run(duration, workers);
+    uint64_t t1 = benchNowNs();
+    return LinkRun{sim.crossings(), sim.handoffs(), sim.tripsCompleted(), sim.spillbackHolds(),
+                   sim.meanTripSeconds(), sim.meanTripHops(), (t1 - t0) / 1e9};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int workers = argc > 1 ? atoi(argv[1]) : 0;
+    const long DURATION = 3600;
+    const int grids[][2] = {{2, 5}, {10, 10}};
+    const int capacities[] = {20, 8};
+
+    // Controller and vehicle logs would dominate the measurement.
+    Log::setMode(LogMode::OFF);
+    bool same = true;
+    for (const auto &g : grids) {
+        for (int capacity : capacities) {
+            streambuf* out = cout.rdbuf(nullptr);
+            LinkRun r = runGrid(g[0], g[1], capacity, DURATION, workers);
+            LinkRun serial = runGrid(g[0], g[1], capacity, DURATION, 1);
+            cout.rdbuf(out);
+
+            bool match = r.crossings == serial.crossings && r.handoffs == serial.handoffs &&
+                         r.trips == serial.trips && r.holds == serial.holds;
+            same = same && match;
+            BenchResult("link_grid")
+                .add("intersections", g[0] * g[1])
+                .add("link_capacity", capacity)
+                .add("crossings", r.crossings)
+                .add("handoffs", r.handoffs)
+                .add("trips", r.trips)
+                .add("trips_per_hour", r.trips * 3600.0 / DURATION)
+                .add("mean_trip_s", r.tripSeconds)
+                .add("mean_hops", r.hops)
+                .add("spillback_holds", r.holds)
+                .add("wall_s", r.wall)
+                .add("same_as_one_worker", match ? 1 : 0);
+        }
+    }
+    if (!same) {
+        cerr << "link_bench: runs differ between worker counts" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+#include <pthread.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Scenario.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "ParkingLot.h"
+
+using namespace std;
+
+// Simulation throughput with logging off, asynchronous and synchronous
+// (format and flush per event, as the simulator used to), with output going
+// to /dev/null. Also raw records/sec from 1-16 threads logging at once.
+//
+// Build: g++ -O2 -I. -o log_bench bench/log_bench.cpp Log.cpp Metrics.cpp Scenario.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp ArrivalQueue.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./log_bench [vehicles=200000]
+
+static const char* modeName(LogMode mode) {
+    switch (mode) {
+    case LogMode::OFF:   return "off";
+    case LogMode::ASYNC: return "async";
+    case LogMode::SYNC:  return "sync";
+    }
+    return "?";
+}
+
+static void runSimulation(LogMode mode, const string &trace, unsigned long vehicles, streambuf* sink) {
+    streambuf* out = cout.rdbuf(sink);
+    Log::setMode(mode);
+    unsigned long before = Log::written();
+    double wall;
+    {
+        ParkingLot lot("F10", 10, 15);
+        Intersection intersection(&lot);
+        VehicleHooks hooks;
+        hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+            intersection.addVehicle(veh->getApproach(), veh);
+        };
+        TrafficController controller(&intersection, 5);
+        EventSimulator sim(intersection, controller, &lot);
+
+        ScenarioReader reader;
+        reader.open(trace);
+        ScenarioFeed feed(reader, "F10");
+        feed.setVehicleSetup([&hooks](Vehicle* v) { v->setHooks(&hooks); });
+        sim.setSource(&feed);
+
+        uint64_t t0 = benchNowNs();
+        sim.run();
+        Log::flush();
+        wall = (benchNowNs() - t0) / 1e9;
+    }
+    Log::setMode(LogMode::SYNC);
+    cout.rdbuf(out);
+
+    BenchResult("log_simulation")
+        .add("mode", modeName(mode))
+        .add("vehicles", vehicles)
+        .add("records", Log::written() - before)
+        .add("wall_s", wall)
+        .add("vehicles_per_s", vehicles / wall);
+}
+
+struct LoggerArgs {
+    int records;
+    Vehicle* vehicle;
+};
+
+static void* loggerThread(void* arg) {
+    LoggerArgs* a = static_cast<LoggerArgs*>(arg);
+    static const string lot = "F10";
+    for (int i = 0; i < a->records; ++i) {
+        LOG_EVENT(INFO, LogEvent::SPOT_ACQUIRED, a->vehicle, lot);
+    }
+    return nullptr;
+}
+
+static void runThreads(LogMode mode, int threads, int recordsPerThread, streambuf* sink) {
+    streambuf* out = cout.rdbuf(sink);
+    Log::setMode(mode);
+    unsigned long stallsBefore = Log::stalls();
+
+    vector<Vehicle*> vehicles;
+    vector<LoggerArgs> args(threads);
+    vector<pthread_t> tids(threads);
+    for (int i = 0; i < threads; ++i) {
+        vehicles.push_back(VehicleStore::create(i, "car", "F10", "F11", 0));
+        args[i] = LoggerArgs{recordsPerThread, vehicles.back()};
+    }
+
+    uint64_t t0 = benchNowNs();
+    for (int i = 0; i < threads; ++i) {
+        pthread_create(&tids[i], nullptr, loggerThread, &args[i]);
+    }
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(tids[i], nullptr);
+    }
+    uint64_t tLogged = benchNowNs();
+    Log::flush();
+    uint64_t tWritten = benchNowNs();
+    Log::setMode(LogMode::SYNC);
+    cout.rdbuf(out);
+
+    double total = static_cast<double>(threads) * recordsPerThread;
+    BenchResult("log_threads")
+        .add("mode", modeName(mode))
+        .add("threads", threads)
+        .add("records", static_cast<unsigned long>(total))
+        .add("caller_ns_per_record", (tLogged - t0) / total)
+        .add("records_per_s", total / ((tWritten - t0) / 1e9))
+        .add("stalls", Log::stalls() - stallsBefore);
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long target = argc > 1 ? atol(argv[1]) : 200000;
+
+    TraceOptions options;
+    options.origins = {"F10"};
+    options.vehiclesPerHour = 100;
+    options.duration = target * 3600 / (4 * 100);
+    string tracePath = "/tmp/log_bench_trace.csv";
+    unsigned long vehicles;
+    {
+        ofstream out(tracePath);
+        vehicles = writeSyntheticTrace(out, options);
+    }
+
+    // Logs go to /dev/null so the terminal is not part of the measurement.
+    ofstream devnull("/dev/null");
+
+    LogMode modes[] = {LogMode::OFF, LogMode::ASYNC, LogMode::SYNC};
+    for (LogMode mode : modes) {
+        runSimulation(mode, tracePath, vehicles, devnull.rdbuf());
+    }
+    for (int threads : {1, 4, 16}) {
+        for (LogMode mode : modes) {
+            runThreads(mode, threads, 200000 / threads, devnull.rdbuf());
+        }
+    }
+
+    remove(tracePath.c_str());
+    return 0;
+}
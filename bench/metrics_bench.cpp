@@ -0,0 +1,202 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+
+#include <pthread.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Scenario.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "Vehicle.h"
+#include "ParkingLot.h"
+
+using namespace std;
+
+// Cost of the metrics subsystem: discrete-event throughput with metrics off
+// and on (checking the crossing counter and wait histograms against the
+// controller), ns per counter and histogram record from 1-16 threads
+// against one shared atomic counter, and the cost of a snapshot plus
+// rendering it as JSON and Prometheus text.
+//
+// Build: g++ -O2 -I. -o metrics_bench bench/metrics_bench.cpp Log.cpp Metrics.cpp Scenario.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp ArrivalQueue.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./metrics_bench [vehicles=200000]
+
+namespace {
+
+bool runSimulation(bool metrics, const string &trace, unsigned long vehicles) {
+    Metrics::reset();
+    Metrics::setEnabled(metrics);
+    double wall;
+    int crossed;
+    {
+        ParkingLot lot("F10", 10, 15);
+        Intersection intersection(&lot);
+        VehicleHooks hooks;
+        hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+            intersection.addVehicle(veh->getApproach(), veh);
+        };
+        TrafficController controller(&intersection, 5);
+        EventSimulator sim(intersection, controller, &lot);
+
+        ScenarioReader reader;
+        reader.open(trace);
+        ScenarioFeed feed(reader, "F10");
+        feed.setVehicleSetup([&hooks](Vehicle* v) { v->setHooks(&hooks); });
+        sim.setSource(&feed);
+
+        uint64_t t0 = benchNowNs();
+        sim.run();
+        wall = (benchNowNs() - t0) / 1e9;
+        crossed = controller.getCrossedCount();
+    }
+    Metrics::setEnabled(false);
+
+    MetricsSnapshot* s = new MetricsSnapshot;
+    Metrics::snapshot(*s);
+    uint64_t waits = 0;
+    for (int t = static_cast<int>(MetricHistogram::WAIT_CAR); t <= static_cast<int>(MetricHistogram::WAIT_OTHER); ++t) {
+        waits += s->histograms[t].count;
+    }
+    const HistogramSnapshot &car = s->histogram(MetricHistogram::WAIT_CAR);
+    BenchResult("metrics_simulation")
+        .add("metrics", metrics ? "on" : "off")
+        .add("vehicles", vehicles)
+        .add("crossings", crossed)
+        .add("counted_crossings", s->counter(MetricCounter::VEHICLES_CROSSED))
+        .add("wait_samples", waits)
+        .add("car_wait_p50_ms", car.quantile(0.5))
+        .add("car_wait_p99_ms", car.quantile(0.99))
+        .add("wall_s", wall)
+        .add("vehicles_per_s", vehicles / wall);
+
+    bool ok = !metrics || (s->counter(MetricCounter::VEHICLES_CROSSED) == static_cast<uint64_t>(crossed) &&
+                           waits == static_cast<uint64_t>(crossed));
+    delete s;
+    return ok;
+}
+
+atomic<uint64_t> shared(0);
+
+struct RecorderArgs {
+    int records;
+    int kind; // 0: Metrics::count, 1: Metrics::record, 2: shared fetch_add
+};
+
+void* recorderThread(void* arg) {
+    RecorderArgs* a = static_cast<RecorderArgs*>(arg);
+    for (int i = 0; i < a->records; ++i) {
+        if (a->kind == 0) {
+            Metrics::count(MetricCounter::VEHICLES_CROSSED);
+        } else if (a->kind == 1) {
+            Metrics::record(MetricHistogram::WAIT_CAR, static_cast<uint64_t>(i) & 0xffff);
+        } else {
+            shared.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    return nullptr;
+}
+
+void runThreads(int kind, int threads, int recordsPerThread) {
+    static const char* names[] = {"counter", "histogram", "shared_atomic"};
+    Metrics::reset();
+    Metrics::setEnabled(true);
+
+    vector<RecorderArgs> args(threads, RecorderArgs{recordsPerThread, kind});
+    vector<pthread_t> tids(threads);
+    uint64_t t0 = benchNowNs();
+    for (int i = 0; i < threads; ++i) {
+        pthread_create(&tids[i], nullptr, recorderThread, &args[i]);
+    }
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(tids[i], nullptr);
+    }
+    uint64_t t1 = benchNowNs();
+    Metrics::setEnabled(false);
+
+    MetricsSnapshot* s = new MetricsSnapshot;
+    Metrics::snapshot(*s);
+    uint64_t total = static_cast<uint64_t>(threads) * recordsPerThread;
+    uint64_t seen = kind == 0 ? s->counter(MetricCounter::VEHICLES_CROSSED)
+                  : kind == 1 ? s->histogram(MetricHistogram::WAIT_CAR).count
+                  : shared.exchange(0);
+    delete s;
+
+    BenchResult("metrics_threads")
+        .add("impl", names[kind])
+        .add("threads", threads)
+        .add("records", total)
+        .add("ns_per_record", static_cast<double>(t1 - t0) / total)
+        .add("lost", total - seen);
+}
+
+void runExport() {
+    MetricsSnapshot* s = new MetricsSnapshot;
+    const int rounds = 200;
+    string json, prom;
+    uint64_t t0 = benchNowNs();
+    for (int i = 0; i < rounds; ++i) {
+        Metrics::snapshot(*s);
+        json.clear();
+        Metrics::render(*s, MetricsFormat::JSON, json);
+    }
+    uint64_t t1 = benchNowNs();
+    for (int i = 0; i < rounds; ++i) {
+        Metrics::snapshot(*s);
+        prom.clear();
+        Metrics::render(*s, MetricsFormat::PROMETHEUS, prom);
+    }
+    uint64_t t2 = benchNowNs();
+    delete s;
+
+    BenchResult("metrics_export")
+        .add("format", "json")
+        .add("us_per_snapshot", (t1 - t0) / 1e3 / rounds)
+        .add("bytes", json.size());
+    BenchResult("metrics_export")
+        .add("format", "prometheus")
+        .add("us_per_snapshot", (t2 - t1) / 1e3 / rounds)
+        .add("bytes", prom.size());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long target = argc > 1 ? atol(argv[1]) : 200000;
+    Log::setMode(LogMode::OFF);
+
+    TraceOptions options;
+    options.origins = {"F10"};
+    options.vehiclesPerHour = 100;
+    options.duration = target * 3600 / (4 * 100);
+    string tracePath = "/tmp/metrics_bench_trace.csv";
+    unsigned long vehicles;
+    {
+        ofstream out(tracePath);
+        vehicles = writeSyntheticTrace(out, options);
+    }
+
+    bool ok = runSimulation(false, tracePath, vehicles);
+    ok = runSimulation(true, tracePath, vehicles) && ok;
+    remove(tracePath.c_str());
+
+    for (int threads : {1, 4, 16}) {
+        for (int kind = 0; kind < 3; ++kind) {
+            runThreads(kind, threads, 2000000 / threads);
+        }
+    }
+    runExport();
+
+    if (!ok) {
+        cerr << "metrics_bench: counted crossings or waits disagree with the controller" << endl;
+        return 1;
+    }
+    return 0;
+}
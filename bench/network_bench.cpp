@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "RoadNetwork.h"
+#include "NetworkSimulation.h"
+
+using namespace std;
+
+// Network throughput as the grid grows from 2 to 1,000 intersections. Each
+// run simulates one hour of Poisson traffic on every approach and reports
+// wall time, crossings per wall second and routed message hops. A last run
+// floods a 4 x 4 grid (a car every 0.2 s per approach) so node lots fill
+// up, and fails unless vehicles finding no spot are redirected elsewhere.
+//
+// Build: g++ -O2 -I. -o network_bench bench/network_bench.cpp NetworkSimulation.cpp ParkingGuide.cpp RoadNetwork.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./network_bench [workers=cores]
+
+int main(int argc, char* argv[]) {
+    int workers = argc > 1 ? atoi(argv[1]) : 0;
+    const long DURATION = 3600;
+    const int grids[][2] = {{1, 2}, {2, 5}, {10, 10}, {25, 40}};
+
+    for (const auto &g : grids) {
+        RoadNetwork network = RoadNetwork::grid(g[0], g[1]);
+
+        // Controller and vehicle logs would dominate the measurement.
+        Log::setMode(LogMode::OFF);
+        streambuf* out = cout.rdbuf(nullptr);
+        NetworkSimulation sim(network);
+        sim.generateTraffic(DURATION, 60.0, 42);
+
+        uint64_t t0 = benchNowNs();
+        sim.run(DURATION, workers);
+        uint64_t t1 = benchNowNs();
+        cout.rdbuf(out);
+
+        double wall = (t1 - t0) / 1e9;
+        BenchResult("network_grid")
+            .add("intersections", network.nodeCount())
+            .add("links", network.linkCount())
+            .add("vehicles", sim.vehicleCount())
+            .add("crossings", sim.crossings())
+            .add("message_hops", sim.messagesForwarded())
+            .add("messages_delivered", sim.messagesDelivered())
+            .add("wall_s", wall)
+            .add("crossings_per_s", sim.crossings() / wall);
+    }
+
+    RoadNetwork network = RoadNetwork::grid(4, 4);
+    streambuf* out = cout.rdbuf(nullptr);
+    NetworkSimulation sim(network);
+    sim.generateTraffic(600, 0.2, 42);
+    sim.run(600, workers);
+    cout.rdbuf(out);
+    BenchResult("network_parking_load")
+        .add("intersections", network.nodeCount())
+        .add("vehicles", sim.vehicleCount())
+        .add("parking_redirects", sim.parkingRedirects());
+    if (sim.parkingRedirects() == 0) {
+        cerr << "network_bench: full lots redirected no vehicles" << endl;
+        return 1;
+    }
+    return 0;
+}
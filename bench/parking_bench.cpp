@@ -0,0 +1,161 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <semaphore.h>
+#include <pthread.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "ParkingLot.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Parking contention: 1-64 threads each run reserve -> acquire spot ->
+// leave (or give the slot back) as fast as they can on one lot of 10 spots
+// and 15 waiting slots. Compares the atomic-counter ParkingLot against the
+// original pair of POSIX semaphores. Reports operations/sec and how the
+// attempts ended, which must add up either way.
+//
+// Build: g++ -O2 -I. -o parking_bench bench/parking_bench.cpp ParkingLot.cpp Vehicle.cpp VehicleStore.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./parking_bench [attempts_per_thread=200000]
+
+namespace {
+
+// The original ParkingLot without its logging: sem_trywait on both areas.
+class SemaphoreLot {
+    sem_t parking_spots;
+    sem_t waiting_spots;
+
+public:
+    SemaphoreLot(int parking, int waiting) {
+        sem_init(&parking_spots, 0, parking);
+        sem_init(&waiting_spots, 0, waiting);
+    }
+    ~SemaphoreLot() {
+        sem_destroy(&parking_spots);
+        sem_destroy(&waiting_spots);
+    }
+    bool tryReserveWaitingSlot(Vehicle* v) {
+        if (v->isEmergency() || !v->canPark()) {
+            return false;
+        }
+        return sem_trywait(&waiting_spots) == 0;
+    }
+    bool aquireParkingSpot(Vehicle*) {
+        if (sem_trywait(&parking_spots) != 0) {
+            return false;
+        }
+        sem_post(&waiting_spots);
+        return true;
+    }
+    void releaseWaitingSlot(Vehicle*) { sem_post(&waiting_spots); }
+    void leaveParking(Vehicle*) { sem_post(&parking_spots); }
+};
+
+struct Outcomes {
+    long parked = 0;
+    long turnedAway = 0;
+    long gaveUp = 0;
+};
+
+template <typename Lot>
+struct Worker {
+    Lot* lot;
+    Vehicle* vehicle;
+    int attempts;
+    atomic<bool>* go;
+    Outcomes out;
+};
+
+template <typename Lot>
+void* runWorker(void* arg) {
+    Worker<Lot>* w = static_cast<Worker<Lot>*>(arg);
+    while (!w->go->load()) {
+    }
+    for (int i = 0; i < w->attempts; ++i) {
+        if (!w->lot->tryReserveWaitingSlot(w->vehicle)) {
+            ++w->out.turnedAway;
+        } else if (w->lot->aquireParkingSpot(w->vehicle)) {
+            ++w->out.parked;
+            w->lot->leaveParking(w->vehicle);
+        } else {
+            ++w->out.gaveUp;
+            w->lot->releaseWaitingSlot(w->vehicle);
+        }
+    }
+    return nullptr;
+}
+
+template <typename Lot>
+void run(const char* impl, Lot &lot, int threads, int attempts) {
+    atomic<bool> go(false);
+    vector<Vehicle*> vehicles;
+    vector<Worker<Lot>> workers(threads);
+    vector<pthread_t> tids(threads);
+    for (int t = 0; t < threads; ++t) {
+        vehicles.push_back(VehicleStore::create(t, "car", "F10", "F11", 0));
+        workers[t].lot = &lot;
+        workers[t].vehicle = vehicles.back();
+        workers[t].attempts = attempts;
+        workers[t].go = &go;
+        pthread_create(&tids[t], nullptr, runWorker<Lot>, &workers[t]);
+    }
+
+    uint64_t t0 = benchNowNs();
+    go = true;
+    for (pthread_t tid : tids) {
+        pthread_join(tid, nullptr);
+    }
+    double wall = (benchNowNs() - t0) / 1e9;
+
+    Outcomes total;
+    for (const Worker<Lot> &w : workers) {
+        total.parked += w.out.parked;
+        total.turnedAway += w.out.turnedAway;
+        total.gaveUp += w.out.gaveUp;
+    }
+    double ops = static_cast<double>(threads) * attempts;
+
+    BenchResult("parking")
+        .add("impl", impl)
+        .add("threads", threads)
+        .add("attempts", static_cast<long>(ops))
+        .add("attempts_per_s", ops / wall)
+        .add("parked", total.parked)
+        .add("turned_away", total.turnedAway)
+        .add("gave_up", total.gaveUp);
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int attempts = argc > 1 ? atoi(argv[1]) : 200000;
+    Log::setMode(LogMode::OFF);
+
+    for (int threads : {1, 4, 16, 64}) {
+        int perThread = attempts / threads > 0 ? attempts / threads : 1;
+        {
+            SemaphoreLot lot(10, 15);
+            run("semaphore", lot, threads, perThread);
+        }
+        {
+            ParkingLot lot("F10", 10, 15);
+            run("atomic", lot, threads, perThread);
+            ParkingStats s = lot.stats();
+            if (s.parked != 0 || s.waiting != 0 ||
+                s.reservations != s.spotsAcquired + s.spotMisses || s.departures != s.spotsAcquired) {
+                cerr << "parking_bench: atomic lot counters do not balance" << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <pthread.h>
+#include <time.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "ParkingLot.h"
+#include "ParkingGuide.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Nearest-free-lot queries on 10, 1k and 100k lots scattered at about one
+// lot per 500 m block, with half the lots full and another thread filling
+// and emptying lots throughout. Compares the ParkingGuide grid against a
+// scan of every lot, checks both agree once churn stops, then sends
+// vehicles to full lots and reports how many the guide redirects.
+//
+// Build: g++ -O2 -I. -o parking_guide_bench bench/parking_guide_bench.cpp ParkingGuide.cpp ParkingLot.cpp Vehicle.cpp VehicleStore.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./parking_guide_bench [queries=200000]
+
+namespace {
+
+const double BLOCK = 500.0;
+const int WAITING = 15;
+
+struct Site {
+    unique_ptr<ParkingLot> lot;
+    double x;
+    double y;
+};
+
+// The obvious index: look at every lot.
+int scanNearest(const vector<Site> &sites, double x, double y) {
+    int best = -1;
+    double bestD2 = 0;
+    for (size_t i = 0; i < sites.size(); ++i) {
+        double dx = sites[i].x - x, dy = sites[i].y - y;
+        double d2 = dx * dx + dy * dy;
+        if ((best < 0 || d2 < bestD2) && sites[i].lot->hasRoom()) {
+            best = static_cast<int>(i);
+            bestD2 = d2;
+        }
+    }
+    return best;
+}
+
+// CPU time of the calling thread; on a machine with fewer cores than
+// threads, wall time also counts the churn thread's turns.
+uint64_t threadCpuNs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+double distanceTo(const vector<Site> &sites, int i, double x, double y) {
+    return hypot(sites[i].x - x, sites[i].y - y);
+}
+
+struct Churn {
+    vector<Site>* sites;
+    Vehicle* vehicle;
+    atomic<bool> stop;
+    long changes;
+};
+
+// Fill a random lot to the brim or empty it, over and over.
+void* runChurn(void* arg) {
+    Churn* c = static_cast<Churn*>(arg);
+    mt19937 rng(7);
+    uniform_int_distribution<size_t> pick(0, c->sites->size() - 1);
+    while (!c->stop.load(memory_order_relaxed)) {
+        ParkingLot &lot = *(*c->sites)[pick(rng)].lot;
+        if (lot.freeWaitingSlots() > 0) {
+            while (lot.tryReserveWaitingSlot(c->vehicle)) {
+                ++c->changes;
+            }
+        } else {
+            for (int i = 0; i < WAITING; ++i) {
+                lot.releaseWaitingSlot(c->vehicle);
+                ++c->changes;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void run(int lotCount, int queries) {
+    double side = sqrt(static_cast<double>(lotCount)) * BLOCK;
+    mt19937 rng(42);
+    uniform_real_distribution<double> coord(0, side);
+    Vehicle &filler = *VehicleStore::create(0, "car", "bench", "bench", 0);
+
+    vector<Site> sites;
+    ParkingGuide guide(BLOCK);
+    for (int i = 0; i < lotCount; ++i) {
+        Site s{unique_ptr<ParkingLot>(new ParkingLot("L" + to_string(i), 10, WAITING)), coord(rng), coord(rng)};
+        if (i % 2 == 0) {
+            while (s.lot->tryReserveWaitingSlot(&filler)) {
+            }
+        }
+        guide.addLot(s.lot.get(), s.x, s.y);
+        sites.push_back(move(s));
+    }
+
+    vector<pair<double, double>> points(queries);
+    for (auto &p : points) {
+        p = make_pair(coord(rng), coord(rng));
+    }
+
+    Churn churn;
+    churn.sites = &sites;
+    churn.vehicle = &filler;
+    churn.stop = false;
+    churn.changes = 0;
+    pthread_t tid;
+    pthread_create(&tid, nullptr, runChurn, &churn);
+
+    long found = 0;
+    uint64_t t0 = benchNowNs(), c0 = threadCpuNs();
+    for (const auto &p : points) {
+        found += guide.nearest(p.first, p.second, ParkingGuide::CAR) >= 0;
+    }
+    double guideNs = static_cast<double>(benchNowNs() - t0) / queries;
+    double guideCpuNs = static_cast<double>(threadCpuNs() - c0) / queries;
+
+    // A full scan is O(lots); keep its total work bounded.
+    int scanQueries = max(100, min(queries, 20000000 / lotCount));
+    t0 = benchNowNs();
+    c0 = threadCpuNs();
+    for (int i = 0; i < scanQueries; ++i) {
+        found += scanNearest(sites, points[i].first, points[i].second) >= 0;
+    }
+    double scanNs = static_cast<double>(benchNowNs() - t0) / scanQueries;
+    double scanCpuNs = static_cast<double>(threadCpuNs() - c0) / scanQueries;
+
+    churn.stop = true;
+    pthread_join(tid, nullptr);
+
+    // With occupancy still, both must pick a lot at the same distance.
+    int checks = min(queries, 2000), mismatches = 0;
+    for (int i = 0; i < checks; ++i) {
+        double x = points[i].first, y = points[i].second;
+        int g = guide.nearest(x, y, ParkingGuide::CAR), s = scanNearest(sites, x, y);
+        if ((g < 0) != (s < 0) || (g >= 0 && distanceTo(sites, g, x, y) != distanceTo(sites, s, x, y))) {
+            ++mismatches;
+        }
+    }
+
+    BenchResult("parking_guide")
+        .add("lots", lotCount)
+        .add("impl", "grid")
+        .add("queries", queries)
+        .add("ns_per_query", guideNs)
+        .add("cpu_ns_per_query", guideCpuNs)
+        .add("queries_per_s", 1e9 / guideNs)
+        .add("churn_changes", churn.changes)
+        .add("mismatches", mismatches);
+    BenchResult("parking_guide")
+        .add("lots", lotCount)
+        .add("impl", "scan")
+        .add("queries", scanQueries)
+        .add("ns_per_query", scanNs)
+        .add("cpu_ns_per_query", scanCpuNs)
+        .add("queries_per_s", 1e9 / scanNs);
+
+    // Redirect: vehicles arrive at full lots and take the nearest slot.
+    vector<int> fullLots;
+    for (int i = 0; i < lotCount; ++i) {
+        if (sites[i].lot->freeWaitingSlots() == 0) {
+            fullLots.push_back(i);
+        }
+    }
+    int arrivals = min(queries, lotCount * WAITING / 4);
+    vector<Vehicle*> vehicles;
+    vector<int> from;
+    uniform_int_distribution<size_t> pickFull(0, fullLots.empty() ? 0 : fullLots.size() - 1);
+    for (int i = 0; i < arrivals && !fullLots.empty(); ++i) {
+        vehicles.push_back(VehicleStore::create(i + 1, "car", "bench", "bench", 0));
+        from.push_back(fullLots[pickFull(rng)]);
+    }
+    t0 = benchNowNs();
+    for (size_t i = 0; i < vehicles.size(); ++i) {
+        guide.reserve(vehicles[i], sites[from[i]].x, sites[from[i]].y);
+    }
+    double redirectNs = vehicles.empty() ? 0 : static_cast<double>(benchNowNs() - t0) / vehicles.size();
+
+    unordered_map<ParkingLot*, int> indexOf;
+    for (int i = 0; i < lotCount; ++i) {
+        indexOf[sites[i].lot.get()] = i;
+    }
+    long redirected = 0;
+    double detour = 0;
+    for (size_t i = 0; i < vehicles.size(); ++i) {
+        ParkingLot* lot = vehicles[i]->getReservedLot();
+        if (lot) {
+            ++redirected;
+            detour += distanceTo(sites, indexOf[lot], sites[from[i]].x, sites[from[i]].y);
+        }
+    }
+
+    BenchResult("parking_guide_redirect")
+        .add("lots", lotCount)
+        .add("turned_away", vehicles.size())
+        .add("redirected", redirected)
+        .add("mean_detour_m", redirected ? detour / redirected : 0)
+        .add("ns_per_arrival", redirectNs);
+
+    for (Vehicle* v : vehicles) {
+        ParkingLot* lot = v->getReservedLot();
+        if (lot) {
+            v->cancelParkingReservation(*lot);
+        }
+        VehicleStore::destroy(v);
+    }
+    VehicleStore::destroy(&filler);
+
+    if (mismatches) {
+        cerr << "parking_guide_bench: grid and scan disagree on " << mismatches << " queries" << endl;
+        exit(1);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int queries = argc > 1 ? atoi(argv[1]) : 200000;
+    if (queries < 1) {
+        queries = 1;
+    }
+    Log::setMode(LogMode::OFF);
+
+    for (int lots : {10, 1000, 100000}) {
+        run(lots, queries);
+    }
+    return 0;
+}
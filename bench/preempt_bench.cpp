@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <cstdlib>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "RoadNetwork.h"
+#include "NetworkSimulation.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Emergency travel time along a corridor of intersections, with and without
+// green-wave preemption. One hour of Poisson car traffic with random
+// destinations loads a 1 x 10 chain of 30 s links (actuated control) until
+// queues spill back; ambulances enter at both ends and drive to the far
+// end, one every 600 s (one or two on the road at a time) or every 60 s
+// (a dozen at once, heading both ways). Reports their mean end-to-end trip
+// time against the free-flow 270 s, greens opened ahead of them, and the
+// mean trip time of everyone else, which pays for the preemption. Every
+// run is repeated on one worker and must come out the same.
+//
+// Build: g++ -O2 -I. -o preempt_bench bench/preempt_bench.cpp NetworkSimulation.cpp ParkingGuide.cpp RoadNetwork.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./preempt_bench [workers=cores]
+
+namespace {
+
+const int CHAIN = 10;
+const int TRAVEL = 30;
+const int CAPACITY = 10;
+const long DURATION = 3600;
+const double CAR_GAP = 45.0; // mean seconds between cars on each approach
+
+struct PreemptRun {
+    long emergencies;
+    double emergencySeconds;
+    long preemptions;
+    long trips;
+    double tripSeconds;
+    long crossings;
+    long holds;
+    double wall;
+};
+
+PreemptRun runChain(long emergencyGap, bool preemption, int workers) {
+    RoadNetwork network = RoadNetwork::grid(1, CHAIN, TRAVEL, CAPACITY);
+    NetworkSimulation sim(network);
+    sim.setPhasePolicy("actuated");
+    sim.setPreemption(preemption);
+
+    mt19937 rng(7);
+    exponential_distribution<double> gap(1.0 / CAR_GAP);
+    uniform_int_distribution<int> destDist(0, CHAIN - 1);
+    int nextId = 1;
+    // Cars come in from the side streets and the two open ends; the other
+    // approaches are fed by links only, so a lane never holds vehicles
+    // bound both ways (that can lock the chain up for good).
+    for (int node = 0; node < CHAIN; ++node) {
+        for (int lane = 0; lane < DIRECTION_COUNT; ++lane) {
+            Direction approach = directionAt(lane);
+            if ((approach == Direction::WEST && node != 0) || (approach == Direction::EAST && node != CHAIN - 1)) {
+                continue;
+            }
+            double t = 0;
+            while ((t += gap(rng)) < DURATION) {
+                Vehicle* v = VehicleStore::create(nextId++, "car", network.nodeName(node),
+                                                  network.nodeName(destDist(rng)), static_cast<int>(t));
+                sim.addVehicle(node, v, approach);
+            }
+        }
+    }
+
+    // Alternately eastbound from the first node and westbound from the last.
+    const int first = 0, last = CHAIN - 1;
+    int i = 0;
+    for (long t = 60; t < DURATION; t += emergencyGap, ++i) {
+        bool east = i % 2 == 0;
+        Vehicle* v = VehicleStore::create(nextId++, "ambulance", network.nodeName(east ? first : last),
+                                          network.nodeName(east ? last : first), static_cast<int>(t));
+        sim.addVehicle(east ? first : last, v, east ? Direction::WEST : Direction::EAST);
+    }
+
+    uint64_t t0 = benchNowNs();
+    sim.run(DURATION + 1800, workers); // time for the last ones to arrive
+    uint64_t t1 = benchNowNs();
+
+    long emergencies = sim.emergencyTripsCompleted();
+    long others = sim.tripsCompleted() - emergencies;
+    double otherSeconds = sim.meanTripSeconds() * sim.tripsCompleted() -
+                          sim.meanEmergencyTripSeconds() * emergencies;
+    return PreemptRun{emergencies, sim.meanEmergencyTripSeconds(), sim.preemptions(), others,
+                      others > 0 ? otherSeconds / others : 0, sim.crossings(), sim.spillbackHolds(),
+                      (t1 - t0) / 1e9};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int workers = argc > 1 ? atoi(argv[1]) : 0;
+    const long emergencyGaps[] = {600, 60};
+
+    // Controller and vehicle logs would dominate the measurement.
+    Log::setMode(LogMode::OFF);
+    bool same = true;
+    for (long emergencyGap : emergencyGaps) {
+        for (bool preemption : {false, true}) {
+            streambuf* out = cout.rdbuf(nullptr);
+            PreemptRun r = runChain(emergencyGap, preemption, workers);
+            PreemptRun serial = runChain(emergencyGap, preemption, 1);
+            cout.rdbuf(out);
+
+            bool match = r.crossings == serial.crossings && r.emergencies == serial.emergencies &&
+                         r.emergencySeconds == serial.emergencySeconds && r.preemptions == serial.preemptions;
+            same = same && match;
+            BenchResult("preempt_chain")
+                .add("intersections", CHAIN)
+                .add("emergency_every_s", emergencyGap)
+                .add("preemption", preemption ? "on" : "off")
+                .add("emergency_trips", r.emergencies)
+                .add("emergency_trip_s", r.emergencySeconds)
+                .add("free_flow_s", (CHAIN - 1) * TRAVEL)
+                .add("greens_ahead", r.preemptions)
+                .add("other_trips", r.trips)
+                .add("other_trip_s", r.tripSeconds)
+                .add("spillback_holds", r.holds)
+                .add("wall_s", r.wall)
+                .add("same_as_one_worker", match ? 1 : 0);
+        }
+    }
+    if (!same) {
+        cerr << "preempt_bench: runs differ between worker counts" << endl;
+        return 1;
+    }
+    return 0;
+}
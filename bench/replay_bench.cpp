@@ -0,0 +1,191 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BenchUtil.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "Scenario.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "ParkingLot.h"
+#include "Log.h"
+#include "Recording.h"
+#include "Replay.h"
+
+using namespace std;
+
+// Record and replay. A real-time controller (1 controller second = 0.1 ms)
+// serves vehicles queued by 1-8 producer threads, so which arrivals each
+// decision sees is up to the scheduler; the recording of that run is then
+// replayed and every decision must match (exit status 1 otherwise).
+// Reports trace size per record and replay decisions/sec, plus the cost of
+// recording a discrete-event run.
+//
+// Build: g++ -O2 -I. -o replay_bench bench/replay_bench.cpp Recording.cpp Columns.cpp Replay.cpp Scenario.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp ArrivalQueue.cpp Log.cpp Metrics.cpp -pthread
+// Usage: ./replay_bench [vehicles=5000]
+
+namespace {
+
+const char* RECORDING = "/tmp/replay_bench.bin";
+
+struct ProducerArgs {
+    Intersection* inter;
+    vector<Vehicle*>* vehicles;
+    int index;
+    int producers;
+};
+
+void* producer(void* arg) {
+    ProducerArgs* a = static_cast<ProducerArgs*>(arg);
+    vector<Vehicle*> &vehicles = *a->vehicles;
+    int n = 0;
+    for (size_t i = a->index; i < vehicles.size(); i += a->producers) {
+        a->inter->addVehicle(vehicles[i]->getApproach(), vehicles[i]);
+        if (++n % 16 == 0) {
+            usleep(100); // arrive in bursts, between and during decisions
+        }
+    }
+    return nullptr;
+}
+
+bool replay(const string &label, int threads, unsigned long vehicles, double recordWall) {
+    RecordingReader reader;
+    if (!reader.open(RECORDING)) {
+        return false;
+    }
+    ReplayResult r;
+    bool matched = replayRecording(reader, r);
+    BenchResult("replay")
+        .add("run", label)
+        .add("producers", threads)
+        .add("vehicles", vehicles)
+        .add("records", r.records)
+        .add("bytes", reader.fileSize())
+        .add("bytes_per_record", static_cast<double>(reader.fileSize()) / r.records)
+        .add("decisions", r.steps)
+        .add("recorded_wall_s", recordWall)
+        .add("replay_wall_s", r.wallSeconds)
+        .add("replay_decisions_per_s", r.steps / r.wallSeconds)
+        .add("mismatches", r.mismatches);
+    return matched;
+}
+
+bool runRealTime(int producers, int total) {
+    mt19937 rng(11);
+    uniform_int_distribution<int> typeDist(0, 19);
+    uniform_int_distribution<int> laneDist(0, DIRECTION_COUNT - 1);
+    static const char* types[] = {"car", "car", "car", "car", "car", "car", "car", "car", "car", "car",
+                                  "bike", "bike", "bus", "bus", "bus", "tractor", "tractor", "car", "car", "ambulance"};
+    vector<Vehicle*> vehicles;
+    for (int i = 0; i < total; ++i) {
+        Vehicle* v = VehicleStore::create(i, types[typeDist(rng)], "F10", "F10", i / 10);
+        v->setApproach(directionAt(laneDist(rng)));
+        vehicles.push_back(v);
+    }
+
+    Intersection inter;
+    TrafficController controller(&inter, 5);
+    controller.setTimeScale(0.0001);
+    Recorder::start(RECORDING);
+    Recorder::controller("F10", "fixed", "single", 5);
+
+    uint64_t t0 = benchNowNs();
+    controller.startController();
+    vector<ProducerArgs> args(producers);
+    vector<pthread_t> tids(producers);
+    for (int i = 0; i < producers; ++i) {
+        args[i] = ProducerArgs{&inter, &vehicles, i, producers};
+        pthread_create(&tids[i], nullptr, producer, &args[i]);
+    }
+    for (pthread_t tid : tids) {
+        pthread_join(tid, nullptr);
+    }
+    while (controller.getCrossedCount() < total) {
+        usleep(1000);
+    }
+    controller.stopController();
+    double wall = (benchNowNs() - t0) / 1e9;
+    Recorder::stop();
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+    return replay("realtime", producers, total, wall);
+}
+
+double runDiscreteEvent(const string &trace, bool record, int &crossed) {
+    ParkingLot lot("F10", 10, 15);
+    Intersection intersection(&lot);
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+        intersection.addVehicle(veh->getApproach(), veh);
+    };
+    TrafficController controller(&intersection, 5);
+    EventSimulator sim(intersection, controller, &lot);
+    ScenarioReader reader;
+    reader.open(trace);
+    ScenarioFeed feed(reader, "F10");
+    feed.setVehicleSetup([&hooks](Vehicle* v) { v->setHooks(&hooks); });
+    sim.setSource(&feed);
+
+    if (record) {
+        Recorder::start(RECORDING);
+        Recorder::controller("F10", "fixed", "single", 5);
+    }
+    uint64_t t0 = benchNowNs();
+    sim.run();
+    double wall = (benchNowNs() - t0) / 1e9;
+    Recorder::stop();
+    crossed = controller.getCrossedCount();
+    return wall;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int total = argc > 1 ? atoi(argv[1]) : 5000;
+    Log::setMode(LogMode::OFF);
+
+    bool ok = true;
+    for (int producers : {1, 8}) {
+        ok = runRealTime(producers, total) && ok;
+    }
+
+    TraceOptions options;
+    options.origins = {"F10"};
+    options.vehiclesPerHour = 100;
+    options.duration = 10L * total * 3600 / (4 * 100);
+    string tracePath = "/tmp/replay_bench_trace.csv";
+    unsigned long vehicles;
+    {
+        ofstream out(tracePath);
+        vehicles = writeSyntheticTrace(out, options);
+    }
+    int crossedOff, crossedOn;
+    double off = runDiscreteEvent(tracePath, false, crossedOff);
+    double on = runDiscreteEvent(tracePath, true, crossedOn);
+    remove(tracePath.c_str());
+    BenchResult("replay_record_cost")
+        .add("vehicles", vehicles)
+        .add("off_vehicles_per_s", vehicles / off)
+        .add("on_vehicles_per_s", vehicles / on)
+        .add("overhead_pct", 100.0 * (on - off) / off)
+        .add("recorded_bytes", Recorder::bytes());
+    ok = crossedOff == crossedOn && replay("des", 0, vehicles, on) && ok;
+    remove(RECORDING);
+
+    if (!ok) {
+        cerr << "replay_bench: a replay did not reproduce its recording" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Scenario.h"
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "EventSimulator.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+#include "ParkingLot.h"
+
+using namespace std;
+
+// Runs a large synthetic trace through one intersection in discrete-event
+// mode, first streamed through ScenarioFeed and then with every vehicle
+// allocated up front, and reports throughput and peak RSS of each.
+//
+// Build: g++ -O2 -I. -o scenario_bench bench/scenario_bench.cpp Scenario.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp ArrivalQueue.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./scenario_bench [vehicles=1000000]
+
+static long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static VehicleHooks laneHooks(Intersection &intersection) {
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&intersection](Vehicle* veh) {
+        intersection.addVehicle(veh->getApproach(), veh);
+    };
+    return hooks;
+}
+
+int main(int argc, char* argv[]) {
+    long target = argc > 1 ? atol(argv[1]) : 1000000;
+
+    // 100 vehicles/hour on each approach stays under the controller's
+    // capacity, so queues stay short and memory reflects the injection.
+    TraceOptions trace;
+    trace.origins = {"F10"};
+    trace.vehiclesPerHour = 100;
+    trace.duration = target * 3600 / (4 * 100);
+
+    char path[] = "/tmp/scenario_benchXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    unsigned long written;
+    {
+        ofstream out(path);
+        written = writeSyntheticTrace(out, trace);
+    }
+
+    // Event logs would dominate the measurement.
+    Log::setMode(LogMode::OFF);
+    streambuf* out = cout.rdbuf(nullptr);
+    long rssBefore = peakRssKb();
+
+    // Streamed: vehicles exist from arrival until they cross and leave parking.
+    double streamWall;
+    unsigned long streamCrossings;
+    {
+        ParkingLot lot("F10", 10, 15);
+        Intersection intersection(&lot);
+        TrafficController controller(&intersection, 5);
+        EventSimulator sim(intersection, controller, &lot);
+
+        ScenarioReader reader;
+        reader.open(path);
+        ScenarioFeed feed(reader, "F10");
+        VehicleHooks hooks = laneHooks(intersection);
+        feed.setVehicleSetup([&hooks](Vehicle* v) { v->setHooks(&hooks); });
+        sim.setSource(&feed);
+
+        uint64_t t0 = benchNowNs();
+        sim.run();
+        streamWall = (benchNowNs() - t0) / 1e9;
+        streamCrossings = controller.getCrossedCount();
+    }
+    long rssStream = peakRssKb();
+
+    // Up front: the whole trace is read into Vehicles before the run.
+    double eagerWall;
+    unsigned long eagerCrossings;
+    {
+        ParkingLot lot("F10", 10, 15);
+        Intersection intersection(&lot);
+        TrafficController controller(&intersection, 5);
+        EventSimulator sim(intersection, controller, &lot);
+
+        VehicleHooks hooks = laneHooks(intersection);
+
+        uint64_t t0 = benchNowNs();
+        ScenarioReader reader;
+        reader.open(path);
+        vector<Vehicle*> vehicles;
+        VehicleSpec spec;
+        while (reader.next(spec)) {
+            Vehicle* v = VehicleStore::create(spec.id, spec.type, spec.origin, spec.destination, spec.arrival);
+            v->setApproach(spec.approach);
+            v->setHooks(&hooks);
+            vehicles.push_back(v);
+            sim.addVehicle(v);
+        }
+        sim.run();
+        eagerWall = (benchNowNs() - t0) / 1e9;
+        eagerCrossings = controller.getCrossedCount();
+
+        for (Vehicle* v : vehicles) {
+            VehicleStore::destroy(v);
+        }
+    }
+    long rssEager = peakRssKb();
+
+    cout.rdbuf(out);
+    unlink(path);
+
+    BenchResult("scenario_streamed")
+        .add("vehicles", written)
+        .add("crossings", streamCrossings)
+        .add("wall_s", streamWall)
+        .add("vehicles_per_s", written / streamWall)
+        .add("peak_rss_growth_kb", rssStream - rssBefore);
+    BenchResult("scenario_upfront")
+        .add("vehicles", written)
+        .add("crossings", eagerCrossings)
+        .add("wall_s", eagerWall)
+        .add("vehicles_per_s", written / eagerWall)
+        .add("peak_rss_growth_kb", rssEager - rssStream);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "BenchUtil.h"
+#include "Sweep.h"
+
+using namespace std;
+
+// Sweep throughput: the same grid run with 1, 2, ... up to one worker per
+// CPU, in runs per second, checking that every job count produces the same
+// results (only the wall times may differ).
+//
+// Build: g++ -O2 -I. -o sweep_bench bench/sweep_bench.cpp Sweep.cpp Scenario.cpp Log.cpp Metrics.cpp EventSimulator.cpp Intersection.cpp TrafficController.cpp PhasePolicy.cpp PhasePlan.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp VehileLane.cpp ArrivalQueue.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./sweep_bench [seeds=4] [duration=3600]
+
+namespace {
+
+bool sameOutcome(const SweepResult &a, const SweepResult &b) {
+    return a.done && b.done && a.vehicles == b.vehicles && a.crossings == b.crossings &&
+           a.meanWait == b.meanWait && a.p95Wait == b.p95Wait && a.maxWait == b.maxWait &&
+           a.maxQueue == b.maxQueue && a.parked == b.parked &&
+           a.simSeconds == b.simSeconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SweepGrid grid;
+    grid.greenSeconds = {3, 5, 8};
+    grid.vehiclesPerHour = {120, 240};
+    grid.policies = {"fixed", "actuated", "max-pressure"};
+    grid.replicates = argc > 1 ? atoi(argv[1]) : 4;
+    grid.duration = argc > 2 ? atol(argv[2]) : 3600;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    vector<int> jobCounts{1};
+    for (int j = 2; j < cpus; j *= 2) {
+        jobCounts.push_back(j);
+    }
+    if (cpus > 1) {
+        jobCounts.push_back(static_cast<int>(cpus));
+    }
+
+    vector<SweepResult> baseline;
+    bool ok = true;
+    for (int jobs : jobCounts) {
+        vector<SweepResult> results;
+        uint64_t t0 = benchNowNs();
+        bool ran = runSweep(grid, jobs, results);
+        double wall = (benchNowNs() - t0) / 1e9;
+
+        unsigned long vehicles = 0;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            vehicles += results[i].vehicles;
+            if (!baseline.empty() && !sameOutcome(results[i], baseline[i])) {
+                ++mismatches;
+            }
+        }
+        if (baseline.empty()) {
+            baseline = results;
+        }
+        ok = ok && ran && mismatches == 0;
+
+        BenchResult("sweep")
+            .add("jobs", jobs)
+            .add("runs", results.size())
+            .add("vehicles", vehicles)
+            .add("wall_s", wall)
+            .add("runs_per_s", results.size() / wall)
+            .add("mismatches", mismatches);
+    }
+
+    if (!ok) {
+        cerr << "sweep_bench: a run failed or results depend on the job count" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "BenchUtil.h"
+#include "TrafficController.h"
+#include "ControllerChannel.h"
+#include "ShmTransport.h"
+
+using namespace std;
+
+// Round-trip latency of ControllerMessage between two processes over the
+// pipe transport (ControllerChannel) and the shared-memory transport
+// (ShmTransport). A forked child echoes every message back; the parent
+// sends at a fixed rate and times each round trip.
+//
+// Build: g++ -O2 -I. -o transport_bench bench/transport_bench.cpp ShmTransport.cpp ControllerChannel.cpp Metrics.cpp Recording.cpp Columns.cpp Vehicle.cpp VehicleStore.cpp ParkingLot.cpp Log.cpp -pthread
+
+namespace {
+
+void echoLoop(MessageTransport &t) {
+    vector<ControllerMessage> batch;
+    while (true) {
+        batch.clear();
+        int n = t.receive(batch, -1);
+        if (n < 0) break;
+        for (const ControllerMessage &msg : batch) {
+            t.send(msg);
+        }
+        t.flush();
+    }
+    t.closeSend();
+}
+
+void pingLoop(MessageTransport &t, const string &impl, long rate, int messages) {
+    vector<uint64_t> rtt;
+    rtt.reserve(messages);
+    vector<ControllerMessage> batch;
+    uint64_t interval = rate > 0 ? 1000000000ull / rate : 0;
+
+    uint64_t start = benchNowNs();
+    for (int i = 0; i < messages; ++i) {
+        // Spin to the next send slot so the rate is steady.
+        uint64_t due = start + i * interval;
+        while (benchNowNs() < due) {}
+
+        ControllerMessage msg{};
+        msg.vehicleId = i;
+        uint64_t t0 = benchNowNs();
+        t.send(msg);
+        t.flush();
+
+        batch.clear();
+        while (batch.empty()) {
+            if (t.receive(batch, -1) < 0) return;
+        }
+        rtt.push_back(benchNowNs() - t0);
+    }
+    t.closeSend();
+
+    sort(rtt.begin(), rtt.end());
+    BenchResult("transport_round_trip")
+        .add("impl", impl)
+        .add("rate_per_s", rate > 0 ? to_string(rate) : string("max"))
+        .add("messages", messages)
+        .add("rtt_p50_ns", rtt[rtt.size() / 2])
+        .add("rtt_p99_ns", rtt[static_cast<size_t>(0.99 * (rtt.size() - 1))])
+        .add("rtt_max_ns", rtt.back());
+}
+
+void run(const string &impl, long rate, int messages) {
+    int toChild[2], toParent[2];
+    if (pipe(toChild) == -1 || pipe(toParent) == -1) {
+        perror("pipe");
+        return;
+    }
+    ShmRing* down = nullptr;
+    ShmRing* up = nullptr;
+    if (impl == "shm") {
+        down = ShmRing::create(1024);
+        up = ShmRing::create(1024);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(toChild[1]);
+        close(toParent[0]);
+        if (impl == "shm") {
+            ShmTransport t(down, up);
+            echoLoop(t);
+        } else {
+            ControllerChannel t(toChild[0], toParent[1]);
+            echoLoop(t);
+        }
+        _exit(0);
+    }
+
+    close(toChild[0]);
+    close(toParent[1]);
+    if (impl == "shm") {
+        ShmTransport t(up, down);
+        pingLoop(t, impl, rate, messages);
+    } else {
+        ControllerChannel t(toParent[0], toChild[1]);
+        pingLoop(t, impl, rate, messages);
+    }
+    waitpid(pid, nullptr, 0);
+    close(toChild[1]);
+    close(toParent[0]);
+    delete down;
+    delete up;
+}
+
+} // namespace
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    const long rates[] = {1000, 10000, 100000, 0};
+    for (long rate : rates) {
+        int messages = rate == 1000 ? 1000 : 5000;
+        run("pipe", rate, messages);
+        run("shm", rate, messages);
+    }
+    return 0;
+}
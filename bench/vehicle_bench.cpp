@@ -0,0 +1,110 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "BenchUtil.h"
+#include "Log.h"
+#include "Intersection.h"
+#include "Vehicle.h"
+#include "VehicleStore.h"
+
+using namespace std;
+
+// Vehicle footprint and controller decisions at scale: creates N vehicles
+// (1M by default) of mixed types, queues them all at one intersection and
+// reports resident bytes per vehicle, creation cost, and decisions/sec with
+// the lanes that full. A decision is a snapshot of the lane heads, an
+// emergency check on each, and releasing the head of the phase's lane,
+// which is queued again behind the others so lane lengths stay constant.
+//
+// Build: g++ -O2 -I. -o vehicle_bench bench/vehicle_bench.cpp VehicleStore.cpp Intersection.cpp ArrivalQueue.cpp VehileLane.cpp Vehicle.cpp ParkingLot.cpp Log.cpp Metrics.cpp Recording.cpp Columns.cpp -pthread
+// Usage: ./vehicle_bench [vehicles=1000000] [decisions=2000000]
+
+namespace {
+
+// Current resident set in bytes.
+long residentBytes() {
+    long pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int decisions = argc > 2 ? atoi(argv[2]) : 2000000;
+    if (count < DIRECTION_COUNT) {
+        count = DIRECTION_COUNT;
+    }
+    Log::setMode(LogMode::OFF);
+
+    static const char* types[] = {"car", "car", "car", "bike", "bus", "tractor"};
+    static const char* places[] = {"F10", "F11", "F12", "F13"};
+    mt19937 rng(42);
+    uniform_int_distribution<int> typeDist(0, 5), placeDist(0, 3);
+
+    vector<Vehicle*> vehicles;
+    vehicles.reserve(count);
+    long rss0 = residentBytes();
+
+    uint64_t t0 = benchNowNs();
+    for (int i = 0; i < count; ++i) {
+        Vehicle* v = VehicleStore::create(i, types[typeDist(rng)], places[placeDist(rng)],
+                                          places[placeDist(rng)], i / DIRECTION_COUNT);
+        v->setApproach(directionAt(i % DIRECTION_COUNT));
+        vehicles.push_back(v);
+    }
+    uint64_t t1 = benchNowNs();
+    long rssCreated = residentBytes();
+
+    Intersection inter;
+    for (Vehicle* v : vehicles) {
+        inter.addVehicle(v->getApproach(), v);
+    }
+    inter.drainArrivals();
+    long rssQueued = residentBytes();
+
+    // The pointer vector is bench bookkeeping, not part of a vehicle.
+    long bookkeeping = static_cast<long>(vehicles.capacity() * sizeof(Vehicle*));
+    BenchResult("vehicle_footprint")
+        .add("vehicles", count)
+        .add("sizeof_vehicle", sizeof(Vehicle))
+        .add("bytes_per_vehicle", static_cast<double>(rssCreated - rss0 - bookkeeping) / count)
+        .add("queued_bytes_per_vehicle", static_cast<double>(rssQueued - rss0 - bookkeeping) / count)
+        .add("create_ns", static_cast<double>(t1 - t0) / count);
+
+    long emergencies = 0, released = 0;
+    t0 = benchNowNs();
+    for (int i = 0; i < decisions; ++i) {
+        LaneSnapshot snap = inter.snapshot();
+        for (Vehicle* head : snap.heads) {
+            if (head && head->isEmergency()) {
+                ++emergencies;
+            }
+        }
+        Direction phase = directionAt(i % DIRECTION_COUNT);
+        if (Vehicle* v = inter.popVehicle(phase)) {
+            ++released;
+            inter.addVehicle(phase, v);
+        }
+    }
+    t1 = benchNowNs();
+    double ns = static_cast<double>(t1 - t0) / decisions;
+    BenchResult("vehicle_decision")
+        .add("queued", count)
+        .add("decisions", decisions)
+        .add("ns_per_decision", ns)
+        .add("decisions_per_s", 1e9 / ns)
+        .add("released", released)
+        .add("emergencies", emergencies);
+
+    for (Vehicle* v : vehicles) {
+        VehicleStore::destroy(v);
+    }
+    return 0;
+}
@@ -1,293 +1,719 @@
-#include <iostream>
-#include <vector>
-#include <string>
-#include <map>
-#include <cstring>
-
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <pthread.h>
-
-#include "Intersection.h"
-#include "TrafficController.h"
-#include "Vehicle.h"
-#include "ParkingLot.h"
-
-using namespace std;
-
-struct PipeListenerArgs {
-    string controllerName;
-    int    readFd;
-};
-
-void* pipeListenerThread(void* arg)
-{
-    PipeListenerArgs* args = static_cast<PipeListenerArgs*>(arg);
-    const string& name = args->controllerName;
-    int readFd = args->readFd;
-
-    cout << "[" << name << "-Listener] Pipe listener started." << endl;
-
-    ControllerMessage msg{};
-    while (true) {
-        if (!TrafficController::receiveMessage(readFd, msg)) {
-            break;
-        }
-
-        cout << "[" << name << "-Listener] Received message for vehicle "
-             << msg.vehicleId
-             << " (type=" << msg.type << ", emergency=" << (msg.isEmergency ? "yes" : "no")
-             << ") from " << msg.origin << " to " << msg.destination
-             << " via approach " << msg.approach
-             << " movement " << msg.movement << endl;
-
-        if (msg.isEmergency) {
-            cout << "[" << name << "-Listener] Preparing for incoming emergency vehicle "
-                 << msg.vehicleId << "." << endl;
-        }
-    }
-
-    cout << "[" << name << "-Listener] Pipe listener exiting." << endl;
-    delete args;
-    return nullptr;
-}
-
-
-void createVehiclesForF10(vector<Vehicle*>& vehicles, map<Vehicle*, string>& laneMap)
-{
-    // 10 vehicles at F10, IDs 1..10
-    struct VDef { int id; const char* type; const char* dest; int arr; std::string lane; };
-    VDef defs[] = {
-        {1,  "ambulance", "F11", 1,  Direction::NORTH},
-        {2,  "firetruck", "F11", 2,  Direction::EAST},
-        {3,  "firetruck", "F11", 3,  Direction::NORTH},
-        {4,  "bike",      "F10", 2,  Direction::WEST},
-        {5,  "car",       "F10", 4,  Direction::SOUTH},
-        {6,  "firetruck", "F11", 5,  Direction::SOUTH},
-        {7,  "bus",       "F11", 6,  Direction::EAST},
-        {8,  "ambulance", "F11", 3,  Direction::SOUTH},
-        {9,  "tractor",   "F10", 7,  Direction::WEST},
-        {10, "car",       "F11", 8,  Direction::NORTH}
-    };
-
-    for (const auto& d : defs) {
-        Vehicle* v = new Vehicle(d.id, d.type, "F10", d.dest, 0, d.arr);
-        vehicles.push_back(v);
-        laneMap[v] = d.lane;
-    }
-}
-
-void createVehiclesForF11(vector<Vehicle*>& vehicles, map<Vehicle*, string>& laneMap)
-{
-    // 10 vehicles at F11, IDs 101..110
-    struct VDef { int id; const char* type; const char* dest; int arr; std::string lane; };
-    VDef defs[] = {
-        {101, "ambulance", "F10", 1,  Direction::SOUTH},
-        {102, "firetruck", "F11", 2,  Direction::EAST},
-        {103, "bike",      "F11", 3,  Direction::WEST},
-        {104, "firetruck", "F10", 2,  Direction::EAST},
-        {105, "firetruck", "F10", 4,  Direction::SOUTH},
-        {106, "firetruck", "F10", 5,  Direction::NORTH},
-        {107, "ambulance", "F11", 6,  Direction::SOUTH},
-        {108, "bus",       "F10", 7,  Direction::WEST},
-        {109, "car",       "F10", 8,  Direction::NORTH},
-        {110, "tractor",   "F11", 9,  Direction::EAST}
-    };
-
-    for (const auto& d : defs) {
-        Vehicle* v = new Vehicle(d.id, d.type, "F11", d.dest, 0, d.arr);
-        vehicles.push_back(v);
-        laneMap[v] = d.lane;
-    }
-}
-
-
-void runControllerProcess(const string &name, int readFd, int writeFd)
-{
-    cout << "\n[" << name << "] Controller process starting." << endl;
-
-    // Each controller process owns a single parking lot matching its intersection name.
-    ParkingLot localLot(name, 10, 15);
-    Intersection intersection(&localLot);
-
-    // Traffic controller for this intersection.
-    TrafficController controller(&intersection, 5); // 3s green duration for demo cycles.
-
-    // Start the controller main loop in its own thread.
-    controller.startController();
-
-    // Start a listener thread for incoming IPC messages from the peer controller.
-    pthread_t listenerTid;
-    {
-        PipeListenerArgs* args = new PipeListenerArgs{ name, readFd };
-        int rc = pthread_create(&listenerTid, nullptr, pipeListenerThread, args);
-        if (rc != 0) {
-            cerr << "[" << name << "] Failed to create pipe listener thread." << endl;
-            delete args;
-        }
-    }
-
-    // Generate vehicles local to this intersection (hard-coded, 10 each).
-    vector<Vehicle*> vehicles;
-    map<Vehicle*, string> laneMap; // Maps each vehicle to its assigned lane direction.
-
-    if (name == "F10") {
-        createVehiclesForF10(vehicles, laneMap);
-    } else {
-        createVehiclesForF11(vehicles, laneMap);
-    }
-
-    // Install per-vehicle requestIntersectionAccess callback.
-    for (Vehicle* v : vehicles) {
-        v->setRequestIntersectionAccessFunction(
-            [&, name](Vehicle* veh) {
-                auto it = laneMap.find(veh);
-                string laneDir = (it != laneMap.end()) ? it->second : Direction::NORTH;
-
-                cout << "[" << name << "] Vehicle " << veh->getId()
-                     << " (" << veh->getType() << ") requesting intersection access via lane "
-                     << laneDir << "." << endl;
-
-                // Enqueue the vehicle into the appropriate lane.
-                intersection.addVehicle(laneDir, veh);
-
-                // Notify peer controller about emergencies moving to the neighboring intersection.
-                if (veh->isEmergency() && veh->getOrigin() != veh->getDestination()) {
-                    ControllerMessage msg{};
-                    msg.vehicleId   = veh->getId();
-                    msg.priority    = veh->getPriority();
-                    msg.isEmergency = veh->isEmergency();
-
-                    strncpy(msg.type, veh->getType().c_str(), sizeof(msg.type) - 1);
-                    strncpy(msg.origin, veh->getOrigin().c_str(), sizeof(msg.origin) - 1);
-                    strncpy(msg.destination, veh->getDestination().c_str(), sizeof(msg.destination) - 1);
-
-                    // Short lane notation for approach (N/S/E/W).
-                    string approachShort;
-                    if (laneDir == Direction::NORTH)      approachShort = "N";
-                    else if (laneDir == Direction::SOUTH) approachShort = "S";
-                    else if (laneDir == Direction::EAST)  approachShort = "E";
-                    else if (laneDir == Direction::WEST)  approachShort = "W";
-                    else                                  approachShort = "N";
-
-                    strncpy(msg.approach, approachShort.c_str(), sizeof(msg.approach) - 1);
-                    // For this driver, treat all as straight movements.
-                    strncpy(msg.movement, "STRAIGHT", sizeof(msg.movement) - 1);
-
-                    cout << "[" << name << "] Notifying peer controller about emergency vehicle "
-                         << msg.vehicleId << " from " << msg.origin << " to "
-                         << msg.destination << "." << endl;
-
-                    TrafficController::sendMessage(writeFd, msg);
-                }
-            }
-        );
-    }
-
-    // Start vehicle threads.
-    cout << "\n[" << name << "] Spawning vehicle threads." << endl;
-    for (Vehicle* v : vehicles) {
-        if (!v->start(localLot, localLot)) {
-            cerr << "[" << name << "] Failed to start thread for vehicle "
-                 << v->getId() << "." << endl;
-        }
-    }
-
-    // Wait for all vehicle threads to finish.
-    for (Vehicle* v : vehicles) {
-        v->wait();
-    }
-    cout << "\n[" << name << "] All vehicle threads have finished." << endl;
-
-    // Print final intersection state at this controller.
-    cout << "\n[" << name << "] Final intersection state:" << endl;
-    intersection.printStatus();
-
-    // Allow some time for the controller to finish serving any remaining vehicles.
-    sleep(5);
-
-    // Stop controller loop and join its thread.
-    controller.stopController();
-
-    // Close our pipe ends to unblock the listener, then join the listener thread.
-    close(readFd);
-    close(writeFd);
-
-    pthread_join(listenerTid, nullptr);
-
-    // Cleanup vehicle objects.
-    for (Vehicle* v : vehicles) {
-        delete v;
-    }
-
-    cout << "\n[" << name << "] Controller process exiting cleanly." << endl;
-}
-
-
-int main()
-{
-    cout << "\n[Main] Starting dual-intersection traffic simulation (F10, F11)." << endl;
-
-    int f10ToF11[2];
-    int f11ToF10[2];
-
-    if (pipe(f10ToF11) == -1 || pipe(f11ToF10) == -1) {
-        perror("pipe");
-        return 1;
-    }
-
-    // Fork controller process for F10.
-    pid_t pidF10 = fork();
-    if (pidF10 == -1) {
-        perror("fork F10");
-        return 1;
-    }
-
-    if (pidF10 == 0) {
-        // Child: F10 controller process.
-        close(f10ToF11[0]); // F10 will write to F11.
-        close(f11ToF10[1]); // F10 will read from F11.
-
-        runControllerProcess("F10", f11ToF10[0], f10ToF11[1]);
-        _exit(0);
-    }
-
-    // Fork controller process for F11.
-    pid_t pidF11 = fork();
-    if (pidF11 == -1) {
-        perror("fork F11");
-        // Best effort: terminate F10 child.
-        kill(pidF10, SIGTERM);
-        return 1;
-    }
-
-    if (pidF11 == 0) {
-        // Child: F11 controller process.
-        close(f10ToF11[1]); // F11 will read from F10.
-        close(f11ToF10[0]); // F11 will write to F10.
-
-        runControllerProcess("F11", f10ToF11[0], f11ToF10[1]);
-        _exit(0);
-    }
-
-    // Parent: close all pipe ends, only children use them.
-    close(f10ToF11[0]);
-    close(f10ToF11[1]);
-    close(f11ToF10[0]);
-    close(f11ToF10[1]);
-
-    cout << "[Main] Controller processes started: F10 PID=" << pidF10
-         << ", F11 PID=" << pidF11 << "." << endl;
-
-    // Wait for both child processes to finish.
-    int status = 0;
-    waitpid(pidF10, &status, 0);
-    cout << "\n[Main] Child process " << pidF10 << " exited with status " << status << "." << endl;
-
-    waitpid(pidF11, &status, 0);
-    cout << "[Main] Child process " << pidF11 << " exited with status " << status << "." << endl;
-
-    cout << "\n[Main] Simulation finished. Exiting." << endl;
-    return 0;
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <signal.h>
+
+#include "Intersection.h"
+#include "TrafficController.h"
+#include "Vehicle.h"
+#include "ParkingLot.h"
+#include "VehicleExecutor.h"
+#include "EventSimulator.h"
+#include "ControllerChannel.h"
+#include "ShmTransport.h"
+#include "RoadNetwork.h"
+#include "NetworkSimulation.h"
+#include "Scenario.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Recording.h"
+#include "Replay.h"
+#include "Columns.h"
+#include "LinkHandoff.h"
+#include "PhasePolicy.h"
+#include "PhasePlan.h"
+
+using namespace std;
+
+// How often the listener wakes to flush outgoing batches and check for
+// shutdown; also the longest an outgoing message waits to be coalesced.
+static const int LISTENER_POLL_MS = 10;
+
+struct PipeListenerArgs {
+    string             controllerName;
+    MessageTransport*  channel;
+    atomic<bool>*      stop;
+    LinkHandoff*       handoff;  // nullptr without links to the peer
+    TrafficController* controller;
+    double             controllerStart; // CLOCK_MONOTONIC seconds at controller time 0
+};
+
+void* pipeListenerThread(void* arg)
+{
+    PipeListenerArgs* args = static_cast<PipeListenerArgs*>(arg);
+    const string& name = args->controllerName;
+    MessageTransport& channel = *args->channel;
+
+    cout << "[" << name << "-Listener] Pipe listener started." << endl;
+
+    vector<ControllerMessage> batch;
+    bool peerClosed = false;
+    while (!args->stop->load()) {
+        // Push out whatever vehicles queued since the last pass, and queue
+        // the ones that have come down the road from the peer.
+        channel.flush();
+        if (args->handoff) {
+            args->handoff->poll();
+        }
+
+        if (peerClosed) {
+            usleep(LISTENER_POLL_MS * 1000);
+            continue;
+        }
+
+        batch.clear();
+        if (channel.receive(batch, LISTENER_POLL_MS) < 0) {
+            peerClosed = true;
+            if (args->handoff) {
+                args->handoff->peerClosed();
+            }
+            continue;
+        }
+
+        for (const ControllerMessage &msg : batch) {
+            if (args->handoff && args->handoff->receive(msg)) {
+                continue;
+            }
+            cout << "[" << name << "-Listener] Received message for vehicle "
+                 << msg.vehicleId
+                 << " (type=" << msg.type << ", emergency=" << (msg.isEmergency ? "yes" : "no")
+                 << ") from " << msg.origin << " to " << msg.destination
+                 << " via approach " << msg.approach
+                 << " movement " << msg.movement << endl;
+
+            // Turn the approach it will arrive on green ahead of it.
+            Direction approach;
+            if (msg.kind == MessageKind::PREEMPT && parseDirection(msg.approach, approach)) {
+                double due = msg.sentAtNs / 1e9 + msg.eta - args->controllerStart;
+                args->controller->requestPreemption(msg.vehicleId, approach, static_cast<long>(due * 1000));
+                cout << "[" << name << "-Listener] Preparing for incoming emergency vehicle "
+                     << msg.vehicleId << ": lane " << directionName(approach) << " turns green "
+                     << TrafficController::PRECLEAR_TIME << " s before it is due in " << msg.eta << " s." << endl;
+            } else if (msg.isEmergency) {
+                cout << "[" << name << "-Listener] Preparing for incoming emergency vehicle "
+                     << msg.vehicleId << "." << endl;
+            }
+        }
+    }
+    channel.flush();
+
+    cout << "[" << name << "-Listener] Pipe listener exiting." << endl;
+    delete args;
+    return nullptr;
+}
+
+
+// Command-line selectable run modes.
+struct SimulationOptions {
+    VehicleExecutionMode executor = VehicleExecutionMode::WORKER_POOL;
+    bool virtualTime = false; // discrete-event mode, no sleeps
+    bool sharedMemory = false; // ShmTransport instead of pipes
+    string scenarioFile = "scenarios/f10_f11.csv"; // vehicles for F10/F11
+    string networkFile;        // run a RoadNetwork instead of F10/F11
+    long duration = 3600;      // simulated seconds for network runs
+    string policy = "fixed";   // signal timing plan, see makePhasePolicy
+    string phases = "single";  // phase set, see PhasePlan::byName
+    LogMode logMode = LogMode::ASYNC;
+    LogFormat logFormat = LogFormat::TEXT;
+    MetricsExport metrics;     // path empty: no metrics
+    string recordFile;         // record each controller process
+    string replayFile;         // replay a recording instead of running
+    string columnsDir;         // column output, see ColumnWriter
+    string linkFile = "networks/f10_f11.net"; // roads between F10 and F11, "none" for none
+    bool preemption = true;    // clear an emergency's approach ahead of it
+};
+
+// Each controller process writes its own file: "m.json" becomes
+// "m.F10.json" for F10.
+static string pathFor(const string &path, const string &name)
+{
+    size_t slash = path.rfind('/');
+    size_t dot = path.rfind('.');
+    if (dot == string::npos || (slash != string::npos && dot < slash)) {
+        return path + "." + name;
+    }
+    return path.substr(0, dot) + "." + name + path.substr(dot);
+}
+
+static MetricsExport metricsFor(const MetricsExport &e, const string &name)
+{
+    MetricsExport out = e;
+    out.path = pathFor(e.path, name);
+    return out;
+}
+
+// Real-time pool runs hand a vehicle to the executor this many seconds
+// before it is due.
+static const double SCENARIO_LOOKAHEAD_S = 1.0;
+
+static double monotonicSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Find the roads from `name` to its peer and back in `roads`. Returns
+// false if `name` has no neighbour it is linked to both ways.
+static bool findPeerLinks(const RoadNetwork &roads, const string &name, RoadLink &outbound, RoadLink &inbound)
+{
+    int self = roads.findNode(name);
+    if (self < 0) {
+        return false;
+    }
+    for (int out : roads.outgoing(self)) {
+        for (int in : roads.outgoing(roads.link(out).to)) {
+            if (roads.link(in).to == self) {
+                outbound = roads.link(out);
+                inbound = roads.link(in);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void runControllerProcess(const string &name, MessageTransport &channel,
+                          const SimulationOptions &options)
+{
+    cout << "\n[" << name << "] Controller process starting." << endl;
+
+    // The writer thread does not survive fork(), so each process starts its own.
+    Log::setFormat(options.logFormat);
+    Log::setMode(options.logMode);
+    if (!options.metrics.path.empty()) {
+        Metrics::setInstance(name);
+        Metrics::startExporter(metricsFor(options.metrics, name));
+    }
+
+    // Each controller process owns a single parking lot matching its intersection name.
+    ParkingLot localLot(name, 10, 15);
+    Intersection intersection(&localLot);
+
+    // Traffic controller for this intersection.
+    const int greenSeconds = 5;
+    TrafficController controller(&intersection, greenSeconds);
+    controller.setPolicy(makePhasePolicy(options.policy, greenSeconds));
+    PhasePlan plan;
+    PhasePlan::byName(options.phases, plan);
+    controller.setPhasePlan(plan);
+
+    if (!options.recordFile.empty() && Recorder::start(pathFor(options.recordFile, name))) {
+        Recorder::controller(name, options.policy, options.phases, greenSeconds);
+    }
+    if (!options.columnsDir.empty()) {
+        ColumnWriter::start(pathFor(options.columnsDir, name));
+    }
+
+    // Vehicles bound for the peer cross over to it on the road between
+    // them. Only in real time: the two processes share no virtual clock.
+    RoadNetwork roads;
+    RoadLink outbound, inbound;
+    unique_ptr<LinkHandoff> handoff;
+    if (options.linkFile != "none") {
+        if (options.virtualTime) {
+            cout << "[" << name << "] Discrete-event runs end each trip at its first intersection; "
+                 << "--network=" << options.linkFile << " moves vehicles over links in virtual time." << endl;
+        } else if (roads.load(options.linkFile) && findPeerLinks(roads, name, outbound, inbound)) {
+            string peer = roads.nodeName(outbound.to);
+            handoff.reset(new LinkHandoff(name, peer, outbound, inbound, channel, intersection, monotonicSeconds()));
+            controller.setDepartureCheck([&handoff](const Vehicle* v) { return handoff->mayDepart(v); });
+            controller.setCrossingCallback([&handoff](Vehicle* v) { handoff->crossed(v); });
+            cout << "[" << name << "] Road to " << peer << ": " << outbound.travelTime << " s, "
+                 << outbound.capacity << " vehicles." << endl;
+        }
+    }
+
+    // Start the controller main loop in its own thread. In virtual time
+    // the EventSimulator steps the controller instead.
+    double controllerStart = monotonicSeconds();
+    if (!options.virtualTime) {
+        controller.startController();
+    }
+
+    // Start a listener thread for incoming IPC messages from the peer controller.
+    atomic<bool> stopListener(false);
+    pthread_t listenerTid;
+    {
+        PipeListenerArgs* args = new PipeListenerArgs{ name, &channel, &stopListener, handoff.get(),
+                                                       &controller, controllerStart };
+        int rc = pthread_create(&listenerTid, nullptr, pipeListenerThread, args);
+        if (rc != 0) {
+            cerr << "[" << name << "] Failed to create pipe listener thread." << endl;
+            delete args;
+        }
+    }
+
+    // Vehicles of this intersection are read from the scenario file and
+    // created only as they become due.
+    ScenarioReader reader;
+    reader.open(options.scenarioFile);
+    ScenarioFeed feed(reader, name);
+
+    // One requestIntersectionAccess callback shared by all vehicles.
+    VehicleHooks hooks;
+    hooks.requestIntersectionAccess = [&, name](Vehicle* veh) {
+        Direction laneDir = veh->getApproach();
+
+        LOG_EVENT(DEBUG, LogEvent::ACCESS_REQUEST, veh, name, directionName(laneDir));
+
+        // Enqueue the vehicle into the appropriate lane.
+        if (handoff) {
+            handoff->expect(veh);
+        }
+        intersection.addVehicle(laneDir, veh);
+
+        // Notify peer controller about emergencies moving to the neighboring intersection.
+        if (veh->isEmergency() && veh->getOrigin() != veh->getDestination()) {
+            ControllerMessage msg{};
+            msg.vehicleId   = veh->getId();
+            msg.priority    = veh->getPriority();
+            msg.isEmergency = veh->isEmergency();
+
+            strncpy(msg.type, veh->getType().c_str(), sizeof(msg.type) - 1);
+            strncpy(msg.origin, veh->getOrigin().c_str(), sizeof(msg.origin) - 1);
+            strncpy(msg.destination, veh->getDestination().c_str(), sizeof(msg.destination) - 1);
+
+            // Short lane notation for approach (N/S/E/W).
+            strncpy(msg.approach, directionShortName(laneDir), sizeof(msg.approach) - 1);
+            strncpy(msg.movement, movementName(veh->getMovement()).c_str(), sizeof(msg.movement) - 1);
+
+            // Over a road, the peer can clear the lane it will arrive on.
+            if (handoff && options.preemption && veh->getDestination() == roads.nodeName(outbound.to)) {
+                msg.kind = MessageKind::PREEMPT;
+                msg.eta = outbound.travelTime;
+                strncpy(msg.approach, directionShortName(outbound.approach), sizeof(msg.approach) - 1);
+            }
+
+            LOG_EVENT(INFO, LogEvent::EMERGENCY_NOTIFY, veh, veh->getOrigin(), veh->getDestination());
+
+            // Queued; the listener flushes batches to the peer.
+            channel.send(msg);
+        }
+    };
+    feed.setVehicleSetup([&](Vehicle* v) {
+        v->setHooks(&hooks);
+    });
+
+    double vehiclesStart = monotonicSeconds();
+    VehicleExecutionMode mode = options.executor;
+
+    if (options.virtualTime) {
+        // Discrete-event run: arrivals, phases, crossings and parking stays
+        // are scheduled events on a virtual clock. Finished vehicles are
+        // freed as the run goes.
+        EventSimulator sim(intersection, controller, &localLot);
+        sim.setSource(&feed);
+        long simulated = sim.run();
+        Log::flush();
+        cout << "\n[" << name << "] Discrete-event run finished: " << simulated
+             << " simulated seconds, " << feed.created() << " vehicles, "
+             << sim.processedEvents() << " events, "
+             << controller.getCrossedCount() << " crossings, wall time "
+             << (monotonicSeconds() - vehiclesStart) << " s." << endl;
+    } else if (mode == VehicleExecutionMode::THREAD_PER_VEHICLE) {
+        // The legacy path sleeps each thread from its own start, so every
+        // vehicle is created and started up front.
+        vector<Vehicle*> vehicles;
+        while (Vehicle* v = feed.takeNext()) {
+            vehicles.push_back(v);
+        }
+
+        // Start vehicle threads.
+        cout << "\n[" << name << "] Spawning " << vehicles.size() << " vehicle threads." << endl;
+        vector<pthread_t> threads;
+        for (Vehicle* v : vehicles) {
+            pthread_t tid;
+            if (v->start(localLot, localLot, tid)) {
+                threads.push_back(tid);
+            } else {
+                cerr << "[" << name << "] Failed to start thread for vehicle "
+                     << v->getId() << "." << endl;
+            }
+        }
+
+        // Wait for all vehicle threads to finish, freeing the vehicles that
+        // are done as we go.
+        for (pthread_t tid : threads) {
+            pthread_join(tid, nullptr);
+            feed.collect();
+        }
+        Log::flush();
+        cout << "\n[" << name << "] All vehicle threads have finished." << endl;
+    } else {
+        // Drive vehicles as tasks on a fixed worker pool, submitting each
+        // one shortly before it is due. Vehicles that have crossed and
+        // finished their tasks are freed between submits, so only the ones
+        // in flight stay allocated.
+        VehicleExecutor executor;
+        executor.start();
+        cout << "\n[" << name << "] Running vehicles on " << executor.workerCount()
+             << " executor worker(s)." << endl;
+
+        long arrival;
+        while ((arrival = feed.nextArrival()) >= 0) {
+            double wait = arrival - SCENARIO_LOOKAHEAD_S - (monotonicSeconds() - vehiclesStart);
+            if (wait > 0) {
+                usleep(static_cast<useconds_t>(wait * 1e6));
+            }
+            feed.collect();
+            executor.submit(feed.takeNext(), localLot, localLot);
+        }
+        executor.waitAll();
+        executor.stop();
+        Log::flush();
+        cout << "\n[" << name << "] All " << feed.created() << " vehicle tasks have finished." << endl;
+    }
+
+    if (!options.virtualTime) {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        cout << "[" << name << "] Vehicle execution ("
+             << (mode == VehicleExecutionMode::THREAD_PER_VEHICLE ? "thread-per-vehicle" : "worker-pool")
+             << "): wall time " << (monotonicSeconds() - vehiclesStart) << " s, peak RSS "
+             << usage.ru_maxrss << " KB." << endl;
+    }
+
+    if (handoff) {
+        if (!handoff->drain(LISTENER_POLL_MS)) {
+            cout << "[" << name << "] Roads to " << roads.nodeName(outbound.to) << " locked up; stopping with vehicles still held." << endl;
+        }
+        Log::flush();
+        cout << "[" << name << "] Links: " << handoff->handedOff() << " vehicles handed off to the peer, "
+             << handoff->taken() << " taken over from it, " << controller.getHeldCount()
+             << " releases held for a full road." << endl;
+    }
+
+    ParkingStats parking = localLot.stats();
+    Log::flush();
+    cout << "[" << name << "] Parking: " << parking.spotsAcquired << " parked, "
+         << parking.turnedAway << " turned away (waiting area full), " << parking.spotMisses
+         << " gave up waiting, peak " << parking.peakParked << "/" << localLot.getParkingCapacity()
+         << " spots and " << parking.peakWaiting << "/" << localLot.getWaitingCapacity()
+         << " waiting." << endl;
+
+    // Print final intersection state at this controller.
+    cout << "\n[" << name << "] Final intersection state:" << endl;
+    intersection.printStatus();
+
+    if (!options.virtualTime) {
+        // Allow some time for the controller to finish serving any remaining vehicles.
+        sleep(5);
+
+        // Stop controller loop and join its thread.
+        controller.stopController();
+    }
+
+    // Stop the listener (it flushes pending messages on the way out), then
+    // tell the peer we are done sending.
+    stopListener = true;
+    pthread_join(listenerTid, nullptr);
+    channel.closeSend();
+
+    // Stop the log writer thread; this writes out anything still buffered.
+    Log::setMode(LogMode::SYNC);
+    Metrics::stopExporter();
+    if (Recorder::enabled()) {
+        Recorder::stop();
+        cout << "[" << name << "] Recorded " << Recorder::records() << " events in "
+             << Recorder::bytes() << " bytes to " << pathFor(options.recordFile, name) << "." << endl;
+    }
+    if (ColumnWriter::enabled()) {
+        ColumnWriter::stop();
+        cout << "[" << name << "] Wrote " << ColumnWriter::rows() << " event rows to "
+             << pathFor(options.columnsDir, name) << "/." << endl;
+    }
+
+    // The feed deletes the vehicle objects when it goes out of scope.
+    cout << "\n[" << name << "] Controller process exiting cleanly." << endl;
+}
+
+// Network mode: one controller per node of a RoadNetwork file, packed onto
+// worker threads and run in virtual time with synthetic traffic.
+int runNetwork(const SimulationOptions &options)
+{
+    RoadNetwork network;
+    if (!network.load(options.networkFile)) {
+        return 1;
+    }
+    cout << "\n[Main] Network " << options.networkFile << ": " << network.nodeCount()
+         << " intersections, " << network.linkCount() << " links." << endl;
+
+    Log::setFormat(options.logFormat);
+    Log::setMode(options.logMode);
+    if (!options.metrics.path.empty()) {
+        Metrics::setInstance("network");
+        Metrics::startExporter(options.metrics);
+    }
+    if (!options.columnsDir.empty()) {
+        ColumnWriter::start(options.columnsDir);
+    }
+    NetworkSimulation sim(network);
+    sim.setPhasePolicy(options.policy);
+    sim.setPhasePlan(options.phases);
+    sim.setPreemption(options.preemption);
+    sim.generateTraffic(options.duration, 60.0, 42);
+
+    double start = monotonicSeconds();
+    sim.run(options.duration);
+    double wall = monotonicSeconds() - start;
+
+    Log::setMode(LogMode::SYNC);
+    Metrics::stopExporter();
+    cout << "\n[Main] Network run finished: " << options.duration << " simulated seconds, "
+         << sim.vehicleCount() << " vehicles, " << sim.crossings() << " crossings, "
+         << sim.messagesForwarded() << " message hops, " << sim.messagesDelivered()
+         << " messages delivered, " << sim.parkingRedirects()
+         << " vehicles redirected to another lot, wall time " << wall << " s." << endl;
+    cout << "[Main] " << sim.handoffs() << " hand-offs between intersections, " << sim.tripsCompleted()
+         << " trips completed (mean " << sim.meanTripSeconds() << " s over " << sim.meanTripHops()
+         << " links), " << sim.spillbackHolds() << " releases held for a full link." << endl;
+    cout << "[Main] " << sim.emergencyTripsCompleted() << " emergency trips (mean "
+         << sim.meanEmergencyTripSeconds() << " s), " << sim.preemptions()
+         << " greens opened ahead of them." << endl;
+    if (ColumnWriter::enabled()) {
+        ColumnWriter::stop();
+        cout << "[Main] Wrote " << ColumnWriter::rows() << " event rows to " << options.columnsDir << "/." << endl;
+    }
+    return 0;
+}
+
+// Replay mode: re-drive one controller from a recording, at full speed.
+int runReplay(const SimulationOptions &options)
+{
+    RecordingReader reader;
+    if (!reader.open(options.replayFile)) {
+        return 1;
+    }
+    Log::setFormat(options.logFormat);
+    Log::setMode(options.logMode);
+
+    ReplayResult result;
+    bool matched = replayRecording(reader, result);
+
+    Log::setMode(LogMode::SYNC);
+    cout << "\n[Main] Replay of " << options.replayFile << ": " << result.records << " records, "
+         << result.arrivals << " arrivals, " << result.steps << " decisions, " << result.crossings
+         << " crossings, " << result.mismatches << " decisions differ from the recording, wall time "
+         << result.wallSeconds << " s (" << result.steps / result.wallSeconds << " decisions/s)." << endl;
+    if (!result.complete) {
+        cout << "[Main] The recording ends in a partial record." << endl;
+    }
+    return matched ? 0 : 1;
+}
+
+// Child-side setup: wrap this controller's ends of the pipes or shared
+// memory rings in the selected transport, then run the controller.
+void runControllerChild(const string &name, int readFd, int writeFd,
+                        ShmRing* rxRing, ShmRing* txRing,
+                        const SimulationOptions &options)
+{
+    if (options.sharedMemory) {
+        close(readFd);
+        close(writeFd);
+        ShmTransport transport(rxRing, txRing);
+        runControllerProcess(name, transport, options);
+    } else {
+        ControllerChannel transport(readFd, writeFd);
+        runControllerProcess(name, transport, options); // closes writeFd
+        close(readFd);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    // --executor=thread runs the legacy thread-per-vehicle path,
+    // --executor=pool (default) uses VehicleExecutor.
+    // --mode=des runs in virtual time instead of wall-clock time.
+    // --transport=shm uses shared-memory rings instead of pipes.
+    // --log=async (default) writes event logs from a background thread,
+    // --log=sync formats and flushes each one in place, --log=off drops them.
+    // --policy=actuated|max-pressure replaces the fixed-time signal plan.
+    // --phases=compatible gives non-conflicting movements green together.
+    // --scenario=FILE reads the F10/F11 vehicles from FILE.
+    // --network=FILE runs every intersection of a RoadNetwork in virtual time.
+    // --metrics=FILE or --metrics=unix:PATH exports counters and histograms
+    // every --metrics-interval=MS (default 1000) as --metrics-format=json
+    // (default) or prometheus; each controller process adds its name.
+    // --record=FILE records each controller process to its own file and
+    // --replay=FILE re-drives a controller from one.
+    // --columns=DIR writes arrivals, crossings and parking events as
+    // columns for ./analyze; each controller process adds its name.
+    // --links=FILE (default networks/f10_f11.net) gives the roads over
+    // which real-time F10/F11 vehicles cross to the peer; none turns it off.
+    // --preemption=off stops controllers clearing the approach of an
+    // emergency vehicle announced by a neighbour before it arrives.
+    SimulationOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--executor=thread") {
+            options.executor = VehicleExecutionMode::THREAD_PER_VEHICLE;
+        } else if (arg == "--executor=pool") {
+            options.executor = VehicleExecutionMode::WORKER_POOL;
+        } else if (arg == "--mode=des") {
+            options.virtualTime = true;
+        } else if (arg == "--mode=realtime") {
+            options.virtualTime = false;
+        } else if (arg == "--transport=shm") {
+            options.sharedMemory = true;
+        } else if (arg == "--transport=pipe") {
+            options.sharedMemory = false;
+        } else if (arg == "--log=async") {
+            options.logMode = LogMode::ASYNC;
+        } else if (arg == "--log=sync") {
+            options.logMode = LogMode::SYNC;
+        } else if (arg == "--log=off") {
+            options.logMode = LogMode::OFF;
+        } else if (arg == "--log-format=text") {
+            options.logFormat = LogFormat::TEXT;
+        } else if (arg == "--log-format=fields") {
+            options.logFormat = LogFormat::FIELDS;
+        } else if (arg.compare(0, 9, "--policy=") == 0 && makePhasePolicy(arg.substr(9))) {
+            options.policy = arg.substr(9);
+        } else if (arg == "--phases=single" || arg == "--phases=compatible") {
+            options.phases = arg.substr(9);
+        } else if (arg.compare(0, 11, "--scenario=") == 0) {
+            options.scenarioFile = arg.substr(11);
+        } else if (arg.compare(0, 10, "--network=") == 0) {
+            options.networkFile = arg.substr(10);
+        } else if (arg.compare(0, 11, "--duration=") == 0) {
+            options.duration = atol(arg.c_str() + 11);
+        } else if (arg.compare(0, 15, "--metrics=unix:") == 0 && arg.size() > 15) {
+            options.metrics.path = arg.substr(15);
+            options.metrics.unixSocket = true;
+        } else if (arg.compare(0, 10, "--metrics=") == 0 && arg.size() > 10) {
+            options.metrics.path = arg.substr(10);
+            options.metrics.unixSocket = false;
+        } else if (arg == "--metrics-format=json") {
+            options.metrics.format = MetricsFormat::JSON;
+        } else if (arg == "--metrics-format=prometheus") {
+            options.metrics.format = MetricsFormat::PROMETHEUS;
+        } else if (arg.compare(0, 19, "--metrics-interval=") == 0 && atoi(arg.c_str() + 19) > 0) {
+            options.metrics.intervalMs = atoi(arg.c_str() + 19);
+        } else if (arg.compare(0, 9, "--record=") == 0 && arg.size() > 9) {
+            options.recordFile = arg.substr(9);
+        } else if (arg.compare(0, 9, "--replay=") == 0 && arg.size() > 9) {
+            options.replayFile = arg.substr(9);
+        } else if (arg.compare(0, 10, "--columns=") == 0 && arg.size() > 10) {
+            options.columnsDir = arg.substr(10);
+        } else if (arg.compare(0, 8, "--links=") == 0 && arg.size() > 8) {
+            options.linkFile = arg.substr(8);
+        } else if (arg == "--preemption=on" || arg == "--preemption=off") {
+            options.preemption = arg == "--preemption=on";
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--executor=thread|pool] [--mode=realtime|des] [--transport=pipe|shm]"
+                 << " [--policy=fixed|actuated|max-pressure] [--phases=single|compatible]"
+                 << " [--scenario=FILE] [--log=async|sync|off] [--log-format=text|fields]"
+                 << " [--network=FILE [--duration=SECONDS]]"
+                 << " [--metrics=FILE|unix:PATH [--metrics-format=json|prometheus] [--metrics-interval=MS]]"
+                 << " [--record=FILE] [--replay=FILE] [--columns=DIR] [--links=FILE|none]"
+                 << " [--preemption=on|off]" << endl;
+            return 1;
+        }
+    }
+
+    if (!options.replayFile.empty()) {
+        return runReplay(options);
+    }
+    if (!options.networkFile.empty()) {
+        if (!options.recordFile.empty()) {
+            cout << "[Main] --record applies to the F10/F11 controller processes; ignored for --network." << endl;
+        }
+        return runNetwork(options);
+    }
+
+    cout << "\n[Main] Starting dual-intersection traffic simulation (F10, F11)." << endl;
+
+    // A controller that finishes first closes its pipe ends; the peer's
+    // next write should fail, not kill the process.
+    signal(SIGPIPE, SIG_IGN);
+
+    int f10ToF11[2];
+    int f11ToF10[2];
+
+    if (pipe(f10ToF11) == -1 || pipe(f11ToF10) == -1) {
+        perror("pipe");
+        return 1;
+    }
+
+    // Rings must exist before fork() so both children inherit the mapping.
+    ShmRing* f10ToF11Ring = nullptr;
+    ShmRing* f11ToF10Ring = nullptr;
+    if (options.sharedMemory) {
+        f10ToF11Ring = ShmRing::create(1024);
+        f11ToF10Ring = ShmRing::create(1024);
+        if (!f10ToF11Ring || !f11ToF10Ring) {
+            return 1;
+        }
+    }
+
+    // Fork controller process for F10.
+    pid_t pidF10 = fork();
+    if (pidF10 == -1) {
+        perror("fork F10");
+        return 1;
+    }
+
+    if (pidF10 == 0) {
+        // Child: F10 controller process.
+        close(f10ToF11[0]); // F10 will write to F11.
+        close(f11ToF10[1]); // F10 will read from F11.
+
+        runControllerChild("F10", f11ToF10[0], f10ToF11[1], f11ToF10Ring, f10ToF11Ring, options);
+        _exit(0);
+    }
+
+    // Fork controller process for F11.
+    pid_t pidF11 = fork();
+    if (pidF11 == -1) {
+        perror("fork F11");
+        // Best effort: terminate F10 child.
+        kill(pidF10, SIGTERM);
+        return 1;
+    }
+
+    if (pidF11 == 0) {
+        // Child: F11 controller process.
+        close(f10ToF11[1]); // F11 will read from F10.
+        close(f11ToF10[0]); // F11 will write to F10.
+
+        runControllerChild("F11", f10ToF11[0], f11ToF10[1], f10ToF11Ring, f11ToF10Ring, options);
+        _exit(0);
+    }
+
+    // Parent: close all pipe ends, only children use them.
+    close(f10ToF11[0]);
+    close(f10ToF11[1]);
+    close(f11ToF10[0]);
+    close(f11ToF10[1]);
+
+    cout << "[Main] Controller processes started: F10 PID=" << pidF10
+         << ", F11 PID=" << pidF11 << "." << endl;
+
+    // Wait for both child processes to finish.
+    int status = 0;
+    waitpid(pidF10, &status, 0);
+    cout << "\n[Main] Child process " << pidF10 << " exited with status " << status << "." << endl;
+
+    waitpid(pidF11, &status, 0);
+    cout << "[Main] Child process " << pidF11 << " exited with status " << status << "." << endl;
+
+    delete f10ToF11Ring;
+    delete f11ToF10Ring;
+
+    cout << "\n[Main] Simulation finished. Exiting." << endl;
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cctype>
+
+#include "Scenario.h"
+
+using namespace std;
+
+// Synthetic scenario generator: Poisson arrivals on every approach of every
+// origin, written as a scenario file for main_sim --scenario=FILE.
+//
+// Usage: ./scenario_gen [--duration=S] [--rate=VEH_PER_HOUR] [--origins=F10,F11]
+//                       [--mix=car:60,bus:10,...] [--turns=straight:70,left:15,right:15]
+//                       [--seed=N] [--out=FILE]
+
+static vector<string> splitList(const string &s) {
+    vector<string> items;
+    istringstream in(s);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char* argv[])
+{
+    TraceOptions options;
+    string outFile;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.compare(0, 11, "--duration=") == 0) {
+            options.duration = atol(arg.c_str() + 11);
+        } else if (arg.compare(0, 7, "--rate=") == 0) {
+            options.vehiclesPerHour = atof(arg.c_str() + 7);
+        } else if (arg.compare(0, 10, "--origins=") == 0) {
+            options.origins = splitList(arg.substr(10));
+        } else if (arg.compare(0, 6, "--mix=") == 0) {
+            options.mix.clear();
+            for (const string &item : splitList(arg.substr(6))) {
+                size_t colon = item.find(':');
+                double weight = colon == string::npos ? 1.0 : atof(item.c_str() + colon + 1);
+                options.mix.push_back(make_pair(item.substr(0, colon), weight));
+            }
+        } else if (arg.compare(0, 8, "--turns=") == 0) {
+            options.turns.clear();
+            for (const string &item : splitList(arg.substr(8))) {
+                size_t colon = item.find(':');
+                string name = item.substr(0, colon);
+                for (char &c : name) {
+                    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+                }
+                Movement m;
+                if (!parseMovement(name, m)) {
+                    cerr << "scenario_gen: unknown movement '" << item.substr(0, colon) << "'" << endl;
+                    return 1;
+                }
+                double weight = colon == string::npos ? 1.0 : atof(item.c_str() + colon + 1);
+                options.turns.push_back(make_pair(m, weight));
+            }
+        } else if (arg.compare(0, 7, "--seed=") == 0) {
+            options.seed = static_cast<unsigned>(strtoul(arg.c_str() + 7, nullptr, 10));
+        } else if (arg.compare(0, 6, "--out=") == 0) {
+            outFile = arg.substr(6);
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--duration=S] [--rate=VEH_PER_HOUR] [--origins=F10,F11]"
+                 << " [--mix=car:60,bus:10,...] [--turns=straight:70,left:15,right:15]"
+                 << " [--seed=N] [--out=FILE]" << endl;
+            return 1;
+        }
+    }
+
+    if (options.origins.empty() || options.mix.empty() ||
+        options.vehiclesPerHour <= 0 || options.duration <= 0) {
+        cerr << "scenario_gen: need a positive duration and rate, at least one origin and one type" << endl;
+        return 1;
+    }
+
+    unsigned long written;
+    if (outFile.empty()) {
+        written = writeSyntheticTrace(cout, options);
+    } else {
+        ofstream out(outFile);
+        if (!out) {
+            cerr << "scenario_gen: cannot write " << outFile << endl;
+            return 1;
+        }
+        written = writeSyntheticTrace(out, options);
+    }
+
+    cerr << "scenario_gen: " << written << " vehicles over " << options.duration
+         << " s, seed " << options.seed << endl;
+    return 0;
+}